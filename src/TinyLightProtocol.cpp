@@ -67,6 +67,22 @@ int Light::write(const IPacket &pkt)
     return tiny_light_send(&m_data, pkt.m_buf, pkt.m_len) > 0;
 }
 
+int Light::put(const IPacket &pkt)
+{
+    return tiny_light_put(&m_data, pkt.m_buf, pkt.m_len);
+}
+
+int Light::runTx()
+{
+    return tiny_light_run_tx(&m_data);
+}
+
+void Light::setTxBuffer(void *buf, int size)
+{
+    m_data.tx_buf = (uint8_t *)buf;
+    m_data.tx_buf_size = size;
+}
+
 int Light::read(IPacket &pkt)
 {
     int len = tiny_light_read(&m_data, pkt.m_buf, pkt.m_size);
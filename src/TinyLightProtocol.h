@@ -160,6 +160,30 @@ public:
      */
     int write(const IPacket &pkt);
 
+    /**
+     * Starts sending of the packet without blocking. The packet must remain valid
+     * until runTx() returns TINY_SUCCESS.
+     * @param pkt - Packet to send
+     * @return TINY_SUCCESS if packet is sent, TINY_ERR_AGAIN if the rest must be sent by runTx(),
+     *         TINY_ERR_BUSY if previous packet is not sent yet, or other error code
+     */
+    int put(const IPacket &pkt);
+
+    /**
+     * Continues sending of the packet, started by put(). The method never waits for the channel.
+     * @return TINY_SUCCESS if nothing is left to send, TINY_ERR_AGAIN if the channel is busy,
+     *         or other error code
+     */
+    int runTx();
+
+    /**
+     * Sets output buffer for encoded frames. Must be called before begin().
+     * If the buffer can hold the whole encoded frame, it is written to the channel by single call.
+     * @param buf - buffer for encoded data
+     * @param size - size of the buffer in bytes
+     */
+    void setTxBuffer(void *buf, int size);
+
     /**
      * Reads packet from communication channel.
      * @param pkt - Packet object to put data to
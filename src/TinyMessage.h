@@ -0,0 +1,582 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+/**
+ This is compile-time message schema on top of IPacket. Requires C++17.
+
+ @file
+ @brief Tiny protocol message schema
+*/
+
+#pragma once
+
+#include "TinyPacket.h"
+
+#include <algorithm>
+#include <array>
+#include <stdint.h>
+#include <string.h>
+#include <tuple>
+#include <type_traits>
+
+namespace tinyproto
+{
+
+/**
+ * @defgroup MESSAGE_API Message schema API
+ * @{
+ *
+ * Message schema describes, which fields of the structure are transferred and in which order:
+ *
+ * @code{.cpp}
+ * struct Telemetry
+ * {
+ *     uint16_t sensor;
+ *     float value;
+ * };
+ * using TelemetryMsg = tinyproto::Message<Telemetry, 0x10, &Telemetry::sensor, &Telemetry::value>;
+ *
+ * TelemetryMsg::Packet packet;
+ * TelemetryMsg::encode(Telemetry{1, 20.5f}, packet);
+ * @endcode
+ *
+ * Encoded message is message ID followed by fields at fixed offsets, all values are little-endian.
+ * Field can be of arithmetic or enum type, or an array of them. Message size is known at compile time.
+ * If the structure has no padding, and fields are listed in declaration order, the message is
+ * encoded and decoded by single memcpy on little-endian hosts.
+ */
+
+/**
+ * Encodes and decodes single field at fixed offset
+ */
+template <typename F> struct MessageField
+{
+    static_assert(std::is_arithmetic<F>::value || std::is_enum<F>::value, "Unsupported message field type");
+
+    /** Size of the field in encoded message */
+    static constexpr int SIZE = sizeof(F);
+
+    /** Field can be copied as is on little-endian hosts */
+    static constexpr bool FLAT = true;
+
+    static void write(uint8_t *dst, const F &value)
+    {
+#if TINY_PACKET_LITTLE_ENDIAN == 1
+        memcpy(dst, &value, sizeof(F));
+#else
+        Raw raw;
+        memcpy(&raw, &value, sizeof(F));
+        for ( unsigned i = 0; i < sizeof(F); i++ )
+        {
+            dst[i] = static_cast<uint8_t>(raw >> (8 * i));
+        }
+#endif
+    }
+
+    static void read(const uint8_t *src, F &value)
+    {
+#if TINY_PACKET_LITTLE_ENDIAN == 1
+        memcpy(&value, src, sizeof(F));
+#else
+        Raw raw = 0;
+        for ( unsigned i = 0; i < sizeof(F); i++ )
+        {
+            raw |= static_cast<Raw>(src[i]) << (8 * i);
+        }
+        memcpy(&value, &raw, sizeof(F));
+#endif
+    }
+
+private:
+    using Raw = typename std::conditional<
+        sizeof(F) == 1, uint8_t,
+        typename std::conditional<sizeof(F) == 2, uint16_t,
+                                  typename std::conditional<sizeof(F) == 4, uint32_t, uint64_t>::type>::type>::type;
+};
+
+template <typename F, size_t N> struct MessageField<F[N]>
+{
+    static constexpr int SIZE = static_cast<int>(N) * MessageField<F>::SIZE;
+
+    static constexpr bool FLAT = MessageField<F>::FLAT;
+
+    static void write(uint8_t *dst, const F (&value)[N])
+    {
+        for ( size_t i = 0; i < N; i++ )
+        {
+            MessageField<F>::write(dst + i * MessageField<F>::SIZE, value[i]);
+        }
+    }
+
+    static void read(const uint8_t *src, F (&value)[N])
+    {
+        for ( size_t i = 0; i < N; i++ )
+        {
+            MessageField<F>::read(src + i * MessageField<F>::SIZE, value[i]);
+        }
+    }
+};
+
+/**
+ * Reads message ID at current read position of the packet without moving the position.
+ * @return false if there is not enough data in the packet
+ */
+template <typename IdType> bool peekMessageId(const IPacket &packet, IdType &id)
+{
+    if ( static_cast<int>(packet.availableBytes()) < MessageField<IdType>::SIZE )
+    {
+        return false;
+    }
+    MessageField<IdType>::read(reinterpret_cast<const uint8_t *>(packet.data()) + packet.size() - packet.availableBytes(),
+                               id);
+    return true;
+}
+
+/** Provides structure and field types of pointer to member */
+template <typename> struct MessageMember;
+
+template <typename C, typename F> struct MessageMember<F C::*>
+{
+    using Class = C;
+    using Field = MessageField<F>;
+};
+
+/**
+ * Message schema: message structure T, message ID of IdType type, and list of transferred fields.
+ * @tparam T message structure
+ * @tparam IdType type of message ID, defines size of message ID in the packet
+ * @tparam ID message ID
+ * @tparam Fields pointers to transferred members of T
+ */
+template <typename T, typename IdType, IdType ID, auto... Fields> class MessageEx
+{
+    static_assert(sizeof...(Fields) > 0, "Message must have at least one field");
+    static_assert((std::is_same<typename MessageMember<decltype(Fields)>::Class, T>::value && ...),
+                  "All fields must be members of message structure");
+
+public:
+    /** Message structure */
+    using Type = T;
+
+    /** Type of message ID */
+    using Id = IdType;
+
+    /** Message ID */
+    static constexpr IdType MESSAGE_ID = ID;
+
+    /** Size of message ID in the packet */
+    static constexpr int ID_SIZE = MessageField<IdType>::SIZE;
+
+    /** Size of encoded message including message ID */
+    static constexpr int SIZE = ID_SIZE + (MessageMember<decltype(Fields)>::Field::SIZE + ...);
+
+    /** Packet, which fits the message exactly */
+    using Packet = StaticPacket<SIZE>;
+
+    /**
+     * Appends encoded message to the packet.
+     * @param message message to encode
+     * @param packet packet to put the message to
+     * @return false if there is no room in the packet, nothing is put in this case
+     */
+    static bool encode(const T &message, IPacket &packet)
+    {
+        if ( packet.maxSize() - packet.size() < SIZE )
+        {
+            return false;
+        }
+        uint8_t *dst = reinterpret_cast<uint8_t *>(packet.data()) + packet.size();
+        MessageField<IdType>::write(dst, ID);
+        if ( isFlat(message) )
+        {
+            memcpy(dst + ID_SIZE, &message, sizeof(T));
+        }
+        else
+        {
+            int offset = ID_SIZE;
+            ((MessageMember<decltype(Fields)>::Field::write(dst + offset, message.*Fields),
+              offset += MessageMember<decltype(Fields)>::Field::SIZE),
+             ...);
+        }
+        packet.allocate(SIZE);
+        return true;
+    }
+
+    /**
+     * Returns true if not yet read part of the packet starts with this message
+     */
+    static bool matches(const IPacket &packet)
+    {
+        if ( static_cast<int>(packet.availableBytes()) < SIZE )
+        {
+            return false;
+        }
+        IdType id;
+        MessageField<IdType>::read(position(packet), id);
+        return id == ID;
+    }
+
+    /**
+     * Reads the message from the packet.
+     * @param packet packet to read the message from
+     * @param message message structure to fill
+     * @return false if the packet doesn't contain this message, nothing is read in this case
+     */
+    static bool decode(IPacket &packet, T &message)
+    {
+        if ( !matches(packet) )
+        {
+            return false;
+        }
+        const uint8_t *src = position(packet) + ID_SIZE;
+        if ( isFlat(message) )
+        {
+            memcpy(&message, src, sizeof(T));
+        }
+        else
+        {
+            int offset = 0;
+            ((MessageMember<decltype(Fields)>::Field::read(src + offset, message.*Fields),
+              offset += MessageMember<decltype(Fields)>::Field::SIZE),
+             ...);
+        }
+        packet.skip(SIZE);
+        return true;
+    }
+
+private:
+    static const uint8_t *position(const IPacket &packet)
+    {
+        return reinterpret_cast<const uint8_t *>(packet.data()) + packet.size() - packet.availableBytes();
+    }
+
+    /**
+     * Returns true if message layout in memory matches the encoded one. Member offsets are
+     * constants, so the check is folded by the compiler.
+     */
+    static bool isFlat(const T &message)
+    {
+#if TINY_PACKET_LITTLE_ENDIAN == 1
+        if constexpr ( std::is_trivially_copyable<T>::value && SIZE - ID_SIZE == static_cast<int>(sizeof(T)) &&
+                       (MessageMember<decltype(Fields)>::Field::FLAT && ...) )
+        {
+            const uint8_t *base = reinterpret_cast<const uint8_t *>(&message);
+            int expected = 0;
+            bool flat = true;
+            ((flat = flat && reinterpret_cast<const uint8_t *>(&(message.*Fields)) - base == expected,
+              expected += MessageMember<decltype(Fields)>::Field::SIZE),
+             ...);
+            return flat;
+        }
+#endif
+        (void)message;
+        return false;
+    }
+};
+
+/**
+ * Message schema with 1-byte message ID
+ */
+template <typename T, uint8_t ID, auto... Fields> using Message = MessageEx<T, uint8_t, ID, Fields...>;
+
+/**
+ * Encodes the message and sends it via Proto::send() or any other object with the same method.
+ * @param proto protocol to send message via
+ * @param message message to send
+ * @param timeout timeout in milliseconds
+ * @return result of send() call
+ */
+template <typename M, typename P> bool sendMessage(P &proto, const typename M::Type &message, uint32_t timeout)
+{
+    typename M::Packet packet;
+    M::encode(message, packet);
+    return proto.send(packet, timeout);
+}
+
+/**
+ * Set of messages, which can be received over the link. Use it in Proto Rx callback
+ * to decode the message by its ID:
+ *
+ * @code{.cpp}
+ * proto.setRxCallback([](tinyproto::Proto &, tinyproto::IPacket &packet) {
+ *     tinyproto::MessageSet<TelemetryMsg, CommandMsg>::dispatch(packet, Handler{});
+ * });
+ * @endcode
+ *
+ * Dispatch uses dense jump table indexed by message ID, which is built at compile time,
+ * so IDs of the set must be close to each other.
+ */
+template <typename... M> class MessageSet
+{
+    using First = typename std::tuple_element<0, std::tuple<M...>>::type;
+
+public:
+    /** Type of message ID */
+    using Id = typename First::Id;
+
+    static_assert((std::is_same<typename M::Id, Id>::value && ...), "All messages must have the same ID type");
+
+    /** Smallest message ID in the set */
+    static constexpr Id MIN_ID = std::min({M::MESSAGE_ID...});
+
+    /** Number of entries in jump table */
+    static constexpr int RANGE = static_cast<int>(std::max({M::MESSAGE_ID...}) - MIN_ID) + 1;
+
+    static_assert(RANGE <= 256, "Message IDs are too sparse for jump table, use MessageDispatcher");
+
+    /**
+     * Decodes message from the packet and passes it to handler(const M::Type &).
+     * @param packet received packet
+     * @param handler callable object with overloads for all message types
+     * @return false if the packet doesn't contain any message from the set
+     */
+    template <typename Handler> static bool dispatch(IPacket &packet, Handler &&handler)
+    {
+        using Table = JumpTable<typename std::remove_reference<Handler>::type>;
+        Id id;
+        if ( !peekMessageId(packet, id) || id < MIN_ID || static_cast<int>(id - MIN_ID) >= RANGE )
+        {
+            return false;
+        }
+        auto decode = Table::TABLE[static_cast<int>(id - MIN_ID)];
+        return decode != nullptr && decode(packet, handler);
+    }
+
+private:
+    static constexpr bool hasUniqueIds()
+    {
+        std::array<int, RANGE> count{};
+        ((count[static_cast<int>(M::MESSAGE_ID - MIN_ID)]++), ...);
+        for ( int i = 0; i < RANGE; i++ )
+        {
+            if ( count[i] > 1 )
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(hasUniqueIds(), "Message IDs in the set must be unique");
+
+    template <typename Handler> struct JumpTable
+    {
+        using Decode = bool (*)(IPacket &, Handler &);
+
+        static constexpr std::array<Decode, RANGE> build()
+        {
+            std::array<Decode, RANGE> table{};
+            ((table[static_cast<int>(M::MESSAGE_ID - MIN_ID)] = &decodeAs<M, Handler>), ...);
+            return table;
+        }
+
+        static constexpr std::array<Decode, RANGE> TABLE = build();
+    };
+
+    template <typename Msg, typename Handler> static bool decodeAs(IPacket &packet, Handler &handler)
+    {
+        typename Msg::Type message;
+        if ( !Msg::decode(packet, message) )
+        {
+            return false;
+        }
+        handler(static_cast<const typename Msg::Type &>(message));
+        return true;
+    }
+};
+
+/**
+ * Runtime registry of message handlers. Handlers are stored in dense jump table indexed by
+ * message ID, so dispatch costs single table lookup regardless of number of messages.
+ * The table is allocated statically and covers IDs from base to base + SIZE - 1.
+ *
+ * @code{.cpp}
+ * tinyproto::MessageDispatcher<> dispatcher;
+ * dispatcher.on<TelemetryMsg>(onTelemetry, &app);
+ * proto.setUserData(&dispatcher);
+ * proto.setRxCallback(tinyproto::MessageDispatcher<>::onRx);
+ * @endcode
+ *
+ * @tparam IdType type of message ID, defines size of message ID in the packet
+ * @tparam SIZE number of entries in jump table
+ */
+template <typename IdType = uint8_t, int SIZE = 256> class MessageDispatcher
+{
+public:
+    /**
+     * Creates dispatcher without handlers.
+     * @param base smallest message ID, which can be registered
+     */
+    explicit MessageDispatcher(IdType base = 0)
+        : m_base(base)
+    {
+    }
+
+    /**
+     * Registers handler for message ID. Handler gets the packet with read position right after message ID.
+     * @param id message ID
+     * @param handler handler to call, nullptr removes registered handler
+     * @param userData user data to pass to the handler
+     * @return false if message ID is out of table range
+     */
+    bool on(IdType id, void (*handler)(void *userData, IPacket &packet), void *userData = nullptr)
+    {
+        return setEntry(id, handler ? &invokeRaw : nullptr, reinterpret_cast<void (*)()>(handler), userData);
+    }
+
+    /**
+     * Registers typed handler for message schema M, see MessageEx.
+     * @param handler handler to call with decoded message, nullptr removes registered handler
+     * @param userData user data to pass to the handler
+     * @return false if message ID is out of table range
+     */
+    template <typename M> bool on(void (*handler)(void *userData, const typename M::Type &message), void *userData = nullptr)
+    {
+        static_assert(std::is_same<typename M::Id, IdType>::value, "Message ID type must match dispatcher one");
+        return setEntry(M::MESSAGE_ID, handler ? &invokeTyped<M> : nullptr, reinterpret_cast<void (*)()>(handler),
+                        userData);
+    }
+
+    /**
+     * Sets handler for messages without registered handler. Handler gets the packet as is.
+     * @param handler handler to call, nullptr drops unknown messages
+     * @param userData user data to pass to the handler
+     */
+    void setDefault(void (*handler)(void *userData, IPacket &packet), void *userData = nullptr)
+    {
+        m_default = handler;
+        m_defaultData = userData;
+    }
+
+    /**
+     * Passes received packet to the handler, registered for its message ID.
+     * @param packet received packet
+     * @return false if there is no handler for the message, or the message cannot be decoded
+     */
+    bool dispatch(IPacket &packet)
+    {
+        IdType id;
+        if ( peekMessageId(packet, id) && id >= m_base && static_cast<long>(id - m_base) < SIZE )
+        {
+            const Entry &entry = m_table[static_cast<int>(id - m_base)];
+            if ( entry.invoke )
+            {
+                return entry.invoke(entry, packet);
+            }
+        }
+        if ( m_default )
+        {
+            m_default(m_defaultData, packet);
+        }
+        return false;
+    }
+
+    /**
+     * Rx callback for Proto::setRxCallback(). Dispatcher must be set as Proto user data.
+     */
+    template <typename P> static void onRx(P &proto, IPacket &packet)
+    {
+        static_cast<MessageDispatcher *>(proto.getUserData())->dispatch(packet);
+    }
+
+    /**
+     * Receive callback for IFd::setReceiveCallback(). Dispatcher must be set as IFd user data.
+     * IFd passes the same user data to read/write callbacks of run_rx() and run_tx(), so this
+     * callback cannot be used together with them: use onReceiveFor() in that case.
+     */
+    static void onReceive(void *userData, uint8_t addr, IPacket &packet)
+    {
+        (void)addr;
+        static_cast<MessageDispatcher *>(userData)->dispatch(packet);
+    }
+
+    /**
+     * Receive callback for IFd::setReceiveCallback(), bound to the dispatcher D, so IFd user data
+     * remain free for the application. Dispatcher must have static storage duration.
+     *
+     * @code{.cpp}
+     * static tinyproto::MessageDispatcher<> dispatcher;
+     * proto.setReceiveCallback(tinyproto::MessageDispatcher<>::onReceiveFor<&dispatcher>);
+     * @endcode
+     */
+    template <MessageDispatcher *D> static void onReceiveFor(void *userData, uint8_t addr, IPacket &packet)
+    {
+        (void)userData;
+        (void)addr;
+        D->dispatch(packet);
+    }
+
+private:
+    struct Entry
+    {
+        bool (*invoke)(const Entry &entry, IPacket &packet) = nullptr;
+        void (*handler)() = nullptr;
+        void *userData = nullptr;
+    };
+
+    IdType m_base;
+    Entry m_table[SIZE]{};
+    void (*m_default)(void *userData, IPacket &packet) = nullptr;
+    void *m_defaultData = nullptr;
+
+    bool setEntry(IdType id, bool (*invoke)(const Entry &, IPacket &), void (*handler)(), void *userData)
+    {
+        if ( id < m_base || static_cast<long>(id - m_base) >= SIZE )
+        {
+            return false;
+        }
+        Entry &entry = m_table[static_cast<int>(id - m_base)];
+        entry.invoke = invoke;
+        entry.handler = handler;
+        entry.userData = userData;
+        return true;
+    }
+
+    static bool invokeRaw(const Entry &entry, IPacket &packet)
+    {
+        packet.skip(MessageField<IdType>::SIZE);
+        reinterpret_cast<void (*)(void *, IPacket &)>(entry.handler)(entry.userData, packet);
+        return true;
+    }
+
+    template <typename M> static bool invokeTyped(const Entry &entry, IPacket &packet)
+    {
+        typename M::Type message;
+        if ( !M::decode(packet, message) )
+        {
+            return false;
+        }
+        reinterpret_cast<void (*)(void *, const typename M::Type &)>(entry.handler)(entry.userData, message);
+        return true;
+    }
+};
+
+/**
+ * @}
+ */
+
+} // namespace tinyproto
@@ -46,6 +46,11 @@
 
 #include <stdio.h>
 
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+/** Multibyte values are copied to packets as is, since host byte order matches packet byte order */
+#define TINY_PACKET_LITTLE_ENDIAN 1
+#endif
+
 namespace tinyproto
 {
 
@@ -97,82 +102,174 @@ public:
      * Puts next byte to the packet. For example, after calling this method
      * twice: put(5), put(10), - the Packet will contain 5,10.
      * @param byte - data byte to put.
+     * @return false if there is no room in the packet
      */
-    void put(uint8_t byte)
+    bool put(uint8_t byte)
     {
-        m_buf[m_len++] = byte;
+        return putLe(byte);
     }
 
     /**
      * Puts next char to the packet. For example, after calling this method
      * twice: put('a'), put('c'), - the Packet will contain 'ac'.
      * @param chr - character to put.
+     * @return false if there is no room in the packet
      */
-    void put(char chr)
+    bool put(char chr)
     {
-        put(static_cast<uint8_t>(chr));
+        return putLe(static_cast<uint8_t>(chr));
     }
 
     /**
      * Puts next 16-bit unsigned integer to the packet.
      * @param data - data to put.
+     * @return false if there is no room in the packet
      */
-    inline void put(uint16_t data)
+    inline bool put(uint16_t data)
     {
-        m_buf[m_len++] = data & 0x00FF;
-        m_buf[m_len++] = data >> 8;
+        return putLe(data);
     }
 
     /**
      * Puts next 32-bit unsigned integer to the packet.
      * @param data - data to put.
+     * @return false if there is no room in the packet
      */
-    inline void put(uint32_t data)
+    inline bool put(uint32_t data)
     {
-        put((uint16_t)(data & 0x0000FFFF));
-        put((uint16_t)(data >> 16));
+        return putLe(data);
     }
 
     /**
      * Puts next 16-bit signed integer to the packet.
      * @param data - data to put.
+     * @return false if there is no room in the packet
+     */
+    inline bool put(int16_t data)
+    {
+        return putLe(static_cast<uint16_t>(data));
+    }
+
+    /**
+     * Puts next float value to the packet in IEEE 754 little-endian format.
+     * @param data - data to put.
+     * @return false if there is no room in the packet
      */
-    inline void put(int16_t data)
+    inline bool put(float data)
     {
-        put((uint16_t)data);
+        uint32_t raw;
+        memcpy(&raw, &data, sizeof(raw));
+        return putLe(raw);
+    }
+
+    /**
+     * Puts next double value to the packet in IEEE 754 little-endian format.
+     * @param data - data to put.
+     * @return false if there is no room in the packet
+     * @warning double is 4 bytes long on AVR platforms
+     */
+    inline bool put(double data)
+    {
+#if __SIZEOF_DOUBLE__ == 4
+        return put(static_cast<float>(data));
+#else
+        uint64_t raw;
+        memcpy(&raw, &data, sizeof(raw));
+        return putLe(raw);
+#endif
     }
 
     /**
      * Puts next null-terminated string to the packet.
+     * If the string doesn't fit the packet, it is truncated.
      * @param str - string to put.
+     * @return false if the string is truncated
      */
-    inline void put(const char *str)
+    inline bool put(const char *str)
     {
         int room = m_size - m_len - 1;
-        if ( !room ) return;
+        if ( room < 0 ) return false;
         int strSize = static_cast<int>(strlen(str));
-        strncpy((char *)&m_buf[m_len], str, room);
-        m_len += strSize < room ? strSize : room;
+        int len = strSize < room ? strSize : room;
+        memcpy(&m_buf[m_len], str, len);
+        m_len += len;
         m_buf[m_len++] = 0;
+        return len == strSize;
     }
 
     /**
      * Adds data from packet to the new packet being built.
      * @param pkt - reference to the Packet to add.
+     * @return false if there is no room in the packet
+     */
+    inline bool put(const IPacket &pkt)
+    {
+        return put(pkt.m_buf, pkt.m_len);
+    }
+
+    /**
+     * Puts block of data to the packet.
+     * @param data - pointer to the data to put.
+     * @param len - size of the data in bytes.
+     * @return false if there is no room in the packet, nothing is put in this case
+     */
+    inline bool put(const void *data, int len)
+    {
+        if ( len < 0 || len > m_size - m_len ) return false;
+        memcpy(&m_buf[m_len], data, len);
+        m_len += len;
+        return true;
+    }
+
+    /**
+     * Puts unsigned integer to the packet in LEB128 format: 7 bits per byte, starting from
+     * the least significant bits. Small values take less space: 0 - 127 take 1 byte.
+     * @param data - data to put.
+     * @return false if there is no room in the packet, nothing is put in this case
      */
-    inline void put(const IPacket &pkt)
+    inline bool putVarint(uint64_t data)
     {
-        memcpy(&m_buf[m_len], pkt.m_buf, pkt.m_len);
-        m_len += pkt.m_len;
+        uint8_t bytes[10];
+        int len = 0;
+        do
+        {
+            bytes[len] = data & 0x7F;
+            data >>= 7;
+            if ( data ) bytes[len] |= 0x80;
+            len++;
+        } while ( data );
+        return put(bytes, len);
+    }
+
+    /**
+     * Puts signed integer to the packet in signed LEB128 format.
+     * Small absolute values take less space: -64 - 63 take 1 byte.
+     * @param data - data to put.
+     * @return false if there is no room in the packet, nothing is put in this case
+     */
+    inline bool putSignedVarint(int64_t data)
+    {
+        uint8_t bytes[10];
+        int len = 0;
+        for ( ;; )
+        {
+            uint8_t byte = data & 0x7F;
+            // Right shift of negative values is arithmetic on all supported compilers
+            data >>= 7;
+            bool last = (data == 0 && !(byte & 0x40)) || (data == -1 && (byte & 0x40));
+            bytes[len++] = last ? byte : (byte | 0x80);
+            if ( last ) break;
+        }
+        return put(bytes, len);
     }
 
     /**
      * Reads next byte from the packet.
-     * @return byte from the packet.
+     * @return byte from the packet, or 0 if there is no more data.
      */
     inline uint8_t getByte()
     {
-        return m_buf[m_p++];
+        return getLe<uint8_t>();
     }
 
     /**
@@ -186,12 +283,11 @@ public:
 
     /**
      * Reads next unsigned 16-bit integer from the packet.
-     * @return unsigned 16-bit integer.
+     * @return unsigned 16-bit integer, or 0 if there is not enough data.
      */
     inline uint16_t getUint16()
     {
-        uint16_t t = m_buf[m_p++];
-        return t | ((uint16_t)m_buf[m_p++] << 8);
+        return getLe<uint16_t>();
     }
 
     /**
@@ -205,21 +301,110 @@ public:
 
     /**
      * Reads next unsigned 32-bit integer from the packet.
-     * @return unsigned 32-bit integer.
+     * @return unsigned 32-bit integer, or 0 if there is not enough data.
      */
     inline uint32_t getUint32()
     {
-        return getUint16() | ((uint32_t)getUint16()) << 16;
+        return getLe<uint32_t>();
+    }
+
+    /**
+     * Reads next float value from the packet.
+     * @return float value, or 0 if there is not enough data.
+     */
+    inline float getFloat()
+    {
+        uint32_t raw = getLe<uint32_t>();
+        float data;
+        memcpy(&data, &raw, sizeof(data));
+        return data;
+    }
+
+    /**
+     * Reads next double value from the packet.
+     * @return double value, or 0 if there is not enough data.
+     * @warning double is 4 bytes long on AVR platforms
+     */
+    inline double getDouble()
+    {
+#if __SIZEOF_DOUBLE__ == 4
+        return getFloat();
+#else
+        uint64_t raw = getLe<uint64_t>();
+        double data;
+        memcpy(&data, &raw, sizeof(data));
+        return data;
+#endif
+    }
+
+    /**
+     * Reads block of data from the packet.
+     * @param data - pointer to the buffer to read data to.
+     * @param len - number of bytes to read.
+     * @return false if there is not enough data, nothing is read in this case
+     */
+    inline bool get(void *data, int len)
+    {
+        if ( len < 0 || len > m_len - m_p ) return false;
+        memcpy(data, &m_buf[m_p], len);
+        m_p += len;
+        return true;
+    }
+
+    /**
+     * Reads unsigned integer in LEB128 format from the packet.
+     * @return unsigned integer, or 0 if the data is truncated or malformed. Nothing is read in this case.
+     */
+    inline uint64_t getVarint()
+    {
+        uint64_t data = 0;
+        for ( int i = 0; i < 10 && m_p + i < m_len; i++ )
+        {
+            uint8_t byte = m_buf[m_p + i];
+            data |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+            if ( !(byte & 0x80) )
+            {
+                m_p += i + 1;
+                return data;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * Reads signed integer in signed LEB128 format from the packet.
+     * @return signed integer, or 0 if the data is truncated or malformed. Nothing is read in this case.
+     */
+    inline int64_t getSignedVarint()
+    {
+        uint64_t data = 0;
+        for ( int i = 0; i < 10 && m_p + i < m_len; i++ )
+        {
+            uint8_t byte = m_buf[m_p + i];
+            data |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+            if ( !(byte & 0x80) )
+            {
+                m_p += i + 1;
+                if ( (byte & 0x40) && 7 * (i + 1) < 64 )
+                {
+                    data |= ~static_cast<uint64_t>(0) << (7 * (i + 1));
+                }
+                return static_cast<int64_t>(data);
+            }
+        }
+        return 0;
     }
 
     /**
      * Reads zero-terminated string from the packet.
-     * @return zero-terminated string.
+     * @return zero-terminated string, or nullptr if there is no terminating zero in the packet.
      */
     inline char *getString()
     {
         char *p = (char *)&m_buf[m_p];
-        m_p += static_cast<int>(strlen(p)) + 1;
+        const void *end = memchr(p, 0, m_len - m_p);
+        if ( end == nullptr ) return nullptr;
+        m_p += static_cast<int>(static_cast<const char *>(end) - p) + 1;
         return p;
     }
 
@@ -254,11 +439,23 @@ public:
      * Returns size of remaining bytes (not yet accessed through get*()) in the received packet.
      * @return size of remaining payload data.
      */
-    inline size_t availableBytes()
+    inline size_t availableBytes() const
     {
         return (size_t)(m_len - m_p);
     }
 
+    /**
+     * Skips bytes, which are not yet accessed through get*(), in the received packet.
+     * @param bytes number of bytes to skip
+     * @return false if there is not enough data, nothing is skipped in this case
+     */
+    inline bool skip(int bytes)
+    {
+        if ( bytes < 0 || bytes > m_len - m_p ) return false;
+        m_p += bytes;
+        return true;
+    }
+
     /**
      * You may refer to Packet payload data directly by using operator []
      */
@@ -299,6 +496,39 @@ private:
     int m_size = 0; // maximum space available for payload data
     int m_len = 0;  // length of payload data
     int m_p = 0;    // current pointer
+
+    /** Puts unsigned integer in little-endian order, host byte order is used as is on little-endian hosts */
+    template <typename T> bool putLe(T data)
+    {
+        if ( static_cast<int>(sizeof(T)) > m_size - m_len ) return false;
+#if TINY_PACKET_LITTLE_ENDIAN == 1
+        memcpy(&m_buf[m_len], &data, sizeof(T));
+#else
+        for ( unsigned i = 0; i < sizeof(T); i++ )
+        {
+            m_buf[m_len + i] = static_cast<uint8_t>(data >> (8 * i));
+        }
+#endif
+        m_len += sizeof(T);
+        return true;
+    }
+
+    /** Reads unsigned integer in little-endian order, returns 0 if there is not enough data */
+    template <typename T> T getLe()
+    {
+        T data = 0;
+        if ( static_cast<int>(sizeof(T)) > m_len - m_p ) return data;
+#if TINY_PACKET_LITTLE_ENDIAN == 1
+        memcpy(&data, &m_buf[m_p], sizeof(T));
+#else
+        for ( unsigned i = 0; i < sizeof(T); i++ )
+        {
+            data |= static_cast<T>(m_buf[m_p + i]) << (8 * i);
+        }
+#endif
+        m_p += sizeof(T);
+        return data;
+    }
 };
 
 /**
@@ -0,0 +1,201 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+/**
+ This is bounded lock-free queue of packet descriptors
+
+ @file
+ @brief Tiny protocol packet ring
+*/
+
+#pragma once
+
+#include "TinyPacket.h"
+#include "hal/tiny_types.h"
+
+#include <stdint.h>
+
+#ifndef CONFIG_TINYPROTO_RX_QUEUE_SIZE
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+/**
+ * Maximum number of packets, which can be registered in Proto Rx pool, must be power of 2.
+ * Proto::addRxPool() returns false for packets above the limit, Proto::begin(poolBuffers)
+ * allocates no more than the limit. Builds without thread support default to 8 packets.
+ */
+#define CONFIG_TINYPROTO_RX_QUEUE_SIZE 64
+#else
+#define CONFIG_TINYPROTO_RX_QUEUE_SIZE 8
+#endif
+#endif
+
+namespace tinyproto
+{
+
+/**
+ * PacketRing is bounded multi-producer multi-consumer queue of packet pointers. It doesn't
+ * use any locks: every cell carries sequence number, which tells producers and consumers
+ * if the cell is ready for them, so the threads contend only on single compare-and-swap
+ * of head or tail position. The ring stores only pointers, packet buffers are owned by the caller.
+ * On platforms without thread support plain memory accesses are used.
+ */
+class PacketRing
+{
+public:
+    /** Maximum number of packets in the ring */
+    static constexpr unsigned CAPACITY = CONFIG_TINYPROTO_RX_QUEUE_SIZE;
+
+    PacketRing()
+    {
+        for ( unsigned i = 0; i < CAPACITY; i++ )
+        {
+            m_cells[i].seq = i;
+        }
+    }
+
+    PacketRing(const PacketRing &) = delete;
+
+    PacketRing &operator=(const PacketRing &) = delete;
+
+    /**
+     * Puts packet to the end of the ring.
+     * @return false if the ring is full
+     */
+    bool push(IPacket *packet)
+    {
+        unsigned pos = load(m_tail, __ATOMIC_RELAXED);
+        for ( ;; )
+        {
+            Cell &cell = m_cells[pos & (CAPACITY - 1)];
+            int diff = static_cast<int>(load(cell.seq, __ATOMIC_ACQUIRE) - pos);
+            if ( diff == 0 )
+            {
+                if ( swap(m_tail, pos, pos + 1) )
+                {
+                    cell.packet = packet;
+                    store(cell.seq, pos + 1, __ATOMIC_RELEASE);
+                    return true;
+                }
+            }
+            else if ( diff < 0 )
+            {
+                return false;
+            }
+            else
+            {
+                pos = load(m_tail, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    /**
+     * Takes packet from the head of the ring.
+     * @return packet or nullptr if the ring is empty
+     */
+    IPacket *pop()
+    {
+        unsigned pos = load(m_head, __ATOMIC_RELAXED);
+        for ( ;; )
+        {
+            Cell &cell = m_cells[pos & (CAPACITY - 1)];
+            int diff = static_cast<int>(load(cell.seq, __ATOMIC_ACQUIRE) - (pos + 1));
+            if ( diff == 0 )
+            {
+                if ( swap(m_head, pos, pos + 1) )
+                {
+                    IPacket *packet = cell.packet;
+                    store(cell.seq, pos + CAPACITY, __ATOMIC_RELEASE);
+                    return packet;
+                }
+            }
+            else if ( diff < 0 )
+            {
+                return nullptr;
+            }
+            else
+            {
+                pos = load(m_head, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    /**
+     * Returns true if the ring has no packets. The result is approximate, if other threads
+     * modify the ring at the same time.
+     */
+    bool empty() const
+    {
+        return load(m_head, __ATOMIC_ACQUIRE) == load(m_tail, __ATOMIC_ACQUIRE);
+    }
+
+private:
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CONFIG_TINYPROTO_RX_QUEUE_SIZE must be power of 2");
+
+    struct Cell
+    {
+        unsigned seq;
+        IPacket *packet;
+    };
+
+    Cell m_cells[CAPACITY]{};
+    unsigned m_head = 0;
+    unsigned m_tail = 0;
+
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+    static unsigned load(const unsigned &value, int order)
+    {
+        return __atomic_load_n(&value, order);
+    }
+
+    static void store(unsigned &value, unsigned newValue, int order)
+    {
+        __atomic_store_n(&value, newValue, order);
+    }
+
+    static bool swap(unsigned &value, unsigned &expected, unsigned newValue)
+    {
+        return __atomic_compare_exchange_n(&value, &expected, newValue, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+#else
+    static unsigned load(const unsigned &value, int)
+    {
+        return value;
+    }
+
+    static void store(unsigned &value, unsigned newValue, int)
+    {
+        value = newValue;
+    }
+
+    static bool swap(unsigned &value, unsigned &expected, unsigned newValue)
+    {
+        value = newValue;
+        return true;
+    }
+#endif
+};
+
+} // namespace tinyproto
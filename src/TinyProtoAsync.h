@@ -0,0 +1,272 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+/**
+ This is awaitable operations of Proto for C++20 coroutines
+
+ @file
+ @brief Tiny protocol asynchronous API
+*/
+
+#pragma once
+
+#include "TinyPacket.h"
+#include "hal/tiny_types.h"
+
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+
+#include <condition_variable>
+#include <mutex>
+
+namespace tinyproto
+{
+
+class Proto;
+class ProtoExecutor;
+
+/**
+ * Pending asynchronous operation of Proto. Operations are completed by the thread, which drives
+ * the link (Proto own threads or ProtoReactor), and the awaiting coroutine is resumed via
+ * ProtoExecutor. If no executor is specified, the coroutine is resumed right in that thread.
+ * The library itself is not required to be built as C++20: coroutine handle type is known
+ * only to await_suspend() template, instantiated in the application code.
+ */
+class ProtoAsyncOp
+{
+public:
+    ProtoAsyncOp(const ProtoAsyncOp &) = delete;
+
+    ProtoAsyncOp &operator=(const ProtoAsyncOp &) = delete;
+
+    /**
+     * Resumes coroutine, awaiting the operation. Must be called by executor exactly once
+     * for every posted operation.
+     */
+    void resume()
+    {
+        m_resume(m_coroutine);
+    }
+
+protected:
+    ProtoAsyncOp(Proto &proto, ProtoExecutor *executor)
+        : m_proto(proto)
+        , m_executor(executor)
+    {
+    }
+
+    template <typename Handle> void setCoroutine(Handle handle)
+    {
+        m_coroutine = handle.address();
+        m_resume = [](void *address) { Handle::from_address(address).resume(); };
+    }
+
+    Proto &m_proto;
+    IPacket *m_packet = nullptr;
+    bool m_result = false;
+
+private:
+    friend class Proto;
+    friend class ProtoAsyncQueue;
+
+    ProtoExecutor *m_executor;
+    ProtoAsyncOp *m_next = nullptr;
+    void *m_coroutine = nullptr;
+    void (*m_resume)(void *) = nullptr;
+
+    /** Passes completed operation to executor */
+    void complete();
+};
+
+/**
+ * Intrusive FIFO queue of asynchronous operations. It doesn't allocate memory:
+ * operations are linked via their own field. Not thread-safe.
+ */
+class ProtoAsyncQueue
+{
+public:
+    void push(ProtoAsyncOp *op)
+    {
+        op->m_next = nullptr;
+        if ( m_tail )
+        {
+            m_tail->m_next = op;
+        }
+        else
+        {
+            m_head = op;
+        }
+        m_tail = op;
+    }
+
+    ProtoAsyncOp *pop()
+    {
+        ProtoAsyncOp *op = m_head;
+        if ( op )
+        {
+            m_head = op->m_next;
+            if ( !m_head )
+            {
+                m_tail = nullptr;
+            }
+        }
+        return op;
+    }
+
+    ProtoAsyncOp *front() const
+    {
+        return m_head;
+    }
+
+    bool empty() const
+    {
+        return m_head == nullptr;
+    }
+
+private:
+    ProtoAsyncOp *m_head = nullptr;
+    ProtoAsyncOp *m_tail = nullptr;
+};
+
+/**
+ * Integration point for external executors. post() is called from the thread, driving the link,
+ * and must not resume the coroutine in place: it should schedule op.resume() call in the
+ * executor context instead.
+ */
+class ProtoExecutor
+{
+public:
+    virtual ~ProtoExecutor() = default;
+
+    /**
+     * Schedules resumption of the coroutine, awaiting completed operation.
+     * @param op completed operation, op.resume() must be called once
+     */
+    virtual void post(ProtoAsyncOp &op) = 0;
+};
+
+/**
+ * Trivial executor, which resumes coroutines in the thread, calling run() or poll().
+ */
+class SimpleExecutor: public ProtoExecutor
+{
+public:
+    void post(ProtoAsyncOp &op) override;
+
+    /**
+     * Resumes posted coroutines until stop() is called.
+     */
+    void run();
+
+    /**
+     * Resumes already posted coroutines without waiting.
+     * @return number of resumed coroutines
+     */
+    int poll();
+
+    /**
+     * Waits for posted coroutines and resumes them.
+     * @param timeout timeout in milliseconds to wait for the first coroutine
+     * @return number of resumed coroutines
+     */
+    int runFor(uint32_t timeout);
+
+    /**
+     * Makes run() to return.
+     */
+    void stop();
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    ProtoAsyncQueue m_ready;
+    bool m_stop = false;
+};
+
+/**
+ * Awaitable returned by Proto::asyncRead(). co_await returns received packet, which
+ * must be released via Proto::release(), or nullptr if Proto is stopped.
+ */
+class ProtoReadAwaiter: public ProtoAsyncOp
+{
+public:
+    ProtoReadAwaiter(Proto &proto, ProtoExecutor *executor)
+        : ProtoAsyncOp(proto, executor)
+    {
+    }
+
+    bool await_ready();
+
+    template <typename Handle> bool await_suspend(Handle handle)
+    {
+        setCoroutine(handle);
+        // Awaiter can be destroyed by other thread right after start(), do not touch it anymore
+        return start();
+    }
+
+    IPacket *await_resume()
+    {
+        return m_packet;
+    }
+
+private:
+    bool start();
+};
+
+/**
+ * Awaitable returned by Proto::asyncSend(). co_await returns true, when the packet is
+ * accepted by the link, or false if Proto is stopped.
+ */
+class ProtoSendAwaiter: public ProtoAsyncOp
+{
+public:
+    ProtoSendAwaiter(Proto &proto, const IPacket &packet, ProtoExecutor *executor)
+        : ProtoAsyncOp(proto, executor)
+    {
+        m_packet = const_cast<IPacket *>(&packet);
+    }
+
+    bool await_ready();
+
+    template <typename Handle> bool await_suspend(Handle handle)
+    {
+        setCoroutine(handle);
+        // Awaiter can be destroyed by other thread right after start(), do not touch it anymore
+        return start();
+    }
+
+    bool await_resume()
+    {
+        return m_result;
+    }
+
+private:
+    bool start();
+};
+
+} // namespace tinyproto
+
+#endif
@@ -0,0 +1,263 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include "TinyProtoDispatcher.h"
+
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+
+namespace tinyproto
+{
+
+/** Maximum number of frames, processed before the strand is returned back to the queue */
+static constexpr int DISPATCHER_STRAND_BATCH = 16;
+
+/** Worker index of the current thread, or -1 for non-worker threads */
+static thread_local int s_workerIndex = -1;
+
+ProtoDispatcher::ProtoDispatcher(int threads)
+{
+    for ( int i = 0; i < (threads > 0 ? threads : 1); i++ )
+    {
+        m_workers.push_back(new Worker());
+    }
+}
+
+ProtoDispatcher::~ProtoDispatcher()
+{
+    end();
+    for ( auto worker: m_workers )
+    {
+        delete worker;
+    }
+    for ( auto strand: m_strands )
+    {
+        for ( auto packet: strand->packets )
+        {
+            delete packet;
+        }
+        delete strand;
+    }
+}
+
+void ProtoDispatcher::attach(Proto &proto, void (*onRx)(Proto &, IPacket &))
+{
+    Strand *strand = new Strand();
+    strand->proto = &proto;
+    strand->onRx = onRx;
+    for ( int i = 0; i < CONFIG_TINYPROTO_DISPATCHER_QUEUE_SIZE; i++ )
+    {
+        strand->packets.push_back(new HeapPacket(proto.getLink().getMtu()));
+    }
+    strand->free = strand->packets;
+    strand->queue.resize(strand->packets.size());
+    proto.m_dispatcher = this;
+    proto.m_strand = static_cast<int>(m_strands.size());
+    m_strands.push_back(strand);
+}
+
+void ProtoDispatcher::begin()
+{
+    if ( !m_terminate )
+    {
+        return;
+    }
+    m_terminate = false;
+    for ( size_t i = 0; i < m_workers.size(); i++ )
+    {
+        m_workers[i]->thread = new std::thread(&ProtoDispatcher::run, this, static_cast<int>(i));
+    }
+}
+
+void ProtoDispatcher::end()
+{
+    if ( m_terminate )
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_terminate = true;
+    }
+    m_cond.notify_all();
+    for ( auto worker: m_workers )
+    {
+        worker->thread->join();
+        delete worker->thread;
+        worker->thread = nullptr;
+        worker->strands.clear();
+    }
+    m_queued = 0;
+    for ( auto strand: m_strands )
+    {
+        strand->free = strand->packets;
+        strand->head = 0;
+        strand->count = 0;
+        strand->scheduled = false;
+    }
+    m_pending = 0;
+}
+
+bool ProtoDispatcher::post(int index, const uint8_t *buf, int len)
+{
+    Strand *strand = m_strands[index];
+    int capacity = static_cast<int>(strand->queue.size());
+    bool schedule_strand;
+    {
+        std::lock_guard<std::mutex> lock(strand->mutex);
+        HeapPacket *packet = nullptr;
+        if ( !strand->free.empty() )
+        {
+            packet = strand->free.back();
+            strand->free.pop_back();
+            m_pending++;
+        }
+        else if ( strand->proto->m_rxOverflow == RxOverflow::DROP_OLDEST && strand->count > 0 )
+        {
+            // The oldest frame is lost instead of the new one, its packet is reused at the tail
+            packet = strand->queue[strand->head];
+            strand->head = (strand->head + 1) % capacity;
+            strand->count--;
+            strand->proto->countLostFrame();
+        }
+        else
+        {
+            return false;
+        }
+        // Received data are valid only inside protocol callback, so they are copied
+        packet->clear();
+        int size = len < packet->maxSize() ? len : packet->maxSize();
+        memcpy(packet->data(), buf, size);
+        packet->allocate(size);
+        strand->queue[(strand->head + strand->count) % capacity] = packet;
+        strand->count++;
+        schedule_strand = !strand->scheduled;
+        strand->scheduled = true;
+    }
+    if ( schedule_strand )
+    {
+        schedule(strand);
+    }
+    return true;
+}
+
+bool ProtoDispatcher::canPost(int index)
+{
+    Strand *strand = m_strands[index];
+    std::lock_guard<std::mutex> lock(strand->mutex);
+    return !strand->free.empty();
+}
+
+void ProtoDispatcher::schedule(Strand *strand)
+{
+    // Workers keep rescheduled strands to themselves, other threads spread strands evenly
+    int index = s_workerIndex >= 0 ? s_workerIndex
+                                   : m_nextWorker.fetch_add(1) % static_cast<int>(m_workers.size());
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        m_workers[index]->strands.push_back(strand);
+    }
+    {
+        // Taking the lock guarantees, that sleeping worker does not miss the notification
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued++;
+    }
+    m_cond.notify_one();
+}
+
+ProtoDispatcher::Strand *ProtoDispatcher::takeStrand(int worker)
+{
+    int count = static_cast<int>(m_workers.size());
+    for ( int i = 0; i < count; i++ )
+    {
+        // Own queue is checked first, then strands are stolen from other workers
+        Worker *victim = m_workers[(worker + i) % count];
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if ( !victim->strands.empty() )
+        {
+            Strand *strand = victim->strands.front();
+            victim->strands.pop_front();
+            m_queued--;
+            return strand;
+        }
+    }
+    return nullptr;
+}
+
+void ProtoDispatcher::execute(Strand *strand)
+{
+    int capacity = static_cast<int>(strand->queue.size());
+    for ( int i = 0; i < DISPATCHER_STRAND_BATCH; i++ )
+    {
+        HeapPacket *packet;
+        {
+            std::lock_guard<std::mutex> lock(strand->mutex);
+            if ( strand->count == 0 )
+            {
+                strand->scheduled = false;
+                return;
+            }
+            packet = strand->queue[strand->head];
+            strand->head = (strand->head + 1) % capacity;
+            strand->count--;
+        }
+        m_pending--;
+        strand->onRx(*strand->proto, *packet);
+        {
+            // The packet is reused only after the handler returns
+            std::lock_guard<std::mutex> lock(strand->mutex);
+            strand->free.push_back(packet);
+        }
+        if ( strand->proto->m_rxOverflow == RxOverflow::BACKPRESSURE )
+        {
+            strand->proto->notifyRxSpace();
+        }
+    }
+    // Give other strands a chance, the strand stays scheduled and keeps frames order
+    schedule(strand);
+}
+
+void ProtoDispatcher::run(int worker)
+{
+    s_workerIndex = worker;
+    while ( !m_terminate )
+    {
+        Strand *strand = takeStrand(worker);
+        if ( strand )
+        {
+            execute(strand);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this]() { return m_terminate || m_queued > 0; });
+    }
+    s_workerIndex = -1;
+}
+
+} // namespace tinyproto
+
+#endif
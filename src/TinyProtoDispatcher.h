@@ -0,0 +1,160 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/**
+ This is dispatcher of received frames to application handlers
+
+ @file
+ @brief Tiny protocol work-stealing dispatcher
+*/
+
+#pragma once
+
+#include "TinyProtocol.h"
+
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef CONFIG_TINYPROTO_DISPATCHER_QUEUE_SIZE
+/** Number of frames, preallocated for every attached protocol */
+#define CONFIG_TINYPROTO_DISPATCHER_QUEUE_SIZE 16
+#endif
+
+namespace tinyproto
+{
+
+/**
+ * ProtoDispatcher passes received frames from protocol Rx threads to the pool of worker threads,
+ * so slow application handlers do not stall parsing of incoming data.
+ * Frames of one protocol are always processed in receive order and never concurrently,
+ * while frames of different protocols are processed in parallel. Every protocol has its own queue
+ * (strand), which is scheduled to a worker, when it becomes non-empty. Idle workers steal scheduled
+ * strands from busy ones.
+ * Every strand holds CONFIG_TINYPROTO_DISPATCHER_QUEUE_SIZE packets of link mtu size, allocated
+ * by attach(). When all of them wait for processing, RxOverflow policy of the protocol is applied.
+ *
+ * @code{.cpp}
+ * tinyproto::ProtoDispatcher dispatcher(4);
+ * dispatcher.attach(proto, onMessage);
+ * dispatcher.begin();
+ * proto.begin();
+ * @endcode
+ */
+class ProtoDispatcher
+{
+public:
+    /**
+     * Creates dispatcher.
+     * @param threads number of worker threads
+     */
+    explicit ProtoDispatcher(int threads = 2);
+
+    ~ProtoDispatcher();
+
+    /**
+     * Routes frames, received by protocol, to the handler, executed in worker threads.
+     * Must be called before the protocol is started, the link must be already set and configured.
+     * Packet, passed to the handler, is valid only during the handler call.
+     * @param proto protocol to attach
+     * @param onRx handler to call for every received frame
+     */
+    void attach(Proto &proto, void (*onRx)(Proto &, IPacket &));
+
+    /**
+     * Starts worker threads.
+     */
+    void begin();
+
+    /**
+     * Stops worker threads. Frames, which are not processed yet, are dropped.
+     * Protocols must be stopped before calling this method.
+     */
+    void end();
+
+    /**
+     * Returns number of frames, waiting for processing.
+     */
+    int getPending() const
+    {
+        return m_pending;
+    }
+
+private:
+    struct Strand
+    {
+        Proto *proto = nullptr;
+        void (*onRx)(Proto &, IPacket &) = nullptr;
+        std::mutex mutex;
+        std::vector<HeapPacket *> packets; // all packets of the strand
+        std::vector<HeapPacket *> free;    // packets, available for new frames
+        std::vector<HeapPacket *> queue;   // ring of frames, waiting for processing
+        int head = 0;
+        int count = 0;
+        bool scheduled = false;
+    };
+
+    struct Worker
+    {
+        std::thread *thread = nullptr;
+        std::mutex mutex;
+        std::deque<Strand *> strands;
+    };
+
+    std::vector<Strand *> m_strands;
+    std::vector<Worker *> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::atomic<int> m_pending{0};
+    std::atomic<int> m_queued{0}; // number of strands in workers queues
+    std::atomic<int> m_nextWorker{0};
+    std::atomic<bool> m_terminate{true};
+
+    bool post(int strand, const uint8_t *buf, int len);
+
+    bool canPost(int strand);
+
+    void schedule(Strand *strand);
+
+    Strand *takeStrand(int worker);
+
+    void execute(Strand *strand);
+
+    void run(int worker);
+
+    friend class Proto;
+};
+
+} // namespace tinyproto
+
+#endif
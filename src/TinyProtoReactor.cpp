@@ -0,0 +1,304 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include "TinyProtoReactor.h"
+
+#if CONFIG_TINYPROTO_REACTOR == 1
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace tinyproto
+{
+
+/** Maximum number of events, processed by single epoll_wait() call */
+static constexpr int REACTOR_MAX_EVENTS = 64;
+
+/** Events, which every link is watched for. EPOLLRDHUP also keeps registered mask non-zero */
+static constexpr uint32_t REACTOR_BASE_EVENTS = static_cast<uint32_t>(EPOLLIN) | static_cast<uint32_t>(EPOLLRDHUP);
+
+/** Events, which mean that the link is closed or failed */
+static constexpr uint32_t REACTOR_DOWN_EVENTS = static_cast<uint32_t>(EPOLLHUP) | static_cast<uint32_t>(EPOLLERR) |
+                                                static_cast<uint32_t>(EPOLLRDHUP);
+
+ProtoReactor::ProtoReactor(int threads)
+    : m_shards(threads > 0 ? threads : 1)
+{
+}
+
+ProtoReactor::~ProtoReactor()
+{
+    end();
+}
+
+bool ProtoReactor::add(Proto &proto)
+{
+    if ( !m_terminate )
+    {
+        return false;
+    }
+    proto.m_reactor = this;
+    proto.m_shard = static_cast<int>(m_protos.size() % m_shards.size());
+    if ( !proto.begin() )
+    {
+        proto.m_reactor = nullptr;
+        return false;
+    }
+    m_protos.push_back(&proto);
+    return true;
+}
+
+void ProtoReactor::setTick(uint32_t tickMs)
+{
+    m_tickMs = tickMs;
+}
+
+bool ProtoReactor::begin()
+{
+    if ( !m_terminate )
+    {
+        return false;
+    }
+    for ( auto &shard: m_shards )
+    {
+        shard.epollFd = epoll_create1(EPOLL_CLOEXEC);
+        shard.wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        struct epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;
+        if ( shard.epollFd < 0 || shard.wakeFd < 0 || epoll_ctl(shard.epollFd, EPOLL_CTL_ADD, shard.wakeFd, &ev) < 0 )
+        {
+            for ( auto &s: m_shards )
+            {
+                closeShard(s);
+            }
+            return false;
+        }
+    }
+    for ( auto proto: m_protos )
+    {
+        Shard &shard = m_shards[proto->m_shard];
+        shard.protos.push_back(proto);
+        int fd = proto->getLink().getFd();
+        struct epoll_event ev{};
+        ev.events = REACTOR_BASE_EVENTS;
+        ev.data.ptr = proto;
+        proto->m_reactorEvents = 0;
+        if ( fd < 0 || epoll_ctl(shard.epollFd, EPOLL_CTL_ADD, fd, &ev) < 0 )
+        {
+            shard.polled.push_back(proto);
+        }
+        else
+        {
+            proto->m_reactorEvents = REACTOR_BASE_EVENTS;
+        }
+    }
+    m_terminate = false;
+    for ( auto &shard: m_shards )
+    {
+        shard.thread = new std::thread(&ProtoReactor::run, this, std::ref(shard));
+    }
+    return true;
+}
+
+void ProtoReactor::end()
+{
+    if ( !m_terminate )
+    {
+        m_terminate = true;
+        for ( size_t i = 0; i < m_shards.size(); i++ )
+        {
+            notify(static_cast<int>(i));
+        }
+        for ( auto &shard: m_shards )
+        {
+            shard.thread->join();
+            delete shard.thread;
+            shard.thread = nullptr;
+            closeShard(shard);
+        }
+    }
+    for ( auto proto: m_protos )
+    {
+        proto->end();
+        proto->m_reactor = nullptr;
+    }
+    m_protos.clear();
+}
+
+void ProtoReactor::closeShard(Shard &shard)
+{
+    if ( shard.epollFd >= 0 )
+    {
+        close(shard.epollFd);
+        shard.epollFd = -1;
+    }
+    if ( shard.wakeFd >= 0 )
+    {
+        close(shard.wakeFd);
+        shard.wakeFd = -1;
+    }
+    shard.protos.clear();
+    shard.polled.clear();
+    shard.stalled.clear();
+}
+
+void ProtoReactor::watch(Shard &shard, Proto *proto, uint32_t events)
+{
+    if ( proto->m_reactorEvents == 0 || proto->m_reactorEvents == events )
+    {
+        return;
+    }
+    struct epoll_event ev{};
+    ev.events = events;
+    ev.data.ptr = proto;
+    epoll_ctl(shard.epollFd, EPOLL_CTL_MOD, proto->getLink().getFd(), &ev);
+    proto->m_reactorEvents = events;
+}
+
+void ProtoReactor::unwatch(Shard &shard, Proto *proto)
+{
+    // Hang up is reported by level-triggered epoll forever, so the link is removed from epoll
+    if ( proto->m_reactorEvents != 0 )
+    {
+        epoll_ctl(shard.epollFd, EPOLL_CTL_DEL, proto->getLink().getFd(), nullptr);
+        proto->m_reactorEvents = 0;
+    }
+    shard.stalled.erase(std::remove(shard.stalled.begin(), shard.stalled.end(), proto), shard.stalled.end());
+    proto->getLink().markDown();
+}
+
+void ProtoReactor::notify(int shard)
+{
+    uint64_t value = 1;
+    if ( write(m_shards[shard].wakeFd, &value, sizeof(value)) < 0 )
+    {
+        // Counter is already non-zero, the thread will wake up anyway
+    }
+}
+
+void ProtoReactor::run(Shard &shard)
+{
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    while ( !m_terminate )
+    {
+        int count = epoll_wait(shard.epollFd, events, REACTOR_MAX_EVENTS, static_cast<int>(m_tickMs));
+        for ( int i = 0; i < count; i++ )
+        {
+            Proto *proto = static_cast<Proto *>(events[i].data.ptr);
+            if ( !proto )
+            {
+                uint64_t value;
+                if ( read(shard.wakeFd, &value, sizeof(value)) < 0 )
+                {
+                    // Already cleared
+                }
+                continue;
+            }
+            if ( events[i].events & (static_cast<uint32_t>(EPOLLIN) | REACTOR_DOWN_EVENTS) )
+            {
+                if ( proto->canReceive() )
+                {
+                    // Data, received before hang up, are still processed
+                    proto->getLink().runRx();
+                }
+                if ( (!proto->canReceive() || proto->getLink().hasPendingRx()) &&
+                     (proto->m_reactorEvents & static_cast<uint32_t>(EPOLLIN)) )
+                {
+                    // Level-triggered fd with unread data would wake up epoll_wait() forever, so it is disarmed.
+                    // Frames, left in the link due to backpressure, are parsed from the stalled list.
+                    watch(shard, proto, proto->m_reactorEvents & ~static_cast<uint32_t>(EPOLLIN));
+                    shard.stalled.push_back(proto);
+                }
+            }
+            if ( (events[i].events & REACTOR_DOWN_EVENTS) || !proto->getLink().isUp() )
+            {
+                unwatch(shard, proto);
+            }
+        }
+        for ( size_t i = 0; i < shard.stalled.size(); )
+        {
+            Proto *proto = shard.stalled[i];
+            if ( proto->canReceive() && proto->getLink().hasPendingRx() )
+            {
+                // Data, left in the link, do not wake up epoll_wait()
+                proto->getLink().runRx();
+            }
+            if ( proto->canReceive() && !proto->getLink().hasPendingRx() )
+            {
+                watch(shard, proto, proto->m_reactorEvents | static_cast<uint32_t>(EPOLLIN));
+                shard.stalled[i] = shard.stalled.back();
+                shard.stalled.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+        for ( auto proto: shard.polled )
+        {
+            if ( proto->canReceive() && proto->getLink().isUp() )
+            {
+                proto->getLink().runRx();
+            }
+        }
+        // Tx never blocks: data, which the link cannot accept, are carried over to the next runTx() call,
+        // and EPOLLOUT wakes up the thread, when the link is writable. It also processes protocol timers.
+        for ( auto proto: shard.protos )
+        {
+            ILinkLayer &link = proto->getLink();
+            if ( link.isUp() )
+            {
+                link.runTx();
+            }
+            proto->completeAsyncSends();
+            if ( proto->m_reactorEvents == 0 )
+            {
+                continue;
+            }
+            if ( !link.isUp() )
+            {
+                unwatch(shard, proto);
+            }
+            else if ( link.hasPendingTx() )
+            {
+                watch(shard, proto, proto->m_reactorEvents | static_cast<uint32_t>(EPOLLOUT));
+            }
+            else
+            {
+                watch(shard, proto, proto->m_reactorEvents & ~static_cast<uint32_t>(EPOLLOUT));
+            }
+        }
+    }
+}
+
+} // namespace tinyproto
+
+#endif
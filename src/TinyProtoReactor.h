@@ -0,0 +1,140 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/**
+ This is Tiny protocol reactor, which serves many links with fixed number of threads
+
+ @file
+ @brief Tiny protocol multi-link runtime
+*/
+
+#pragma once
+
+#include "TinyProtocol.h"
+
+#if CONFIG_TINYPROTO_REACTOR == 1
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace tinyproto
+{
+
+/**
+ * ProtoReactor drives Rx and Tx of many Proto objects from a small fixed pool of threads.
+ * Protocols are distributed between threads (shards) in round-robin order, and each protocol
+ * is always served by the same thread. Every thread waits for incoming data on all its links
+ * with single epoll instance, and sends data as soon as Proto::send() queues new frame.
+ * Links, which do not provide file descriptor (ILinkLayer::getFd() returns -1), are polled
+ * every tick. The tick also drives protocol timers (retries and keep alive).
+ * Tx never blocks the thread: data, not accepted by the link, are sent, when the descriptor
+ * becomes writable. Links, which are hung up or fail, are marked down (ILinkLayer::isUp()
+ * returns false) and are not served anymore.
+ *
+ * Proto objects, added to the reactor, should be created with multithread=false.
+ * Proto::send() and Proto::read() can be called from any application thread.
+ *
+ * @code{.cpp}
+ * tinyproto::ProtoReactor reactor(4);
+ * for ( auto &proto: protos )
+ *     reactor.add(proto);
+ * reactor.begin();
+ * ...
+ * reactor.end();
+ * @endcode
+ */
+class ProtoReactor
+{
+public:
+    /**
+     * Creates reactor.
+     * @param threads number of threads to serve links
+     */
+    explicit ProtoReactor(int threads = 1);
+
+    ~ProtoReactor();
+
+    /**
+     * Starts protocol and passes it under reactor control. Protocol link must be
+     * assigned with Proto::setLink(). Can be called only before begin().
+     * @param proto protocol to add
+     * @return true if protocol is started successfully
+     */
+    bool add(Proto &proto);
+
+    /**
+     * Sets maximum time, threads sleep waiting for events. Protocol timeouts resolution
+     * depends on this value. Default value is 10 milliseconds.
+     * @param tickMs time in milliseconds
+     */
+    void setTick(uint32_t tickMs);
+
+    /**
+     * Starts reactor threads.
+     * @return true if successful
+     */
+    bool begin();
+
+    /**
+     * Stops reactor threads and ends all added protocols.
+     */
+    void end();
+
+private:
+    struct Shard
+    {
+        std::thread *thread = nullptr;
+        int epollFd = -1;
+        int wakeFd = -1;
+        std::vector<Proto *> protos;
+        std::vector<Proto *> polled;
+        std::vector<Proto *> stalled; // links, not watched for Rx due to backpressure
+    };
+
+    std::vector<Shard> m_shards;
+    std::vector<Proto *> m_protos;
+    std::atomic<bool> m_terminate{true};
+    uint32_t m_tickMs = 10;
+
+    void notify(int shard);
+
+    void run(Shard &shard);
+
+    void closeShard(Shard &shard);
+
+    void watch(Shard &shard, Proto *proto, uint32_t events);
+
+    void unwatch(Shard &shard, Proto *proto);
+
+    friend class Proto;
+};
+
+} // namespace tinyproto
+
+#endif
@@ -27,6 +27,12 @@
 */
 
 #include "TinyProtocol.h"
+#include "TinyProtoReactor.h"
+#include "TinyProtoDispatcher.h"
+
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+#include <chrono>
+#endif
 
 namespace tinyproto
 {
@@ -34,20 +40,29 @@ namespace tinyproto
 enum
 {
     PROTO_RX_MESSAGE = 1,
+    PROTO_RX_POOL = 2,
 };
 
+/** Time in milliseconds, Rx and Tx threads sleep for, while the link is down */
+static constexpr uint32_t PROTO_LINK_DOWN_DELAY = 100;
+
 Proto::Proto(bool multithread)
    : m_link(nullptr)
    , m_multithread( multithread )
 {
     tiny_events_create( &m_events );
-    tiny_mutex_create( &m_mutex );
 }
 
 Proto::~Proto()
 {
     end();
-    tiny_mutex_destroy( &m_mutex );
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+    for ( int i = 0; i < m_heapPoolSize; i++ )
+    {
+        delete m_heapPool[i];
+    }
+    delete[] m_heapPool;
+#endif
     tiny_events_destroy( &m_events );
 }
 
@@ -64,6 +79,14 @@ ILinkLayer &Proto::getLink()
 bool Proto::begin()
 {
     uint32_t timeout = m_link->getTimeout();
+#if CONFIG_TINYPROTO_REACTOR == 1
+    if ( m_reactor )
+    {
+        // Reactor threads wait for readiness themselves, link must not block
+        timeout = 0;
+    }
+    else
+#endif
     if ( m_multithread && !timeout )
     {
         timeout = 1000;
@@ -78,6 +101,13 @@ bool Proto::begin()
         m_terminate = true;
         return false;
     }
+#if CONFIG_TINYPROTO_REACTOR == 1
+    if ( m_reactor )
+    {
+        m_terminate = false;
+        return true;
+    }
+#endif
 #if CONFIG_TINYHAL_THREAD_SUPPORT == 1
     if ( m_multithread )
     {
@@ -91,6 +121,24 @@ bool Proto::begin()
 
 bool Proto::begin(int poolBuffers)
 {
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+    // Buffers are allocated once and sized for the largest frame, so Rx path never allocates memory
+    if ( !m_heapPool && poolBuffers > 0 )
+    {
+        // Pool cannot hold more packets, extra buffers would never be used
+        if ( poolBuffers > static_cast<int>(PacketRing::CAPACITY) )
+        {
+            poolBuffers = static_cast<int>(PacketRing::CAPACITY);
+        }
+        m_heapPool = new HeapPacket *[poolBuffers];
+        m_heapPoolSize = poolBuffers;
+        for ( int i = 0; i < poolBuffers; i++ )
+        {
+            m_heapPool[i] = new HeapPacket( m_link->getMtu() );
+            addRxPool( *m_heapPool[i] );
+        }
+    }
+#endif
     return Proto::begin();
 }
 
@@ -101,7 +149,7 @@ bool Proto::send(const IPacket &packet, uint32_t timeout)
     for ( ;; )
     {
         // Try to put message to outgoing queue
-        result = m_link->put( packet.m_buf, packet.m_len, m_multithread ? timeout : 0 );
+        result = putTx( packet, isDriven() ? timeout : 0 );
         if ( result )
         {
             break;
@@ -112,73 +160,87 @@ bool Proto::send(const IPacket &packet, uint32_t timeout)
             m_link->flushTx();
             break;
         }
-        if ( !m_multithread )
+        if ( !isDriven() )
         {
-            m_link->runTx();
-            m_link->runRx();
+            runLink();
         }
     }
     return result;
 }
 
-/*void Proto::printCount(const char * name, IPacket *queue)
-{
-    int counter = 0;
-    IPacket *p = queue;
-    while ( p )
-    {
-        p = p->m_next;
-        counter++;
-    }
-    printf("[%p] %s counter %i \n", this, name, counter);
-}*/
-
-
 IPacket *Proto::read(uint32_t timeout)
 {
     IPacket *p = nullptr;
     uint32_t startTs = tiny_millis();
     for ( ;; )
     {
-        tiny_events_wait(&m_events, PROTO_RX_MESSAGE, EVENT_BITS_CLEAR, m_multithread ? timeout : 0);
-        tiny_mutex_lock( &m_mutex );
-        if ( m_queue != nullptr )
+        p = m_queue.pop();
+        if ( p != nullptr )
         {
-            p = m_queue;
-            m_queue = m_queue->m_next;
-            if ( m_queue != nullptr )
-            {
-                m_queue->m_prev = nullptr;
-                tiny_events_set( &m_events, PROTO_RX_MESSAGE );
-            }
-            else
-            {
-                m_last = nullptr;
-            }
-            //printCount( "read Pool", m_pool );
-            //printCount( "read Queue", m_queue );
-            tiny_mutex_unlock( &m_mutex );
             break;
         }
-        tiny_mutex_unlock( &m_mutex );
         // Always run Tx/Rx loop before checking timings, otherwise messages will be never received
-        if ( !m_multithread )
+        if ( !isDriven() )
         {
-            m_link->runTx();
-            m_link->runRx();
+            runLink();
+            p = m_queue.pop();
+            if ( p != nullptr )
+            {
+                break;
+            }
         }
-        if ( static_cast<uint32_t>(tiny_millis() - startTs) >= timeout )
+        uint32_t passed = static_cast<uint32_t>(tiny_millis() - startTs);
+        if ( passed >= timeout )
         {
             break;
         }
+        // Event is only a wake-up hint: the ring is checked again after waiting
+        tiny_events_wait(&m_events, PROTO_RX_MESSAGE, EVENT_BITS_CLEAR, isDriven() ? timeout - passed : 0);
     }
     return p;
 }
 
+int Proto::readMany(IPacket **packets, int count, uint32_t timeout)
+{
+    if ( count <= 0 )
+    {
+        return 0;
+    }
+    packets[0] = read( timeout );
+    if ( packets[0] == nullptr )
+    {
+        return 0;
+    }
+    int result = 1;
+    while ( result < count && (packets[result] = m_queue.pop()) != nullptr )
+    {
+        result++;
+    }
+    return result;
+}
+
+bool Proto::putTx(const IPacket &packet, uint32_t timeout)
+{
+    if ( !m_link->put( packet.m_buf, packet.m_len, timeout ) )
+    {
+        return false;
+    }
+#if CONFIG_TINYPROTO_REACTOR == 1
+    if ( m_reactor )
+    {
+        m_reactor->notify( m_shard );
+    }
+#endif
+    return true;
+}
+
 void Proto::end()
 {
     if ( m_terminate )
     {
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+        cancelAsync();
+#endif
         return;
     }
     m_terminate = true;
@@ -195,11 +257,31 @@ void Proto::end()
     }
 #endif
     m_link->end();
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+    cancelAsync();
+#endif
     return;
 }
 
 void Proto::onRead(uint8_t addr, uint8_t *buf, int len)
 {
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+    if ( m_dispatcher )
+    {
+        // Only own Rx thread can be blocked, the same as for Rx pool
+        while ( !m_dispatcher->post(m_strand, buf, len) )
+        {
+            if ( m_rxOverflow != RxOverflow::BACKPRESSURE || !m_multithread || m_terminate )
+            {
+                countLostFrame();
+                break;
+            }
+            tiny_events_wait( &m_events, PROTO_RX_POOL, EVENT_BITS_CLEAR, 100 );
+        }
+        holdRxIfFull();
+        return;
+    }
+#endif
     // We do not need pool for callback mode
     if ( m_onRx )
     {
@@ -208,60 +290,120 @@ void Proto::onRead(uint8_t addr, uint8_t *buf, int len)
         m_onRx(*this, packet);
         return;
     }
-    tiny_mutex_lock( &m_mutex );
-    IPacket * p = m_pool;
-    if ( p == nullptr )
+    IPacket *p = m_pool.pop();
+    if ( p == nullptr && m_rxOverflow == RxOverflow::DROP_OLDEST )
     {
+        // The oldest frame is lost instead of the new one
+        p = m_queue.pop();
+        if ( p != nullptr )
+        {
+            countLostFrame();
+        }
+    }
 #if CONFIG_TINYHAL_THREAD_SUPPORT == 1
-        // TODO: Lost frame
-        m_lostRxFrames++;
-        // printf("Lost -------------------- \n");
+    // Only own Rx thread can be blocked, read() of single-thread mode would never return otherwise
+    while ( p == nullptr && m_rxOverflow == RxOverflow::BACKPRESSURE && m_multithread && !m_terminate )
+    {
+        tiny_events_wait( &m_events, PROTO_RX_POOL, EVENT_BITS_CLEAR, 100 );
+        p = m_pool.pop();
+    }
 #endif
+    if ( p == nullptr )
+    {
+        countLostFrame();
+        return;
+    }
+    // Copy data if needed
+    if ( p->m_size == 0 )
+    {
+        p->m_buf = buf;
+        p->m_len = len;
     }
     else
     {
-        // Remove from pool
-        m_pool = m_pool->m_next;
-        if ( m_pool )
-        {
-            m_pool->m_prev = nullptr;
-        }
-        // Add to rx queue
-        p->m_next = nullptr;
-        p->m_prev = m_last;
-        if ( m_last )
-        {
-            m_last->m_next = p;
-        }
-        m_last = p;
-        if ( m_queue == nullptr )
-        {
-            m_queue = p;
-        }
-        // Copy data if needed
-        if ( p->m_size == 0 )
-        {
-            p->m_buf = buf;
-            p->m_len = len;
-        }
-        else
-        {
-            // TODO: Error if oversize
-            p->m_len = p->m_size < len ? p->m_size: len;
-            memcpy( p->m_buf, buf, p->m_len );
-        }
-        p->m_p = 0;
-        tiny_events_set( &m_events, PROTO_RX_MESSAGE );
+        // TODO: Error if oversize
+        p->m_len = p->m_size < len ? p->m_size: len;
+        memcpy( p->m_buf, buf, p->m_len );
     }
-    //printCount( "new Pool", m_pool );
-    //printCount( "new Queue", m_queue );
-    tiny_mutex_unlock( &m_mutex );
+    p->m_p = 0;
+    // Rx queue can hold all registered packets, so push never fails
+    m_queue.push( p );
+    tiny_events_set( &m_events, PROTO_RX_MESSAGE );
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+    completeAsyncReads();
+#endif
+    holdRxIfFull();
+}
+
+void Proto::holdRxIfFull()
+{
+    // Next frames remain in the link until there is space for them, otherwise they are lost
+    if ( m_rxOverflow == RxOverflow::BACKPRESSURE && !canReceive() )
+    {
+        m_link->holdRx();
+    }
+}
+
+void Proto::countLostFrame()
+{
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+    __atomic_fetch_add( &m_lostRxFrames, 1, __ATOMIC_RELAXED );
+#else
+    m_lostRxFrames++;
+#endif
 }
 
 void Proto::onSend(uint8_t addr, const uint8_t *buf, int len)
 {
 }
 
+bool Proto::canReceive() const
+{
+    if ( m_rxOverflow != RxOverflow::BACKPRESSURE )
+    {
+        return true;
+    }
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+    if ( m_dispatcher )
+    {
+        return m_dispatcher->canPost( m_strand );
+    }
+#endif
+    return !m_pool.empty();
+}
+
+void Proto::notifyRxSpace()
+{
+    tiny_events_set( &m_events, PROTO_RX_POOL );
+#if CONFIG_TINYPROTO_REACTOR == 1
+    if ( m_reactor )
+    {
+        m_reactor->notify( m_shard );
+    }
+#endif
+}
+
+void Proto::runLink()
+{
+    m_link->runTx();
+    if ( canReceive() )
+    {
+        m_link->runRx();
+    }
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+    completeAsyncSends();
+#endif
+}
+
+bool Proto::isDriven() const
+{
+#if CONFIG_TINYPROTO_REACTOR == 1
+    return m_multithread || m_reactor != nullptr;
+#else
+    return m_multithread;
+#endif
+}
+
 void Proto::onReadCb(void *udata, uint8_t addr, uint8_t *buf, int len)
 {
     Proto *proto = reinterpret_cast<Proto *>(udata);
@@ -285,7 +427,14 @@ void Proto::runTx()
         }
         while ( !m_terminate )
         {
+            if ( !getLink().isUp() )
+            {
+                // Closed channel fails immediately, do not spin on it
+                tiny_sleep( PROTO_LINK_DOWN_DELAY );
+                continue;
+            }
             getLink().runTx();
+            completeAsyncSends();
         }
     }
 }
@@ -296,7 +445,20 @@ void Proto::runRx()
     {
         while ( !m_terminate )
         {
+            if ( !canReceive() )
+            {
+                tiny_events_wait( &m_events, PROTO_RX_POOL, EVENT_BITS_CLEAR, 100 );
+                continue;
+            }
+            if ( !getLink().isUp() )
+            {
+                // Closed channel returns error without waiting, do not spin on it
+                tiny_sleep( PROTO_LINK_DOWN_DELAY );
+                continue;
+            }
             getLink().runRx();
+            // Confirmations from remote side free Tx queue slots
+            completeAsyncSends();
         }
     }
 }
@@ -308,9 +470,228 @@ void Proto::setTxDelay( uint32_t delay )
 
 int Proto::getLostRxFrames()
 {
-    int val = m_lostRxFrames;
-    m_lostRxFrames = 0;
-    return val;
+    return __atomic_exchange_n( &m_lostRxFrames, 0, __ATOMIC_RELAXED );
+}
+
+ProtoReadAwaiter Proto::asyncRead(ProtoExecutor *executor)
+{
+    return ProtoReadAwaiter( *this, executor );
+}
+
+ProtoSendAwaiter Proto::asyncSend(const IPacket &packet, ProtoExecutor *executor)
+{
+    return ProtoSendAwaiter( *this, packet, executor );
+}
+
+bool Proto::startRead(ProtoAsyncOp &op)
+{
+    std::lock_guard<std::mutex> lock( m_asyncMutex );
+    // Counter is published before the ring is checked, and onRead() pushes to the ring before
+    // checking the counter, so the packet cannot be missed by both sides
+    __atomic_fetch_add( &m_asyncReadsCount, 1, __ATOMIC_SEQ_CST );
+    op.m_packet = m_queue.pop();
+    if ( op.m_packet != nullptr )
+    {
+        __atomic_fetch_sub( &m_asyncReadsCount, 1, __ATOMIC_SEQ_CST );
+        return false;
+    }
+    m_asyncReads.push( &op );
+    return true;
+}
+
+bool Proto::startSend(ProtoAsyncOp &op)
+{
+    std::lock_guard<std::mutex> lock( m_asyncMutex );
+    // Earlier pending sends go first to keep the order of packets
+    if ( m_asyncSends.empty() && putTx( *op.m_packet, 0 ) )
+    {
+        op.m_result = true;
+        return false;
+    }
+    m_asyncSends.push( &op );
+    __atomic_fetch_add( &m_asyncSendsCount, 1, __ATOMIC_SEQ_CST );
+    return true;
+}
+
+void Proto::completeAsyncReads()
+{
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    if ( !__atomic_load_n( &m_asyncReadsCount, __ATOMIC_SEQ_CST ) )
+    {
+        return;
+    }
+    ProtoAsyncQueue done;
+    {
+        std::lock_guard<std::mutex> lock( m_asyncMutex );
+        while ( !m_asyncReads.empty() )
+        {
+            IPacket *p = m_queue.pop();
+            if ( p == nullptr )
+            {
+                break;
+            }
+            ProtoAsyncOp *op = m_asyncReads.pop();
+            op->m_packet = p;
+            done.push( op );
+            __atomic_fetch_sub( &m_asyncReadsCount, 1, __ATOMIC_SEQ_CST );
+        }
+    }
+    // Operations are resumed outside of the lock, since coroutines may start new operations
+    while ( ProtoAsyncOp *op = done.pop() )
+    {
+        op->complete();
+    }
+}
+
+void Proto::completeAsyncSends()
+{
+    if ( !__atomic_load_n( &m_asyncSendsCount, __ATOMIC_ACQUIRE ) )
+    {
+        return;
+    }
+    ProtoAsyncQueue done;
+    {
+        std::lock_guard<std::mutex> lock( m_asyncMutex );
+        while ( !m_asyncSends.empty() && putTx( *m_asyncSends.front()->m_packet, 0 ) )
+        {
+            ProtoAsyncOp *op = m_asyncSends.pop();
+            op->m_result = true;
+            done.push( op );
+            __atomic_fetch_sub( &m_asyncSendsCount, 1, __ATOMIC_SEQ_CST );
+        }
+    }
+    while ( ProtoAsyncOp *op = done.pop() )
+    {
+        op->complete();
+    }
+}
+
+void Proto::cancelAsync()
+{
+    ProtoAsyncQueue done;
+    {
+        std::lock_guard<std::mutex> lock( m_asyncMutex );
+        while ( ProtoAsyncOp *op = m_asyncReads.pop() )
+        {
+            op->m_packet = nullptr;
+            done.push( op );
+        }
+        while ( ProtoAsyncOp *op = m_asyncSends.pop() )
+        {
+            op->m_result = false;
+            done.push( op );
+        }
+        __atomic_store_n( &m_asyncReadsCount, 0, __ATOMIC_SEQ_CST );
+        __atomic_store_n( &m_asyncSendsCount, 0, __ATOMIC_SEQ_CST );
+    }
+    while ( ProtoAsyncOp *op = done.pop() )
+    {
+        op->complete();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ProtoAsyncOp::complete()
+{
+    if ( m_executor )
+    {
+        m_executor->post( *this );
+    }
+    else
+    {
+        resume();
+    }
+}
+
+bool ProtoReadAwaiter::await_ready()
+{
+    m_packet = m_proto.m_queue.pop();
+    return m_packet != nullptr;
+}
+
+bool ProtoReadAwaiter::start()
+{
+    return m_proto.startRead( *this );
+}
+
+bool ProtoSendAwaiter::await_ready()
+{
+    // Fast path is not taken, when other sends are pending, to keep the order of packets
+    if ( __atomic_load_n( &m_proto.m_asyncSendsCount, __ATOMIC_ACQUIRE ) )
+    {
+        return false;
+    }
+    m_result = m_proto.putTx( *m_packet, 0 );
+    return m_result;
+}
+
+bool ProtoSendAwaiter::start()
+{
+    return m_proto.startSend( *this );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void SimpleExecutor::post(ProtoAsyncOp &op)
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_ready.push( &op );
+    }
+    m_cond.notify_one();
+}
+
+void SimpleExecutor::run()
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    while ( !m_stop )
+    {
+        ProtoAsyncOp *op = m_ready.pop();
+        if ( op == nullptr )
+        {
+            m_cond.wait( lock );
+            continue;
+        }
+        lock.unlock();
+        op->resume();
+        lock.lock();
+    }
+    m_stop = false;
+}
+
+int SimpleExecutor::poll()
+{
+    return runFor( 0 );
+}
+
+int SimpleExecutor::runFor(uint32_t timeout)
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    if ( timeout )
+    {
+        m_cond.wait_for( lock, std::chrono::milliseconds( timeout ), [this]() -> bool { return !m_ready.empty(); } );
+    }
+    int count = 0;
+    // Only coroutines, posted before the call, are resumed, so the method always returns
+    ProtoAsyncQueue ready = m_ready;
+    m_ready = ProtoAsyncQueue();
+    lock.unlock();
+    while ( ProtoAsyncOp *op = ready.pop() )
+    {
+        op->resume();
+        count++;
+    }
+    return count;
+}
+
+void SimpleExecutor::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_stop = true;
+    }
+    m_cond.notify_all();
 }
 #endif
 
@@ -319,19 +700,18 @@ void Proto::release(IPacket *message)
     addRxPool(*message);
 }
 
-void Proto::addRxPool(IPacket &message)
+bool Proto::addRxPool(IPacket &message)
 {
-    tiny_mutex_lock( &m_mutex );
-    message.m_next = m_pool;
-    message.m_prev = nullptr;
-    if ( m_pool != nullptr )
+    // Packets above PacketRing::CAPACITY are not registered
+    if ( !m_pool.push( &message ) )
     {
-        m_pool->m_prev = &message;
+        return false;
+    }
+    if ( m_rxOverflow == RxOverflow::BACKPRESSURE )
+    {
+        notifyRxSpace();
     }
-    m_pool = &message;
-    //printCount( "release Pool", m_pool );
-    //printCount( "release Queue", m_queue );
-    tiny_mutex_unlock( &m_mutex );
+    return true;
 }
 
 void Proto::setRxCallback(void (*onRx)(Proto &, IPacket &))
@@ -339,6 +719,11 @@ void Proto::setRxCallback(void (*onRx)(Proto &, IPacket &))
     m_onRx = onRx;
 }
 
+void Proto::setRxOverflow(RxOverflow policy)
+{
+    m_rxOverflow = policy;
+}
+
 //////////// Platform specific helper classes
 
 #if defined(ARDUINO)
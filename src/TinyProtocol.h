@@ -37,6 +37,8 @@
 #pragma once
 
 #include "TinyPacket.h"
+#include "TinyPacketRing.h"
+#include "TinyProtoAsync.h"
 #include "TinyLightProtocol.h"
 #include "TinyProtocolHdlc.h"
 #include "TinyProtocolFd.h"
@@ -50,12 +52,41 @@
 #include <limits.h>
 
 #if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+#include <mutex>
 #include <thread>
 #endif
 
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1 && defined(__linux__)
+/** ProtoReactor is available on Linux only, since it relies on epoll */
+#define CONFIG_TINYPROTO_REACTOR 1
+#endif
+
 namespace tinyproto
 {
 
+#if CONFIG_TINYPROTO_REACTOR == 1
+class ProtoReactor;
+#endif
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+class ProtoDispatcher;
+#endif
+
+/**
+ * Defines what Proto does with received frame, when there are no free packets in Rx pool
+ */
+enum class RxOverflow : uint8_t
+{
+    /** New frame is dropped and counted as lost (default) */
+    DROP_NEWEST,
+    /** The oldest frame, not read by application yet, is replaced with the new one */
+    DROP_OLDEST,
+    /**
+     * Received data is left in the link until application releases packet. For FD links
+     * this stops acknowledging of I-frames, so the remote side stalls on its window.
+     */
+    BACKPRESSURE,
+};
+
 class Proto
 {
 public:
@@ -75,38 +106,117 @@ public:
 
     IPacket *read(uint32_t timeout);
 
+    /**
+     * Reads several received packets at once. The method waits up to timeout for the first packet,
+     * and then takes all other packets, which are already received, without waiting.
+     * Every returned packet must be released via release().
+     * @param packets array to store pointers to received packets
+     * @param count maximum number of packets to read
+     * @param timeout timeout in milliseconds to wait for the first packet
+     * @return number of packets read
+     */
+    int readMany(IPacket **packets, int count, uint32_t timeout);
+
     void end();
 
     void release(IPacket *message);
 
-    void addRxPool(IPacket &message);
+    /**
+     * Registers packet to store received frames. Proto can hold up to
+     * CONFIG_TINYPROTO_RX_QUEUE_SIZE packets, refer to PacketRing::CAPACITY.
+     * @param message packet to register
+     * @return false if the pool is full and the packet is not registered
+     */
+    bool addRxPool(IPacket &message);
 
     void setRxCallback(void (*onRx)(Proto &, IPacket &));
 
+    /**
+     * Sets user data, which can be accessed from Rx callback via getUserData()
+     * @param userData user data
+     */
+    void setUserData(void *userData)
+    {
+        m_userData = userData;
+    }
+
+    /**
+     * Returns user data, set by setUserData()
+     */
+    void *getUserData() const
+    {
+        return m_userData;
+    }
+
+    /**
+     * Sets policy for received frames, when Rx pool is empty. Default is RxOverflow::DROP_NEWEST.
+     * Must be called before begin().
+     */
+    void setRxOverflow(RxOverflow policy);
+
 #if CONFIG_TINYHAL_THREAD_SUPPORT == 1
     void setTxDelay( uint32_t delay );
 
     int getLostRxFrames();
+
+    /**
+     * Returns awaitable for C++20 coroutines: co_await proto.asyncRead() suspends the coroutine
+     * until the packet is received. Resumed coroutine gets the packet, which must be released
+     * via release(), or nullptr if end() is called. The link must be driven by Proto threads
+     * (multithread mode) or ProtoReactor. Not applicable, if Rx callback or dispatcher is set.
+     * @param executor executor to resume the coroutine in, if nullptr the coroutine is resumed
+     *        by the thread, which has received the packet
+     */
+    ProtoReadAwaiter asyncRead(ProtoExecutor *executor = nullptr);
+
+    /**
+     * Returns awaitable for C++20 coroutines: co_await proto.asyncSend(packet) suspends the coroutine
+     * until the packet is put to the link Tx queue. Resumed coroutine gets true on success,
+     * or false if end() is called. The packet must stay valid until the coroutine is resumed.
+     * @param packet packet to send
+     * @param executor executor to resume the coroutine in, if nullptr the coroutine is resumed
+     *        by the thread, which drives the link
+     */
+    ProtoSendAwaiter asyncSend(const IPacket &packet, ProtoExecutor *executor = nullptr);
 #endif
 
 private:
     ILinkLayer *m_link = nullptr;
     void (*m_onRx)(Proto &, IPacket &) = nullptr;
+    void *m_userData = nullptr;
     bool m_multithread = false;
     bool m_terminate = true;
-    IPacket *m_pool = nullptr;
-    IPacket *m_queue = nullptr;
-    IPacket *m_last = nullptr;
+    RxOverflow m_rxOverflow = RxOverflow::DROP_NEWEST;
+    PacketRing m_pool;
+    PacketRing m_queue;
+    int m_lostRxFrames = 0;
 #if CONFIG_TINYHAL_THREAD_SUPPORT == 1
     std::thread *m_sendThread = nullptr;
     std::thread *m_readThread = nullptr;
     uint32_t m_txDelay = 0;
-    int m_lostRxFrames = 0;
+    HeapPacket **m_heapPool = nullptr;
+    int m_heapPoolSize = 0;
+    ProtoDispatcher *m_dispatcher = nullptr;
+    int m_strand = 0;
+    std::mutex m_asyncMutex;
+    ProtoAsyncQueue m_asyncReads;
+    ProtoAsyncQueue m_asyncSends;
+    int m_asyncReadsCount = 0;
+    int m_asyncSendsCount = 0;
+
+    friend class ProtoDispatcher;
+    friend class ProtoReadAwaiter;
+    friend class ProtoSendAwaiter;
 #endif
+#if CONFIG_TINYPROTO_REACTOR == 1
+    ProtoReactor *m_reactor = nullptr;
+    int m_shard = 0;
+    uint32_t m_reactorEvents = 0; // epoll events of the link, 0 if the link is not in epoll
 
-    tiny_events_t m_events{};
+    friend class ProtoReactor;
+#endif
 
-    tiny_mutex_t m_mutex{};
+    tiny_events_t m_events{};
 
     void onRead(uint8_t addr, uint8_t *buf, int len);
 
@@ -116,13 +226,44 @@ private:
 
     static void onSendCb(void *udata, uint8_t addr, const uint8_t *buf, int len);
 
+    /** Returns true if Rx/Tx loops are executed by other threads, not by send() and read() */
+    bool isDriven() const;
+
+    /** Returns false if received data must be left in the link due to backpressure */
+    bool canReceive() const;
+
+    /** Wakes up Rx loop, waiting for free packets due to backpressure */
+    void notifyRxSpace();
+
+    void runLink();
+
+    void countLostFrame();
+
+    /** Stops parsing of received data in the link, when the next frame has no space due to backpressure */
+    void holdRxIfFull();
+
+    /** Puts packet to link Tx queue and wakes up the thread, serving the link */
+    bool putTx(const IPacket &packet, uint32_t timeout);
+
 #if CONFIG_TINYHAL_THREAD_SUPPORT == 1
     void runTx();
 
     void runRx();
-#endif
 
-//    void printCount(const char *, IPacket *queue);
+    /** Returns true if operation is pending, and false if it is completed immediately */
+    bool startRead(ProtoAsyncOp &op);
+
+    bool startSend(ProtoAsyncOp &op);
+
+    /** Passes received packets to awaiting coroutines */
+    void completeAsyncReads();
+
+    /** Retries pending asynchronous sends, must be called after each Tx/Rx step of the link */
+    void completeAsyncSends();
+
+    /** Completes all pending asynchronous operations with failure */
+    void cancelAsync();
+#endif
 };
 
 /////// Helper classes, platform specific
@@ -65,12 +65,20 @@ void IFd::begin()
     init.on_connect_event_cb = onConnectEventInternal;
     init.buffer = m_buffer;
     init.buffer_size = m_bufferSize;
-    init.window_frames = m_window;
-    init.send_timeout = m_sendTimeout;
-    init.retry_timeout = 200;
-    init.retries = 2;
-    init.crc_type = m_crc;
-    init.mode = TINY_FD_MODE_ABM;
+    init.window_frames = m_config.window;
+    init.send_timeout = m_config.sendTimeout;
+    init.retry_timeout = m_config.retryTimeout;
+    init.retry_timeout_us = m_config.retryTimeoutUs;
+    init.retries = m_config.retries;
+    init.ka_timeout_us = m_config.keepAliveUs;
+    init.crc_type = m_config.crc;
+    init.mtu = m_config.mtu;
+    init.mode = m_config.mode;
+    init.addr = m_config.addr;
+    init.peers_count = m_config.peersCount;
+    init.channels = m_config.channels;
+    init.urgent_slots = m_config.urgentSlots;
+    init.io_chunk_size = m_config.ioChunkSize;
 
     tiny_fd_init(&m_handle, &init);
 }
@@ -84,12 +92,17 @@ void IFd::end()
 
 int IFd::write(const char *buf, int size)
 {
-    return tiny_fd_send_packet(m_handle, buf, size, m_sendTimeout);
+    return tiny_fd_send_packet(m_handle, buf, size, m_config.sendTimeout);
 }
 
 int IFd::write(const IPacket &pkt)
 {
-    return tiny_fd_send_packet(m_handle, pkt.m_buf, pkt.m_len, m_sendTimeout);
+    return tiny_fd_send_packet(m_handle, pkt.m_buf, pkt.m_len, m_config.sendTimeout);
+}
+
+int IFd::sendBatch(const tiny_iovec_t *msgs, int count)
+{
+    return tiny_fd_send_batch(m_handle, TINY_FD_PRIMARY_ADDR, msgs, count, m_config.sendTimeout);
 }
 
 int IFd::run_rx(const void *data, int len)
@@ -99,13 +112,21 @@ int IFd::run_rx(const void *data, int len)
 
 int IFd::run_rx(read_block_cb_t read_func)
 {
-    uint8_t buf[4];
-    int len = read_func(m_userData, buf, sizeof(buf));
-    if ( len <= 0 )
+    uint8_t buf[TINY_FD_IO_CHUNK_SIZE];
+    bool processed = false;
+    int result = TINY_SUCCESS;
+    int len;
+    do
     {
-        return len;
-    }
-    return tiny_fd_on_rx_data(m_handle, buf, len);
+        len = read_func(m_userData, buf, m_config.ioChunkSize);
+        if ( len <= 0 )
+        {
+            return processed ? result : len;
+        }
+        result = tiny_fd_on_rx_data(m_handle, buf, len);
+        processed = true;
+    } while ( len == m_config.ioChunkSize );
+    return result;
 }
 
 int IFd::run_tx(void *data, int max_size)
@@ -115,51 +136,60 @@ int IFd::run_tx(void *data, int max_size)
 
 int IFd::run_tx(write_block_cb_t write_func)
 {
-    uint8_t buf[4];
-    int len = tiny_fd_get_tx_data(m_handle, buf, sizeof(buf), 0);
+    uint8_t buf[TINY_FD_IO_CHUNK_SIZE];
+    int len = tiny_fd_get_tx_data(m_handle, buf, m_config.ioChunkSize, 0);
     if ( len <= 0 )
     {
         return len;
     }
-    uint8_t *ptr = buf;
-    while ( len )
+    while ( len > 0 )
     {
-        int result = write_func(m_userData, ptr, len);
-        if ( result < 0 )
+        uint8_t *ptr = buf;
+        int size = len;
+        while ( size )
+        {
+            int result = write_func(m_userData, ptr, size);
+            if ( result < 0 )
+            {
+                return result;
+            }
+            size -= result;
+            ptr += result;
+        }
+        if ( len < m_config.ioChunkSize )
         {
-            return result;
+            break;
         }
-        len -= result;
-        ptr += result;
+        len = tiny_fd_get_tx_data(m_handle, buf, m_config.ioChunkSize, 0);
     }
     return TINY_SUCCESS;
 }
 
 void IFd::disableCrc()
 {
-    m_crc = HDLC_CRC_OFF;
+    m_config.crc = HDLC_CRC_OFF;
 }
 
 void IFd::enableCrc(hdlc_crc_t crc)
 {
-    m_crc = crc;
+    m_config.crc = crc;
 }
 
 bool IFd::enableCheckSum()
 {
-    m_crc = HDLC_CRC_8;
+    m_config.crc = HDLC_CRC_8;
     return true;
 }
 
 bool IFd::enableCrc16()
 {
-    m_crc = HDLC_CRC_16;
+    m_config.crc = HDLC_CRC_16;
     return true;
 }
 
 bool IFd::enableCrc32()
 {
-    m_crc = HDLC_CRC_32;
+    m_config.crc = HDLC_CRC_32;
     return true;
 }
 
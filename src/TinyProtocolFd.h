@@ -37,6 +37,7 @@
 
 #include "TinyPacket.h"
 #include "proto/fd/tiny_fd.h"
+#include "proto/fd/tiny_fd_int.h"
 
 #ifdef ARDUINO
 #include <HardwareSerial.h>
@@ -53,6 +54,56 @@ namespace tinyproto
  * @{
  */
 
+/**
+ * Connection parameters of Full Duplex protocol, passed to tiny_fd_init() by IFd::begin().
+ * Default values are suitable for point-to-point ABM link on small controllers.
+ * For the meaning of the fields refer to tiny_fd_init_t.
+ */
+struct FdConfig
+{
+    /** Communication link mode: TINY_FD_MODE_ABM, TINY_FD_MODE_NRM */
+    uint8_t mode = TINY_FD_MODE_ABM;
+
+    /** Local station address, meaningful for secondary stations only */
+    uint8_t addr = 0;
+
+    /** Maximum number of peers, supported by primary station. 0 means single peer */
+    uint8_t peersCount = 0;
+
+    /** Number of frames, which confirmation may be deferred for (2 - 7) */
+    uint8_t window = 3;
+
+    /** Maximum payload size. If 0, it is calculated from the buffer size */
+    int mtu = 0;
+
+    /** Crc field type */
+    hdlc_crc_t crc = HDLC_CRC_DEFAULT;
+
+    /** Timeout in milliseconds for blocking send operations */
+    uint16_t sendTimeout = 0;
+
+    /** Timeout in milliseconds before I-frame is resent */
+    uint16_t retryTimeout = 200;
+
+    /** Timeout in microseconds before I-frame is resent. If not 0, it overrides retryTimeout */
+    uint32_t retryTimeoutUs = 0;
+
+    /** Number of retries before the connection is considered to be lost */
+    uint8_t retries = 2;
+
+    /** Keep alive timeout in microseconds. If 0, protocol default is used */
+    uint32_t keepAliveUs = 0;
+
+    /** Number of logical channels, 0 disables channels */
+    uint8_t channels = 0;
+
+    /** Number of I-queue slots, reserved for urgent frames */
+    uint8_t urgentSlots = 0;
+
+    /** Number of bytes to read/write by single callback call, limited by TINY_FD_IO_CHUNK_SIZE */
+    int ioChunkSize = TINY_FD_IO_CHUNK_SIZE;
+};
+
 /**
  *  IFd class incapsulates Full Duplex Protocol functionality.
  *  Full Duplex version of the Protocol allows to send messages with
@@ -111,6 +162,16 @@ public:
      */
     int write(const IPacket &pkt);
 
+    /**
+     * Sends several messages over communication channel at once.
+     * All messages, which fit the outgoing queue, are queued under single lock.
+     * @param msgs - array of messages to send
+     * @param count - number of messages in the array
+     * @return negative value in case of error
+     *         otherwise number of messages accepted for sending
+     */
+    int sendBatch(const tiny_iovec_t *msgs, int count);
+
     /**
      * Processes incoming rx data, specified by a user.
      * @param data pointer to the buffer with incoming data
@@ -214,6 +275,24 @@ public:
         m_onConnectEvent = on_connect;
     }
 
+    /**
+     * Sets all connection parameters at once. Use this function only before begin() call.
+     * @param config connection parameters
+     */
+    void setConfig(const FdConfig &config)
+    {
+        m_config = config;
+        setIoChunkSize(config.ioChunkSize);
+    }
+
+    /**
+     * Returns connection parameters, which are used by begin()
+     */
+    const FdConfig &getConfig() const
+    {
+        return m_config;
+    }
+
     /**
      * Sets desired window size. Use this function only before begin() call.
      * window size is number of frames, which confirmation may be deferred for.
@@ -222,7 +301,17 @@ public:
      */
     void setWindowSize(uint8_t window)
     {
-        m_window = window;
+        m_config.window = window;
+    }
+
+    /**
+     * Sets number of bytes, passed to read/write callbacks by run_rx() and run_tx() in one call.
+     * Use this function only before begin() call.
+     * @param size chunk size in bytes, limited by TINY_FD_IO_CHUNK_SIZE
+     */
+    void setIoChunkSize(int size)
+    {
+        m_config.ioChunkSize = (size > 0 && size < TINY_FD_IO_CHUNK_SIZE) ? size : TINY_FD_IO_CHUNK_SIZE;
     }
 
     /**
@@ -231,7 +320,7 @@ public:
      */
     void setSendTimeout(uint16_t timeout)
     {
-        m_sendTimeout = timeout;
+        m_config.sendTimeout = timeout;
     }
 
     /**
@@ -259,6 +348,17 @@ public:
         return tiny_fd_get_status(m_handle);
     }
 
+    /**
+     * Returns protocol counters for the peer.
+     * @param stats structure to copy counters to
+     * @param address address of the peer, TINY_FD_PRIMARY_ADDR for point-to-point connection
+     * @return TINY_SUCCESS or negative error code
+     */
+    int getStats(tiny_fd_stats_t &stats, uint8_t address = TINY_FD_PRIMARY_ADDR)
+    {
+        return tiny_fd_get_stats(m_handle, address, &stats);
+    }
+
 protected:
     /**
      * Method called by hdlc protocol upon receiving new frame.
@@ -309,16 +409,11 @@ private:
     /** buffer to receive data to */
     uint8_t *m_buffer = nullptr;
 
-    hdlc_crc_t m_crc = HDLC_CRC_DEFAULT;
-
     /** max buffer size */
     int m_bufferSize = 0;
 
-    /** Use 0-value timeout for small controllers as all operations should be non-blocking */
-    uint16_t m_sendTimeout = 0;
-
-    /** Limit window to only 3 frames for small controllers by default */
-    uint8_t m_window = 3;
+    /** Connection parameters */
+    FdConfig m_config{};
 
     /** Callback, when new frame is received */
     void (*m_onReceive)(void *userData, uint8_t addr, IPacket &pkt) = nullptr;
@@ -357,6 +452,28 @@ private:
     TINY_ALIGNED_STRUCT uint8_t m_data[S]{};
 };
 
+/**
+ * This is class, which allocates buffer statically, sized exactly for specified mtu and windows.
+ * Window size, mtu and crc are passed to the protocol automatically.
+ * @tparam MTU maximum payload size in bytes
+ * @tparam TX_WINDOW number of frames, which confirmation may be deferred for (2 - 7)
+ * @tparam RX_WINDOW number of received frames, which can be stored on hdlc level
+ * @tparam CRC crc type. Do not enable crc of bigger size later, since the buffer is sized for this one.
+ */
+template <int MTU, int TX_WINDOW = 3, int RX_WINDOW = 1, hdlc_crc_t CRC = HDLC_CRC_DEFAULT>
+class StaticFd: public Fd<FD_BUF_SIZE_EX(MTU, TX_WINDOW, CRC, RX_WINDOW)>
+{
+public:
+    StaticFd()
+    {
+        FdConfig config{};
+        config.mtu = MTU;
+        config.window = TX_WINDOW;
+        config.crc = CRC;
+        this->setConfig(config);
+    }
+};
+
 /**
  * This is special class for Full duplex protocol, which allocates buffers dynamically.
  * We need to have separate class for this, as on small microcontrollers dynamic allocation
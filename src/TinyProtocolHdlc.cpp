@@ -99,6 +99,11 @@ int Hdlc::run_tx(void *data, int max_len)
     return hdlc_get_tx_data(m_handle, data, max_len);
 }
 
+int Hdlc::run_tx()
+{
+    return hdlc_run_tx(m_handle);
+}
+
 void Hdlc::disableCrc()
 {
     m_crc = HDLC_CRC_OFF;
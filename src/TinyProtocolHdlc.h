@@ -134,6 +134,25 @@ public:
      */
     int run_tx(void *data, int max_len);
 
+    /**
+     * Sends queued data via write callback, passed to begin(). Data are encoded into
+     * block buffer, and the callback is called once per block. The method returns
+     * immediately, if the callback accepts 0 bytes.
+     * @return number of bytes sent, or negative value in case of error
+     */
+    int run_tx();
+
+    /**
+     * Sets block buffer for encoded data. Use this function only before begin() call.
+     * @param buf buffer, must be available until end() is called
+     * @param size size of the buffer in bytes
+     */
+    void setTxBuffer(void *buf, int size)
+    {
+        m_data.tx_buf = buf;
+        m_data.tx_buf_size = size;
+    }
+
     /**
      * Disable CRC field in the protocol.
      * If CRC field is OFF, then the frame looks like this:
@@ -194,6 +213,18 @@ public:
         m_onSend = on_send;
     };
 
+    /**
+     * Sets array of slots for outgoing frames, so write() can queue several frames.
+     * Use this function only before begin() call.
+     * @param queue array of slots, must be available until end() is called
+     * @param size number of slots in the array
+     */
+    void setTxQueue(tiny_iovec_t *queue, int size)
+    {
+        m_data.tx_queue = queue;
+        m_data.tx_queue_size = size;
+    }
+
 protected:
     /**
      * Method called by hdlc protocol upon receiving new frame.
@@ -81,6 +81,10 @@ int _free_lock(int status)
 
 #include "../single_core/hal_single_core.inl"
 
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_timer.h>
+#endif
+
 void tiny_sleep(uint32_t ms)
 {
     delay(ms);
@@ -100,3 +104,28 @@ uint32_t tiny_micros()
 {
     return micros();
 }
+
+uint64_t tiny_micros64()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    // Both cores share 64-bit hardware timer
+    return (uint64_t)esp_timer_get_time();
+#else
+    // Extend 32-bit counter, it is enough to call the function at least once per 71 minutes
+    // The counter is extended under lock, so concurrent callers cannot increment high part twice
+    static uint32_t last = 0;
+    static uint32_t high = 0;
+    uint64_t result = 0;
+    ATOMIC_BLOCK
+    {
+        uint32_t ts = tiny_micros();
+        if ( ts < last )
+        {
+            high++;
+        }
+        last = ts;
+        result = ((uint64_t)high << 32) | ts;
+    }
+    return result;
+#endif
+}
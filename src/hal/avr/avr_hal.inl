@@ -95,3 +95,23 @@ uint32_t tiny_micros()
     return 0;
 #endif
 }
+
+uint64_t tiny_micros64()
+{
+    // Extend 32-bit counter, it is enough to call the function at least once per 71 minutes
+    // Interrupts are disabled, so an interrupt handler cannot increment high part twice
+    static uint32_t last = 0;
+    static uint32_t high = 0;
+    uint64_t result = 0;
+    ATOMIC_BLOCK
+    {
+        uint32_t ts = tiny_micros();
+        if ( ts < last )
+        {
+            high++;
+        }
+        last = ts;
+        result = ((uint64_t)high << 32) | ts;
+    }
+    return result;
+}
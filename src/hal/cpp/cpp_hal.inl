@@ -90,3 +90,7 @@ uint32_t tiny_micros(void)
 {
 }
 
+uint64_t tiny_micros64(void)
+{
+}
+
@@ -106,3 +106,8 @@ uint32_t tiny_micros()
 {
     return (uint32_t)(esp_timer_get_time());
 }
+
+uint64_t tiny_micros64()
+{
+    return (uint64_t)esp_timer_get_time();
+}
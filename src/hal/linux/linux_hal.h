@@ -61,10 +61,8 @@ typedef pthread_mutex_t tiny_mutex_t;
  */
 typedef struct
 {
-    uint8_t bits;
-    uint16_t waiters;
-    pthread_mutex_t mutex;
-    pthread_cond_t cond;
+    uint32_t bits;    // futex word, only low 8 bits are used for events
+    uint32_t waiters; // number of threads sleeping on the futex
 } tiny_events_t;
 
 #endif
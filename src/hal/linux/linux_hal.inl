@@ -31,6 +31,9 @@
 #include <stdint.h>
 #include <time.h>
 #include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 
 void tiny_mutex_create(tiny_mutex_t *mutex)
 {
@@ -57,26 +60,58 @@ void tiny_mutex_unlock(tiny_mutex_t *mutex)
     pthread_mutex_unlock(mutex);
 }
 
-void tiny_events_create(tiny_events_t *events)
+/*
+ * Events are implemented as atomic bitmask, which is also used as futex word.
+ * Setting, clearing and checking bits never takes a lock. The futex syscall is used only
+ * when a thread needs to sleep, and tiny_events_set() wakes threads only if there are waiters.
+ */
+
+static long tiny_futex(uint32_t *addr, int op, uint32_t val, const struct timespec *ts)
 {
-    events->bits = 0;
-    events->waiters = 0;
+    return syscall(SYS_futex, addr, op | FUTEX_PRIVATE_FLAG, val, ts, NULL, FUTEX_BITSET_MATCH_ANY);
+}
 
-    pthread_mutex_init(&events->mutex, NULL);
-    pthread_condattr_t condattr;
-    pthread_condattr_init(&condattr);
-    pthread_condattr_setclock(&condattr, CLOCK_MONOTONIC);
-    pthread_cond_init(&events->cond, &condattr);
+void tiny_events_create(tiny_events_t *events)
+{
+    __atomic_store_n(&events->bits, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&events->waiters, 0, __ATOMIC_RELAXED);
 }
 
 void tiny_events_destroy(tiny_events_t *events)
 {
-    pthread_cond_destroy(&events->cond);
-    pthread_mutex_destroy(&events->mutex);
+    (void)events;
+}
+
+static uint8_t tiny_events_try_take(tiny_events_t *events, uint8_t bits, uint8_t clear, uint32_t *value)
+{
+    uint32_t current = __atomic_load_n(&events->bits, __ATOMIC_ACQUIRE);
+    for ( ;; )
+    {
+        if ( (current & bits) == 0 )
+        {
+            *value = current;
+            return 0;
+        }
+        if ( !clear || __atomic_compare_exchange_n(&events->bits, &current, current & ~(uint32_t)bits, 0,
+                                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) )
+        {
+            *value = current;
+            return 1;
+        }
+    }
 }
 
 uint8_t tiny_events_wait(tiny_events_t *events, uint8_t bits, uint8_t clear, uint32_t timeout)
 {
+    uint32_t value;
+    if ( tiny_events_try_take(events, bits, clear, &value) )
+    {
+        return (uint8_t)value;
+    }
+    if ( timeout == 0 )
+    {
+        return 0;
+    }
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
     ts.tv_sec += timeout / 1000;
@@ -86,54 +121,46 @@ uint8_t tiny_events_wait(tiny_events_t *events, uint8_t bits, uint8_t clear, uin
         ts.tv_nsec -= 1000000000LL;
         ts.tv_sec++;
     }
-    pthread_mutex_lock(&events->mutex);
-    events->waiters++;
-    int res = 0;
-    while ( (events->bits & bits) == 0 )
+    uint8_t locked = 0;
+    __atomic_fetch_add(&events->waiters, 1, __ATOMIC_SEQ_CST);
+    for ( ;; )
     {
-        if ( timeout == 0xFFFFFFFF )
+        // The check must follow waiters increment, so tiny_events_set() either sees the waiter or
+        // we see new bits. The futex refuses to sleep if the word has changed since the check.
+        if ( tiny_events_try_take(events, bits, clear, &value) )
         {
-            pthread_cond_wait(&events->cond, &events->mutex);
+            locked = (uint8_t)value;
+            break;
         }
-        else
+        // FUTEX_WAIT_BITSET takes absolute CLOCK_MONOTONIC timeout
+        long res = tiny_futex(&events->bits, FUTEX_WAIT_BITSET, value, timeout == 0xFFFFFFFF ? NULL : &ts);
+        if ( res < 0 && errno == ETIMEDOUT )
         {
-            res = pthread_cond_timedwait(&events->cond, &events->mutex, &ts);
-            if ( res == ETIMEDOUT )
-            {
-                break;
-            }
+            break;
         }
     }
-    uint8_t locked = 0;
-    if ( res != ETIMEDOUT )
-    {
-        locked = events->bits;
-        if ( clear )
-            events->bits &= ~bits;
-    }
-    events->waiters--;
-    pthread_mutex_unlock(&events->mutex);
+    __atomic_fetch_sub(&events->waiters, 1, __ATOMIC_SEQ_CST);
     return locked;
 }
 
 uint8_t tiny_events_check_int(tiny_events_t *event, uint8_t bits, uint8_t clear)
 {
-    return tiny_events_wait(event, bits, clear, 0);
+    uint32_t value;
+    return tiny_events_try_take(event, bits, clear, &value) ? (uint8_t)value : 0;
 }
 
 void tiny_events_set(tiny_events_t *events, uint8_t bits)
 {
-    pthread_mutex_lock(&events->mutex);
-    events->bits |= bits;
-    pthread_cond_broadcast(&events->cond);
-    pthread_mutex_unlock(&events->mutex);
+    uint32_t prev = __atomic_fetch_or(&events->bits, bits, __ATOMIC_SEQ_CST);
+    if ( (prev | bits) != prev && __atomic_load_n(&events->waiters, __ATOMIC_SEQ_CST) )
+    {
+        tiny_futex(&events->bits, FUTEX_WAKE_BITSET, INT_MAX, NULL);
+    }
 }
 
 void tiny_events_clear(tiny_events_t *events, uint8_t bits)
 {
-    pthread_mutex_lock(&events->mutex);
-    events->bits &= ~bits;
-    pthread_mutex_unlock(&events->mutex);
+    __atomic_fetch_and(&events->bits, ~(uint32_t)bits, __ATOMIC_RELEASE);
 }
 
 void tiny_sleep(uint32_t millis)
@@ -159,3 +186,10 @@ uint32_t tiny_micros()
     clock_gettime(CLOCK_MONOTONIC, &ts);
     return (ts.tv_sec * 1000000) + ts.tv_nsec / 1000;
 }
+
+uint64_t tiny_micros64()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
@@ -41,6 +41,19 @@ extern "C"
 /** Invalid serial handle definition */
 #define TINY_SERIAL_INVALID (-1)
 
+/** Maximum length of the name in "shm:<name>" port names */
+#define TINY_SHM_MAX_NAME_LEN 92
+
+    /**
+     * Returns file descriptor of the serial port. The descriptor is always in non-blocking mode,
+     * so it can be registered in epoll/select loop. When the port becomes readable,
+     * tiny_serial_read_timeout() with zero timeout returns all available bytes.
+     *
+     * @param port handle to serial port
+     * @return file descriptor or -1 if the handle is not valid
+     */
+    extern int tiny_serial_get_fd(tiny_serial_handle_t port);
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,24 +40,167 @@
 #include <poll.h>
 #include <time.h>
 
+#include "linux_shm_serial.inl"
+
 #define DEBUG_SERIAL 0
 #define DEBUG_SERIAL_TX DEBUG_SERIAL
 #define DEBUG_SERIAL_RX DEBUG_SERIAL
 
-static uint32_t bits_to_baud(uint32_t bits)
+/* termios2 allows to set arbitrary baud rate via BOTHER flag. <asm/termbits.h> cannot be included
+ * together with <termios.h>, so the structure is declared here for architectures, using
+ * asm-generic termios layout. */
+#if defined(__x86_64__) || defined(__i386__) || defined(__arm__) || defined(__aarch64__) || defined(__riscv)
+#define TINY_SERIAL_TERMIOS2 1
+
+struct tiny_termios2
+{
+    tcflag_t c_iflag;
+    tcflag_t c_oflag;
+    tcflag_t c_cflag;
+    tcflag_t c_lflag;
+    cc_t c_line;
+    cc_t c_cc[19];
+    speed_t c_ispeed;
+    speed_t c_ospeed;
+};
+
+#define TINY_TCGETS2 _IOR('T', 0x2A, struct tiny_termios2)
+#define TINY_TCSETS2 _IOW('T', 0x2B, struct tiny_termios2)
+#define TINY_BOTHER 0x00001000
+#define TINY_IBSHIFT 16
+#else
+#define TINY_SERIAL_TERMIOS2 0
+#endif
+
+static const struct
+{
+    uint32_t bits;
+    speed_t speed;
+} s_baud_rates[] = {
+    {50, B50},           {75, B75},           {110, B110},         {134, B134},         {150, B150},
+    {200, B200},         {300, B300},         {600, B600},         {1200, B1200},       {1800, B1800},
+    {2400, B2400},       {4800, B4800},       {9600, B9600},       {19200, B19200},     {38400, B38400},
+    {57600, B57600},     {115200, B115200},   {230400, B230400},
+#ifdef B460800
+    {460800, B460800},
+#endif
+#ifdef B500000
+    {500000, B500000},
+#endif
+#ifdef B576000
+    {576000, B576000},
+#endif
+#ifdef B921600
+    {921600, B921600},
+#endif
+#ifdef B1000000
+    {1000000, B1000000},
+#endif
+#ifdef B1152000
+    {1152000, B1152000},
+#endif
+#ifdef B1500000
+    {1500000, B1500000},
+#endif
+#ifdef B2000000
+    {2000000, B2000000},
+#endif
+#ifdef B2500000
+    {2500000, B2500000},
+#endif
+#ifdef B3000000
+    {3000000, B3000000},
+#endif
+#ifdef B3500000
+    {3500000, B3500000},
+#endif
+#ifdef B4000000
+    {4000000, B4000000},
+#endif
+};
+
+/* Returns 0 and the speed constant if baud rate is one of standard rates, -1 otherwise */
+static int bits_to_baud(uint32_t bits, speed_t *speed)
+{
+    for ( unsigned i = 0; i < sizeof(s_baud_rates) / sizeof(s_baud_rates[0]); i++ )
+    {
+        if ( s_baud_rates[i].bits == bits )
+        {
+            *speed = s_baud_rates[i].speed;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* Sets non-standard baud rate using termios2 interface */
+static int set_custom_baud(int fd, uint32_t baud)
+{
+#if TINY_SERIAL_TERMIOS2
+    struct tiny_termios2 options;
+    if ( ioctl(fd, TINY_TCGETS2, &options) == -1 )
+    {
+        return -1;
+    }
+    options.c_cflag &= ~(CBAUD | (CBAUD << TINY_IBSHIFT));
+    options.c_cflag |= TINY_BOTHER | (TINY_BOTHER << TINY_IBSHIFT);
+    options.c_ispeed = baud;
+    options.c_ospeed = baud;
+    return ioctl(fd, TINY_TCSETS2, &options);
+#else
+    (void)fd;
+    (void)baud;
+    errno = EINVAL;
+    return -1;
+#endif
+}
+
+/* Asks the driver to push received bytes to the tty layer immediately, if supported */
+static void set_low_latency(int fd)
+{
+#if defined(TIOCGSERIAL) && defined(TIOCSSERIAL) && defined(ASYNC_LOW_LATENCY)
+    struct serial_struct serial;
+    if ( ioctl(fd, TIOCGSERIAL, &serial) == 0 )
+    {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        ioctl(fd, TIOCSSERIAL, &serial);
+    }
+#else
+    (void)fd;
+#endif
+}
+
+/* Waits until the port becomes ready for specified poll events. Returns positive value if ready */
+static int wait_ready(tiny_serial_handle_t port, short events, uint32_t timeout_ms)
+{
+    struct pollfd fds = {.fd = port, .events = events};
+    int ret;
+    do
+    {
+        ret = poll(&fds, 1, timeout_ms);
+    } while ( ret < 0 && errno == EINTR );
+    if ( ret > 0 && !(fds.revents & events) )
+    {
+        // POLLERR or POLLHUP
+        return -1;
+    }
+    return ret;
+}
+
+int tiny_serial_get_fd(tiny_serial_handle_t port)
 {
-    if ( bits == 115200 )
-        return B115200;
-    if ( bits == 57600 )
-        return B57600;
-    if ( bits == 38400 )
-        return B38400;
-    return B9600;
+    tiny_shm_port_t *shm = tiny_shm_find(port);
+    return shm ? tiny_shm_get_fd(shm) : port;
 }
 
 void tiny_serial_close(tiny_serial_handle_t port)
 {
-    if ( port >= 0 )
+    tiny_shm_port_t *shm = tiny_shm_find(port);
+    if ( shm )
+    {
+        tiny_shm_close(shm);
+    }
+    else if ( port >= 0 )
     {
         close(port);
     }
@@ -67,15 +210,20 @@ tiny_serial_handle_t tiny_serial_open(const char *name, uint32_t baud)
 {
     struct termios options;
     struct termios oldt;
-    //    struct serial_struct serial;
 
+    if ( strncmp(name, "shm:", 4) == 0 )
+    {
+        return tiny_shm_open(name + 4);
+    }
+
+    /* The port always stays in non-blocking mode: read and write functions wait for readiness
+     * via poll() only when needed, so the descriptor can be also used with epoll/select directly. */
     int fd = open(name, O_RDWR | O_NOCTTY | O_NONBLOCK);
     if ( fd == -1 )
     {
         perror("ERROR: Failed to open serial device");
         return TINY_SERIAL_INVALID;
     }
-    fcntl(fd, F_SETFL, O_RDWR);
 
     if ( tcgetattr(fd, &oldt) == -1 )
     {
@@ -96,24 +244,32 @@ tiny_serial_handle_t tiny_serial_open(const char *name, uint32_t baud)
     options.c_cflag &= ~CRTSCTS;
     options.c_iflag &= ~(IXON | IXOFF | IXANY); // turn off s/w flow ctrl
 
-    if ( cfsetspeed(&options, bits_to_baud(baud)) == -1 )
+    speed_t speed;
+    int custom_baud = bits_to_baud(baud, &speed) < 0;
+    if ( custom_baud )
+    {
+        // Non-standard rate is applied via termios2 after all other settings are done
+        speed = B38400;
+    }
+    if ( cfsetspeed(&options, speed) == -1 )
     {
         close(fd);
         return TINY_SERIAL_INVALID;
     }
-    if ( cfsetospeed(&options, bits_to_baud(baud)) == -1 )
+    if ( cfsetospeed(&options, speed) == -1 )
     {
         close(fd);
         return TINY_SERIAL_INVALID;
     }
-    if ( cfsetispeed(&options, bits_to_baud(baud)) == -1 )
+    if ( cfsetispeed(&options, speed) == -1 )
     {
         close(fd);
         return TINY_SERIAL_INVALID;
     }
 
+    // No inter-byte timer: read() returns immediately with all available bytes
     options.c_cc[VMIN] = 0;
-    options.c_cc[VTIME] = 1; // 100 ms
+    options.c_cc[VTIME] = 0;
 
     // Set the new options for the port...
     if ( tcsetattr(fd, TCSAFLUSH, &options) == -1 )
@@ -121,9 +277,13 @@ tiny_serial_handle_t tiny_serial_open(const char *name, uint32_t baud)
         close(fd);
         return TINY_SERIAL_INVALID;
     }
-    /*    ioctl(fd, TIOCGSERIAL, &serial);
-        serial.xmit_fifo_size = 1;
-        ioctl(fd, TIOCSSERIAL, &serial);*/
+    if ( custom_baud && set_custom_baud(fd, baud) == -1 )
+    {
+        fprintf(stderr, "ERROR: Unsupported baud rate %u: %s\n", baud, strerror(errno));
+        close(fd);
+        return TINY_SERIAL_INVALID;
+    }
+    set_low_latency(fd);
 
     // Flush any buffered characters
     tcflush(fd, TCIOFLUSH);
@@ -138,23 +298,22 @@ int tiny_serial_send(tiny_serial_handle_t port, const void *buf, int len)
 
 int tiny_serial_send_timeout(tiny_serial_handle_t port, const void *buf, int len, uint32_t timeout_ms)
 {
-    int ret;
-    struct pollfd fds = {.fd = port, .events = POLLOUT | POLLWRNORM};
-write_poll:
-    ret = poll(&fds, 1, timeout_ms);
-    if ( ret < 0 )
+    tiny_shm_port_t *shm = tiny_shm_find(port);
+    if ( shm )
     {
-        if ( errno == EINTR )
-        {
-            goto write_poll;
-        }
-        return ret;
+        return tiny_shm_send(shm, buf, len, timeout_ms);
     }
-    if ( ret == 0 || !(fds.revents & (POLLOUT | POLLWRNORM)) )
+    int ret = write(port, buf, len);
+    if ( ret < 0 && (errno == EAGAIN || errno == EINTR) )
     {
-        return 0;
+        // Output buffer is full, wait until the driver can accept more data
+        ret = wait_ready(port, POLLOUT | POLLWRNORM, timeout_ms);
+        if ( ret <= 0 )
+        {
+            return ret;
+        }
+        ret = write(port, buf, len);
     }
-    ret = write(port, buf, len);
     if ( (ret < 0) && (errno == EAGAIN || errno == EINTR) )
     {
         return 0;
@@ -168,13 +327,7 @@ write_poll:
             printf("%08llu: TX: 0x%02X '%c'\n", s.tv_nsec / 1000000ULL + s.tv_sec * 1000ULL,
                    (uint8_t)(((const char *)buf)[i]), ((const char *)buf)[i]);
 #endif
-        //        fflush( port );
-        //        syncfs( port );
-        //        fsync( port );
-        //        tcflush( port, TCOFLUSH);
-        //        tcdrain( port );
     }
-    //    tcflush(port, TCOFLUSH);
     return ret;
 }
 
@@ -185,26 +338,35 @@ int tiny_serial_read(tiny_serial_handle_t port, void *buf, int len)
 
 int tiny_serial_read_timeout(tiny_serial_handle_t port, void *buf, int len, uint32_t timeout_ms)
 {
-    struct pollfd fds = {.fd = port, .events = POLLIN | POLLRDNORM};
-    int ret;
-read_poll:
-    ret = poll(&fds, 1, timeout_ms);
-    if ( ret < 0 )
+    tiny_shm_port_t *shm = tiny_shm_find(port);
+    if ( shm )
     {
-        if ( errno == EINTR )
+        return tiny_shm_read(shm, buf, len, timeout_ms);
+    }
+    int ret = read(port, buf, len);
+    if ( (ret < 0 && (errno == EAGAIN || errno == EINTR)) || (ret == 0 && timeout_ms) )
+    {
+        // Nothing is available yet, wait for incoming data
+        ret = wait_ready(port, POLLIN | POLLRDNORM, timeout_ms);
+        if ( ret <= 0 )
         {
-            goto read_poll;
+            return ret;
         }
-        return ret;
+        ret = read(port, buf, len);
     }
-    if ( ret == 0 || !(fds.revents & (POLLIN | POLLRDNORM)) )
+    if ( (ret < 0) && (errno == EAGAIN || errno == EINTR) )
     {
         return 0;
     }
-    ret = read(port, buf, len);
-    if ( (ret < 0) && (errno == EAGAIN || errno == EINTR) )
+    // Drain everything, which arrived while reading, in the same call
+    while ( ret > 0 && ret < len )
     {
-        return 0;
+        int next = read(port, (uint8_t *)buf + ret, len - ret);
+        if ( next <= 0 )
+        {
+            break;
+        }
+        ret += next;
     }
     if ( ret > 0 )
     {
@@ -0,0 +1,543 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+/*
+ * Shared memory backend for tiny_serial API. It is used, when the port name is in "shm:<name>" format.
+ *
+ * Both processes (or threads) open the port with the same name. The first one creates memfd segment
+ * with two lock-free single producer / single consumer byte rings (one per direction) and waits for
+ * the peer on abstract unix socket. The second one connects to the socket. Both sides exchange memfd
+ * and eventfd descriptors via SCM_RIGHTS, then all data go through shared memory only.
+ * Each side has two eventfds: the first one is signalled by the peer only when rx ring becomes non-empty,
+ * the second one - only when tx ring becomes non-full. So, bulk transfers do not need any syscalls,
+ * and separate Rx and Tx threads never steal wakeups from each other.
+ *
+ * The handshake is completed lazily inside read and send functions, so opening the port never blocks.
+ * Rx and Tx threads may progress the handshake concurrently, so its steps are serialized by the port lock,
+ * and peer eventfds are used only after the handshake completion is published. The creator owns the segment
+ * from the start, so it can send data before the handshake is complete.
+ *
+ * Ports are kept in fixed slots, which are never moved. The port handle encodes slot index and
+ * generation of the slot, so the handle of closed port never refers to other port, opened later.
+ */
+
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <sys/un.h>
+#include <linux/memfd.h>
+#include <pthread.h>
+
+#ifndef TINY_SHM_RING_SIZE
+/** Size of each shared memory ring in bytes, must be power of 2 */
+#define TINY_SHM_RING_SIZE 65536
+#endif
+
+#ifndef TINY_SHM_MAX_PORTS
+/** Maximum number of simultaneously opened shared memory ports in the process */
+#define TINY_SHM_MAX_PORTS 64
+#endif
+
+#if TINY_SHM_MAX_PORTS > 256
+#error "TINY_SHM_MAX_PORTS cannot exceed 256"
+#endif
+
+#define TINY_SHM_CACHE_LINE 64
+
+/* Flag, which distinguishes shared memory handles from file descriptors of tty devices.
+ * Linux never allocates file descriptors of that size (see fs.nr_open). */
+#define TINY_SHM_HANDLE_FLAG 0x40000000
+#define TINY_SHM_GENERATION_MASK 0x003FFFFF
+
+typedef struct
+{
+    uint32_t head; // written by producer only
+    uint8_t pad1[TINY_SHM_CACHE_LINE - sizeof(uint32_t)];
+    uint32_t tail; // written by consumer only
+    uint8_t pad2[TINY_SHM_CACHE_LINE - sizeof(uint32_t)];
+    uint8_t data[TINY_SHM_RING_SIZE];
+} tiny_shm_ring_t;
+
+typedef struct
+{
+    // ring[0] carries data from the creator to the peer, ring[1] - in opposite direction
+    tiny_shm_ring_t ring[2];
+} tiny_shm_segment_t;
+
+typedef struct
+{
+    int handle;      // port handle, 0 if the slot is free
+    uint32_t generation; // incremented every time the slot is allocated
+    int rx_efd;      // signalled, when rx ring becomes non-empty; it is returned by tiny_serial_get_fd()
+    int tx_efd;      // signalled, when tx ring becomes non-full
+    int peer_rx_efd; // eventfds of the remote side, -1 until handshake is complete
+    int peer_tx_efd;
+    int ctl;         // listening or connected unix socket, -1 after handshake
+    int memfd;    // shared memory descriptor, kept by creator until it is passed to the peer
+    uint8_t listening;
+    uint8_t creator; // the side, which has created the segment; never changes after open
+    uint8_t ready;   // set, when the handshake is complete and peer eventfds, rx and tx are published
+    pthread_mutex_t lock; // serializes handshake steps, done by Rx and Tx threads
+    tiny_shm_segment_t *segment;
+    tiny_shm_ring_t *rx;
+    tiny_shm_ring_t *tx;
+} tiny_shm_port_t;
+
+static tiny_shm_port_t s_shm_ports[TINY_SHM_MAX_PORTS];
+// Protects allocation and release of slots only: lookup doesn't need the lock
+static pthread_mutex_t s_shm_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static tiny_shm_port_t *tiny_shm_find(tiny_serial_handle_t port)
+{
+    if ( port < 0 || !(port & TINY_SHM_HANDLE_FLAG) || (port & 0xFF) >= TINY_SHM_MAX_PORTS )
+    {
+        return NULL;
+    }
+    tiny_shm_port_t *p = &s_shm_ports[port & 0xFF];
+    return __atomic_load_n(&p->handle, __ATOMIC_ACQUIRE) == port ? p : NULL;
+}
+
+static int tiny_shm_send_fds(int sock, const int *fds, int count)
+{
+    char byte = 0;
+    struct iovec iov = {.iov_base = &byte, .iov_len = 1};
+    union
+    {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(3 * sizeof(int))];
+    } control;
+    struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1, .msg_control = control.buf,
+                         .msg_controllen = CMSG_SPACE(count * sizeof(int))};
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(count * sizeof(int));
+    memcpy(CMSG_DATA(cmsg), fds, count * sizeof(int));
+    return sendmsg(sock, &msg, MSG_NOSIGNAL) == 1 ? 0 : -1;
+}
+
+/* Returns number of received descriptors, 0 if nothing is received yet, -1 on error */
+static int tiny_shm_recv_fds(int sock, int *fds, int count)
+{
+    char byte;
+    struct iovec iov = {.iov_base = &byte, .iov_len = 1};
+    union
+    {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(3 * sizeof(int))];
+    } control;
+    struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1, .msg_control = control.buf,
+                         .msg_controllen = CMSG_SPACE(count * sizeof(int))};
+    ssize_t ret = recvmsg(sock, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if ( ret < 0 )
+    {
+        return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+    }
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if ( ret == 0 || !cmsg || cmsg->cmsg_type != SCM_RIGHTS || cmsg->cmsg_len != CMSG_LEN(count * sizeof(int)) )
+    {
+        return -1;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), count * sizeof(int));
+    return count;
+}
+
+static void tiny_shm_signal(int efd)
+{
+    uint64_t value = 1;
+    if ( efd >= 0 && write(efd, &value, sizeof(value)) < 0 )
+    {
+        // Counter overflow is impossible, the peer is notified anyway
+    }
+}
+
+/* Performs next handshake steps, which are possible without blocking. Must be called under the port lock */
+static void tiny_shm_handshake_locked(tiny_shm_port_t *p)
+{
+    if ( p->ctl < 0 )
+    {
+        return;
+    }
+    if ( p->listening )
+    {
+        int conn = accept(p->ctl, NULL, NULL);
+        if ( conn < 0 )
+        {
+            return;
+        }
+        fcntl(conn, F_SETFL, O_NONBLOCK);
+        fcntl(conn, F_SETFD, FD_CLOEXEC);
+        close(p->ctl);
+        p->ctl = conn;
+        p->listening = 0;
+        int fds[3] = {p->memfd, p->rx_efd, p->tx_efd};
+        if ( tiny_shm_send_fds(p->ctl, fds, 3) < 0 )
+        {
+            return;
+        }
+        close(p->memfd);
+        p->memfd = -1;
+    }
+    if ( p->segment )
+    {
+        // Creator waits for peer eventfds only
+        int fds[2];
+        if ( tiny_shm_recv_fds(p->ctl, fds, 2) <= 0 )
+        {
+            return;
+        }
+        p->peer_rx_efd = fds[0];
+        p->peer_tx_efd = fds[1];
+    }
+    else
+    {
+        int fds[3];
+        if ( tiny_shm_recv_fds(p->ctl, fds, 3) <= 0 )
+        {
+            return;
+        }
+        void *addr = mmap(NULL, sizeof(tiny_shm_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+        close(fds[0]);
+        if ( addr == MAP_FAILED )
+        {
+            close(fds[1]);
+            close(fds[2]);
+            return;
+        }
+        p->segment = (tiny_shm_segment_t *)addr;
+        p->rx = &p->segment->ring[0];
+        p->tx = &p->segment->ring[1];
+        p->peer_rx_efd = fds[1];
+        p->peer_tx_efd = fds[2];
+    }
+    close(p->ctl);
+    p->ctl = -1;
+    __atomic_store_n(&p->ready, 1, __ATOMIC_SEQ_CST);
+    // Wake up the peer, and own thread, which may wait for handshake progress on other descriptor
+    tiny_shm_signal(p->peer_rx_efd);
+    tiny_shm_signal(p->peer_tx_efd);
+    tiny_shm_signal(p->rx_efd);
+    tiny_shm_signal(p->tx_efd);
+}
+
+/* Returns 1, if the handshake is complete, and the rings can be used */
+static int tiny_shm_handshake(tiny_shm_port_t *p)
+{
+    if ( __atomic_load_n(&p->ready, __ATOMIC_ACQUIRE) )
+    {
+        return 1;
+    }
+    pthread_mutex_lock(&p->lock);
+    tiny_shm_handshake_locked(p);
+    pthread_mutex_unlock(&p->lock);
+    return __atomic_load_n(&p->ready, __ATOMIC_ACQUIRE);
+}
+
+/* Reserves free slot. The slot is not visible to tiny_shm_find() until the handle is published */
+static tiny_shm_port_t *tiny_shm_allocate(void)
+{
+    tiny_shm_port_t *p = NULL;
+    pthread_mutex_lock(&s_shm_mutex);
+    for ( int i = 0; i < TINY_SHM_MAX_PORTS; i++ )
+    {
+        if ( s_shm_ports[i].handle == 0 )
+        {
+            p = &s_shm_ports[i];
+            uint32_t generation = p->generation + 1;
+            memset(p, 0, sizeof(*p));
+            p->generation = generation;
+            // Reserve the slot by invalid handle value, which never matches any real handle
+            p->handle = -1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_shm_mutex);
+    return p;
+}
+
+static void tiny_shm_release(tiny_shm_port_t *p)
+{
+    pthread_mutex_lock(&s_shm_mutex);
+    __atomic_store_n(&p->handle, 0, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&s_shm_mutex);
+}
+
+static tiny_serial_handle_t tiny_shm_open(const char *name)
+{
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if ( strlen(name) > TINY_SHM_MAX_NAME_LEN )
+    {
+        return TINY_SERIAL_INVALID;
+    }
+    // Abstract socket name is removed automatically, when the socket is closed
+    int addr_len = snprintf(addr.sun_path + 1, sizeof(addr.sun_path) - 1, "tinyproto-shm-%s", name);
+    addr_len += offsetof(struct sockaddr_un, sun_path) + 1;
+    tiny_shm_port_t *p = tiny_shm_allocate();
+    if ( !p )
+    {
+        return TINY_SERIAL_INVALID;
+    }
+    pthread_mutex_init(&p->lock, NULL);
+    p->peer_rx_efd = -1;
+    p->peer_tx_efd = -1;
+    p->memfd = -1;
+    p->rx_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    p->tx_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    p->ctl = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if ( p->rx_efd < 0 || p->tx_efd < 0 || p->ctl < 0 )
+    {
+        goto error;
+    }
+    if ( bind(p->ctl, (struct sockaddr *)&addr, addr_len) == 0 )
+    {
+        // This side creates shared memory segment
+        p->memfd = (int)syscall(SYS_memfd_create, "tinyproto-shm", MFD_CLOEXEC);
+        if ( p->memfd < 0 || ftruncate(p->memfd, sizeof(tiny_shm_segment_t)) < 0 || listen(p->ctl, 1) < 0 )
+        {
+            goto error;
+        }
+        void *mem = mmap(NULL, sizeof(tiny_shm_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, p->memfd, 0);
+        if ( mem == MAP_FAILED )
+        {
+            goto error;
+        }
+        p->segment = (tiny_shm_segment_t *)mem;
+        p->tx = &p->segment->ring[0];
+        p->rx = &p->segment->ring[1];
+        p->listening = 1;
+        p->creator = 1;
+    }
+    else if ( errno == EADDRINUSE )
+    {
+        // Connection to unix socket completes immediately, even if the creator has not accepted it yet
+        int fds[2] = {p->rx_efd, p->tx_efd};
+        if ( connect(p->ctl, (struct sockaddr *)&addr, addr_len) < 0 || tiny_shm_send_fds(p->ctl, fds, 2) < 0 )
+        {
+            goto error;
+        }
+    }
+    else
+    {
+        goto error;
+    }
+    tiny_shm_handshake(p);
+    int handle = TINY_SHM_HANDLE_FLAG | ((p->generation & TINY_SHM_GENERATION_MASK) << 8) | (int)(p - s_shm_ports);
+    __atomic_store_n(&p->handle, handle, __ATOMIC_RELEASE);
+    return handle;
+
+error:
+    perror("ERROR: Failed to open shared memory port");
+    if ( p->memfd >= 0 )
+    {
+        close(p->memfd);
+    }
+    if ( p->ctl >= 0 )
+    {
+        close(p->ctl);
+    }
+    if ( p->rx_efd >= 0 )
+    {
+        close(p->rx_efd);
+    }
+    if ( p->tx_efd >= 0 )
+    {
+        close(p->tx_efd);
+    }
+    pthread_mutex_destroy(&p->lock);
+    tiny_shm_release(p);
+    return TINY_SERIAL_INVALID;
+}
+
+static void tiny_shm_close(tiny_shm_port_t *p)
+{
+    // Unpublish the handle first, so nobody can find the port anymore
+    __atomic_store_n(&p->handle, -1, __ATOMIC_RELEASE);
+    if ( p->segment )
+    {
+        munmap(p->segment, sizeof(tiny_shm_segment_t));
+    }
+    if ( p->memfd >= 0 )
+    {
+        close(p->memfd);
+    }
+    if ( p->ctl >= 0 )
+    {
+        close(p->ctl);
+    }
+    if ( p->peer_rx_efd >= 0 )
+    {
+        close(p->peer_rx_efd);
+    }
+    if ( p->peer_tx_efd >= 0 )
+    {
+        close(p->peer_tx_efd);
+    }
+    close(p->rx_efd);
+    close(p->tx_efd);
+    pthread_mutex_destroy(&p->lock);
+    tiny_shm_release(p);
+}
+
+static int tiny_shm_get_fd(tiny_shm_port_t *p)
+{
+    return p->rx_efd;
+}
+
+/* Waits for notification from the peer on the specified eventfd or for handshake progress */
+static int tiny_shm_wait(tiny_shm_port_t *p, int efd, uint32_t timeout_ms)
+{
+    struct pollfd fds[2] = {{.fd = efd, .events = POLLIN}, {.fd = -1, .events = POLLIN}};
+    if ( !__atomic_load_n(&p->ready, __ATOMIC_ACQUIRE) )
+    {
+        // Other thread may complete the handshake and close control socket, while this one is sleeping
+        pthread_mutex_lock(&p->lock);
+        fds[1].fd = p->ctl >= 0 ? fcntl(p->ctl, F_DUPFD_CLOEXEC, 0) : -1;
+        pthread_mutex_unlock(&p->lock);
+    }
+    int ret;
+    do
+    {
+        ret = poll(fds, 2, timeout_ms);
+    } while ( ret < 0 && errno == EINTR );
+    if ( fds[1].fd >= 0 )
+    {
+        close(fds[1].fd);
+    }
+    return ret;
+}
+
+static void tiny_shm_clear_notification(int efd)
+{
+    uint64_t value;
+    if ( read(efd, &value, sizeof(value)) < 0 )
+    {
+        // Nothing to clear
+    }
+}
+
+static int tiny_shm_ring_write(tiny_shm_port_t *p, const uint8_t *buf, int len)
+{
+    tiny_shm_ring_t *ring = p->tx;
+    uint32_t head = ring->head;
+    uint32_t space = TINY_SHM_RING_SIZE - (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE));
+    uint32_t count = (uint32_t)len < space ? (uint32_t)len : space;
+    if ( count == 0 )
+    {
+        return 0;
+    }
+    uint32_t offset = head & (TINY_SHM_RING_SIZE - 1);
+    uint32_t first = TINY_SHM_RING_SIZE - offset < count ? TINY_SHM_RING_SIZE - offset : count;
+    memcpy(&ring->data[offset], buf, first);
+    memcpy(&ring->data[0], buf + first, count - first);
+    __atomic_store_n(&ring->head, head + count, __ATOMIC_SEQ_CST);
+    // If consumer has read everything before this write, it may be sleeping. Before the handshake
+    // is complete, the consumer is woken up by the handshake itself.
+    if ( __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST) == head && __atomic_load_n(&p->ready, __ATOMIC_SEQ_CST) )
+    {
+        tiny_shm_signal(p->peer_rx_efd);
+    }
+    return count;
+}
+
+static int tiny_shm_ring_read(tiny_shm_port_t *p, uint8_t *buf, int len)
+{
+    tiny_shm_ring_t *ring = p->rx;
+    uint32_t tail = ring->tail;
+    uint32_t available = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail;
+    uint32_t count = (uint32_t)len < available ? (uint32_t)len : available;
+    if ( count == 0 )
+    {
+        return 0;
+    }
+    uint32_t offset = tail & (TINY_SHM_RING_SIZE - 1);
+    uint32_t first = TINY_SHM_RING_SIZE - offset < count ? TINY_SHM_RING_SIZE - offset : count;
+    memcpy(buf, &ring->data[offset], first);
+    memcpy(buf + first, &ring->data[0], count - first);
+    __atomic_store_n(&ring->tail, tail + count, __ATOMIC_SEQ_CST);
+    // If producer has found the ring full, it may be sleeping
+    if ( __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) - tail >= TINY_SHM_RING_SIZE )
+    {
+        tiny_shm_signal(p->peer_tx_efd);
+    }
+    return count;
+}
+
+/* Returns tx ring, if the port can send data: the creator can do that before the handshake is complete */
+static tiny_shm_ring_t *tiny_shm_tx_ring(tiny_shm_port_t *p)
+{
+    return (tiny_shm_handshake(p) || p->creator) ? p->tx : NULL;
+}
+
+static int tiny_shm_send(tiny_shm_port_t *p, const void *buf, int len, uint32_t timeout_ms)
+{
+    int ret = tiny_shm_tx_ring(p) ? tiny_shm_ring_write(p, (const uint8_t *)buf, len) : 0;
+    if ( ret == 0 && len > 0 && timeout_ms )
+    {
+        // Clear stale notification and check the ring again before sleeping: the consumer
+        // signals only once, when it frees space in full ring
+        tiny_shm_clear_notification(p->tx_efd);
+        ret = tiny_shm_tx_ring(p) ? tiny_shm_ring_write(p, (const uint8_t *)buf, len) : 0;
+        if ( ret > 0 )
+        {
+            return ret;
+        }
+        ret = tiny_shm_wait(p, p->tx_efd, timeout_ms);
+        if ( ret <= 0 )
+        {
+            return ret;
+        }
+        ret = tiny_shm_tx_ring(p) ? tiny_shm_ring_write(p, (const uint8_t *)buf, len) : 0;
+    }
+    return ret;
+}
+
+static int tiny_shm_read(tiny_shm_port_t *p, void *buf, int len, uint32_t timeout_ms)
+{
+    int ready = tiny_shm_handshake(p);
+    tiny_shm_clear_notification(p->rx_efd);
+    int ret = ready ? tiny_shm_ring_read(p, (uint8_t *)buf, len) : 0;
+    if ( ret == 0 && len > 0 && timeout_ms )
+    {
+        ret = tiny_shm_wait(p, p->rx_efd, timeout_ms);
+        if ( ret <= 0 )
+        {
+            return ret;
+        }
+        ready = tiny_shm_handshake(p);
+        tiny_shm_clear_notification(p->rx_efd);
+        ret = ready ? tiny_shm_ring_read(p, (uint8_t *)buf, len) : 0;
+    }
+    if ( ret > 0 && __atomic_load_n(&p->rx->head, __ATOMIC_ACQUIRE) != p->rx->tail )
+    {
+        // Keep the port readable for poll()/epoll users, since not all data are read
+        tiny_shm_signal(p->rx_efd);
+    }
+    return ret;
+}
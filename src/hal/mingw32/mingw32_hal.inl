@@ -171,3 +171,16 @@ uint32_t tiny_micros()
     T.QuadPart = T.QuadPart * 1000000 / F.QuadPart;
     return (uint32_t)T.QuadPart;
 }
+
+uint64_t tiny_micros64()
+{
+    LARGE_INTEGER T;
+    LARGE_INTEGER F;
+
+    QueryPerformanceFrequency(&F);
+    QueryPerformanceCounter(&T);
+
+    // Split conversion to avoid overflow of counter multiplied by 1000000
+    return (uint64_t)(T.QuadPart / F.QuadPart) * 1000000ULL +
+           (uint64_t)(T.QuadPart % F.QuadPart) * 1000000ULL / F.QuadPart;
+}
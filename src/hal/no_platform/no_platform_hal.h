@@ -120,6 +120,12 @@ typedef struct
 
     /** Must have for 1-wire interface. Default implementation does not count microseconds */
     uint32_t (*micros)(void);
+
+    /**
+     * Optional. Default implementation extends 32-bit micros() counter to 64 bits under spin lock,
+     * so it must not be called from interrupt handlers. Provide own implementation in that case.
+     */
+    uint64_t (*micros64)(void);
 } tiny_platform_hal_t;
 
 /**
@@ -149,6 +149,26 @@ static uint32_t micros_default()
     return cnt++;
 }
 
+static uint64_t micros64_default()
+{
+    // Extend 32-bit counter, it is enough to call the function at least once per counter period
+    // Spin lock prevents concurrent callers on different cores from incrementing high part twice
+    static volatile uint8_t lock = 0;
+    static uint32_t last = 0;
+    static uint32_t high = 0;
+    while ( __sync_lock_test_and_set(&lock, 1) )
+        ;
+    uint32_t ts = tiny_micros();
+    if ( ts < last )
+    {
+        high++;
+    }
+    last = ts;
+    uint64_t result = ((uint64_t)high << 32) | ts;
+    __sync_lock_release(&lock);
+    return result;
+}
+
 static tiny_platform_hal_t s_hal = {
     .mutex_create = mutex_create_default,
     .mutex_destroy = mutex_destroy_default,
@@ -167,6 +187,7 @@ static tiny_platform_hal_t s_hal = {
     .millis = millis_default,
     .sleep_us = sleep_us_default,
     .micros = micros_default,
+    .micros64 = micros64_default,
 };
 
 void tiny_mutex_create(tiny_mutex_t *mutex)
@@ -244,6 +265,11 @@ uint32_t tiny_micros(void)
     return s_hal.micros();
 }
 
+uint64_t tiny_micros64(void)
+{
+    return s_hal.micros64();
+}
+
 void tiny_hal_init(tiny_platform_hal_t *hal)
 {
     if ( hal->mutex_create )
@@ -276,4 +302,6 @@ void tiny_hal_init(tiny_platform_hal_t *hal)
         s_hal.sleep_us = hal->sleep_us;
     if ( hal->micros )
         s_hal.micros = hal->micros;
+    if ( hal->micros64 )
+        s_hal.micros64 = hal->micros64;
 }
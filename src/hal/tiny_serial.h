@@ -72,8 +72,9 @@ extern "C"
      *                   "rts", "cts" are optional arguments, specifying integer pin numbers (-1 to use
      *                   standard pin).
      *             For Arduino this is must be pointer to HardwareSerial class
-     * @param baud baud rate in bits
-     * @return valid serial handle or TINY_SERIAL_INVALID in case of error
+     * @param baud baud rate in bits. On Linux all standard rates up to 4000000 are supported,
+     *             other rates are set via termios2 interface if the driver allows that.
+     * @return valid serial handle or TINY_SERIAL_INVALID in case of error (including unsupported baud rate)
      */
     extern tiny_serial_handle_t tiny_serial_open(const char *name, uint32_t baud);
 
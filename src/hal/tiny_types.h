@@ -227,6 +227,26 @@ extern "C"
      */
     typedef void (*on_connect_event_cb_t)(void *handle, uint8_t address, bool connected);
 
+    /**
+     * on_frame_complete_cb_t is a callback function, which is called when the frame, submitted
+     * asynchronously, is confirmed by remote side or dropped.
+     * @param udata user data
+     * @param address address of peer station
+     * @param ticket ticket returned by submit function
+     * @param result TINY_SUCCESS if frame is delivered, or error code
+     * @return None.
+     */
+    typedef void (*on_frame_complete_cb_t)(void *udata, uint8_t address, int ticket, int result);
+
+    /**
+     * tiny_iovec_t describes single message for batch API functions.
+     */
+    typedef struct
+    {
+        const void *data; ///< pointer to message data
+        int len;          ///< length of message in bytes
+    } tiny_iovec_t;
+
 #define EVENT_BITS_ALL 0xFF ///< All bits supported by tiny HAL events
 #define EVENT_BITS_CLEAR 1  ///< Flag, used in tiny_events_wait()
 #define EVENT_BITS_LEAVE 0  ///< Flag, used in tiny_events_wait()
@@ -352,6 +372,13 @@ extern "C"
      */
     uint32_t tiny_micros();
 
+    /**
+     * Returns 64-bit timestamp in microseconds since system started up.
+     * Unlike tiny_micros() the value never wraps around, so it can be used for
+     * long running timers with sub-millisecond resolution.
+     */
+    uint64_t tiny_micros64();
+
     /** @} */
 
     /**
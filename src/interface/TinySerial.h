@@ -57,6 +57,16 @@ public:
 
     int write(const uint8_t *buf, int len);
 
+#if defined(__linux__)
+    /**
+     * Returns file descriptor of opened port, it is in non-blocking mode.
+     */
+    int getFd() const
+    {
+        return m_handle == TINY_SERIAL_INVALID ? -1 : tiny_serial_get_fd(m_handle);
+    }
+#endif
+
 private:
     const char *m_dev;
     tiny_serial_handle_t m_handle = TINY_SERIAL_INVALID;
@@ -0,0 +1,375 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if defined(__linux__)
+
+#include "TinySocket.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace tinyproto
+{
+
+/** Maximum number of datagrams, processed by single recvmmsg() or sendmmsg() call */
+static constexpr int MAX_DATAGRAMS_BATCH = 16;
+
+/* Splits "host:port[:local_port]" address and resolves the host */
+static bool resolveAddress(const char *address, int type, struct addrinfo **result, char *localPort,
+                           int localPortSize)
+{
+    char host[256];
+    strncpy(host, address, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    char *port = strchr(host, ':');
+    if ( !port )
+    {
+        fprintf(stderr, "ERROR: Invalid socket address %s, host:port is expected\n", address);
+        return false;
+    }
+    *port++ = '\0';
+    char *local = strchr(port, ':');
+    if ( local )
+    {
+        *local++ = '\0';
+    }
+    if ( localPort )
+    {
+        strncpy(localPort, local ? local : "", localPortSize - 1);
+        localPort[localPortSize - 1] = '\0';
+    }
+    struct addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = type;
+    int err = getaddrinfo(host, port, &hints, result);
+    if ( err != 0 )
+    {
+        fprintf(stderr, "ERROR: Failed to resolve %s: %s\n", address, gai_strerror(err));
+        return false;
+    }
+    return true;
+}
+
+/* Connects non-blocking socket, waiting up to timeout for connection to complete */
+static bool connectSocket(int fd, const struct sockaddr *addr, socklen_t addrLen, uint32_t timeoutMs)
+{
+    if ( connect(fd, addr, addrLen) == 0 )
+    {
+        return true;
+    }
+    if ( errno != EINPROGRESS )
+    {
+        return false;
+    }
+    struct pollfd fds = {fd, POLLOUT, 0};
+    if ( poll(&fds, 1, timeoutMs) <= 0 )
+    {
+        return false;
+    }
+    int error = 0;
+    socklen_t len = sizeof(error);
+    return getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Socket::Socket(const char *address)
+    : m_address(address)
+{
+}
+
+Socket::~Socket()
+{
+    end();
+}
+
+void Socket::setTimeout(uint32_t timeoutMs)
+{
+    m_timeoutMs = timeoutMs;
+}
+
+bool Socket::begin(uint32_t speed)
+{
+    (void)speed;
+    m_fd = open();
+    return m_fd >= 0;
+}
+
+void Socket::end()
+{
+    if ( m_fd >= 0 )
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+int Socket::waitReady(short events)
+{
+    struct pollfd fds = {m_fd, events, 0};
+    int ret;
+    do
+    {
+        ret = poll(&fds, 1, m_timeoutMs);
+    } while ( ret < 0 && errno == EINTR );
+    return ret;
+}
+
+int Socket::readBytes(uint8_t *buf, int len)
+{
+    int ret = recv(m_fd, buf, len, MSG_DONTWAIT);
+    if ( ret < 0 && (errno == EAGAIN || errno == EINTR) && m_timeoutMs )
+    {
+        if ( waitReady(POLLIN) <= 0 )
+        {
+            return 0;
+        }
+        ret = recv(m_fd, buf, len, MSG_DONTWAIT);
+    }
+    if ( ret < 0 && (errno == EAGAIN || errno == EINTR) )
+    {
+        return 0;
+    }
+    // Remote side closed the connection
+    return ret == 0 && len > 0 ? -1 : ret;
+}
+
+int Socket::write(const uint8_t *buf, int len)
+{
+    int ret = send(m_fd, buf, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if ( ret < 0 && (errno == EAGAIN || errno == EINTR) && m_timeoutMs )
+    {
+        if ( waitReady(POLLOUT) <= 0 )
+        {
+            return 0;
+        }
+        ret = send(m_fd, buf, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    }
+    if ( ret < 0 && (errno == EAGAIN || errno == EINTR) )
+    {
+        return 0;
+    }
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int TcpSocket::open()
+{
+    struct addrinfo *info = nullptr;
+    if ( !resolveAddress(m_address, SOCK_STREAM, &info, nullptr, 0) )
+    {
+        return -1;
+    }
+    int fd = -1;
+    for ( struct addrinfo *ai = info; ai && fd < 0; ai = ai->ai_next )
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if ( fd >= 0 && !connectSocket(fd, ai->ai_addr, ai->ai_addrlen, m_timeoutMs ? m_timeoutMs : 1000) )
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(info);
+    if ( fd < 0 )
+    {
+        fprintf(stderr, "ERROR: Failed to connect to %s\n", m_address);
+        return -1;
+    }
+    int flag = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    return fd;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int UnixSocket::open()
+{
+    struct sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    size_t len = strlen(m_address);
+    if ( len == 0 || len >= sizeof(addr.sun_path) )
+    {
+        fprintf(stderr, "ERROR: Invalid unix socket address %s\n", m_address);
+        return -1;
+    }
+    memcpy(addr.sun_path, m_address, len);
+    if ( m_address[0] == '@' )
+    {
+        // Abstract socket name starts with zero byte
+        addr.sun_path[0] = '\0';
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    socklen_t addrLen = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + len);
+    if ( fd >= 0 && !connectSocket(fd, reinterpret_cast<struct sockaddr *>(&addr), addrLen,
+                                   m_timeoutMs ? m_timeoutMs : 1000) )
+    {
+        close(fd);
+        fd = -1;
+    }
+    if ( fd < 0 )
+    {
+        fprintf(stderr, "ERROR: Failed to connect to %s\n", m_address);
+    }
+    return fd;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int UdpSocket::open()
+{
+    struct addrinfo *info = nullptr;
+    char localPort[16];
+    if ( !resolveAddress(m_address, SOCK_DGRAM, &info, localPort, sizeof(localPort)) )
+    {
+        return -1;
+    }
+    int fd = socket(info->ai_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    bool ok = fd >= 0;
+    if ( ok && localPort[0] )
+    {
+        struct sockaddr_storage local{};
+        local.ss_family = info->ai_family;
+        uint16_t port = htons(static_cast<uint16_t>(atoi(localPort)));
+        socklen_t localLen;
+        if ( info->ai_family == AF_INET6 )
+        {
+            reinterpret_cast<struct sockaddr_in6 *>(&local)->sin6_port = port;
+            localLen = sizeof(struct sockaddr_in6);
+        }
+        else
+        {
+            reinterpret_cast<struct sockaddr_in *>(&local)->sin_port = port;
+            localLen = sizeof(struct sockaddr_in);
+        }
+        ok = bind(fd, reinterpret_cast<struct sockaddr *>(&local), localLen) == 0;
+    }
+    // Connected UDP socket receives datagrams from the remote address only
+    ok = ok && connect(fd, info->ai_addr, info->ai_addrlen) == 0;
+    freeaddrinfo(info);
+    if ( !ok )
+    {
+        fprintf(stderr, "ERROR: Failed to open udp socket %s: %s\n", m_address, strerror(errno));
+        if ( fd >= 0 )
+        {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+int UdpSocket::readBytes(uint8_t *buf, int len)
+{
+    // Each datagram is received to its own slot, then slots are packed together
+    struct mmsghdr msgs[MAX_DATAGRAMS_BATCH];
+    struct iovec iovs[MAX_DATAGRAMS_BATCH];
+    int count = 0;
+    for ( int offset = 0; offset < len && count < MAX_DATAGRAMS_BATCH; offset += DATAGRAM_SIZE, count++ )
+    {
+        iovs[count].iov_base = buf + offset;
+        iovs[count].iov_len = len - offset < DATAGRAM_SIZE ? len - offset : DATAGRAM_SIZE;
+        memset(&msgs[count], 0, sizeof(msgs[count]));
+        msgs[count].msg_hdr.msg_iov = &iovs[count];
+        msgs[count].msg_hdr.msg_iovlen = 1;
+    }
+    int received = recvmmsg(m_fd, msgs, count, MSG_DONTWAIT, nullptr);
+    if ( received < 0 && (errno == EAGAIN || errno == EINTR) && m_timeoutMs )
+    {
+        if ( waitReady(POLLIN) <= 0 )
+        {
+            return 0;
+        }
+        received = recvmmsg(m_fd, msgs, count, MSG_DONTWAIT, nullptr);
+    }
+    if ( received < 0 )
+    {
+        // ECONNREFUSED is reported, if remote side is not started yet: this is not an error for UDP
+        return (errno == EAGAIN || errno == EINTR || errno == ECONNREFUSED) ? 0 : -1;
+    }
+    int total = 0;
+    for ( int i = 0; i < received; i++ )
+    {
+        if ( static_cast<uint8_t *>(iovs[i].iov_base) != buf + total )
+        {
+            memmove(buf + total, iovs[i].iov_base, msgs[i].msg_len);
+        }
+        total += msgs[i].msg_len;
+    }
+    return total;
+}
+
+int UdpSocket::write(const uint8_t *buf, int len)
+{
+    struct mmsghdr msgs[MAX_DATAGRAMS_BATCH];
+    struct iovec iovs[MAX_DATAGRAMS_BATCH];
+    int count = 0;
+    for ( int offset = 0; offset < len && count < MAX_DATAGRAMS_BATCH; offset += DATAGRAM_SIZE, count++ )
+    {
+        iovs[count].iov_base = const_cast<uint8_t *>(buf + offset);
+        iovs[count].iov_len = len - offset < DATAGRAM_SIZE ? len - offset : DATAGRAM_SIZE;
+        memset(&msgs[count], 0, sizeof(msgs[count]));
+        msgs[count].msg_hdr.msg_iov = &iovs[count];
+        msgs[count].msg_hdr.msg_iovlen = 1;
+    }
+    int sent = sendmmsg(m_fd, msgs, count, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if ( sent < 0 && (errno == EAGAIN || errno == EINTR) && m_timeoutMs )
+    {
+        if ( waitReady(POLLOUT) <= 0 )
+        {
+            return 0;
+        }
+        sent = sendmmsg(m_fd, msgs, count, MSG_DONTWAIT | MSG_NOSIGNAL);
+    }
+    if ( sent < 0 )
+    {
+        if ( errno == EAGAIN || errno == EINTR )
+        {
+            return 0;
+        }
+        if ( errno == ECONNREFUSED )
+        {
+            // Remote side is not listening yet, data are lost like on disconnected serial line
+            return len;
+        }
+        return -1;
+    }
+    int total = 0;
+    for ( int i = 0; i < sent; i++ )
+    {
+        total += static_cast<int>(iovs[i].iov_len);
+    }
+    return total;
+}
+
+} // namespace tinyproto
+
+#endif
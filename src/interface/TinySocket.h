@@ -0,0 +1,126 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#if defined(__linux__)
+
+#include <stdint.h>
+
+namespace tinyproto
+{
+
+/**
+ * Base class for socket transports. It has the same interface as tinyproto::Serial,
+ * so it can be used as IO parameter of ISerialLinkLayer template.
+ * All sockets are non-blocking: read and write operations wait for readiness only
+ * up to the timeout, set via setTimeout().
+ */
+class Socket
+{
+public:
+    explicit Socket(const char *address);
+
+    virtual ~Socket();
+
+    void setTimeout(uint32_t timeoutMs);
+
+    /**
+     * Opens socket and connects to the address, specified in constructor.
+     * @param speed ignored, added for compatibility with tinyproto::Serial
+     * @return true if successful
+     */
+    bool begin(uint32_t speed);
+
+    void end();
+
+    virtual int readBytes(uint8_t *buf, int len);
+
+    virtual int write(const uint8_t *buf, int len);
+
+    /**
+     * Returns socket file descriptor or -1 if socket is not opened
+     */
+    int getFd() const
+    {
+        return m_fd;
+    }
+
+protected:
+    const char *m_address;
+    int m_fd = -1;
+    uint32_t m_timeoutMs = 0;
+
+    /** Creates and connects the socket, returns file descriptor or -1 */
+    virtual int open() = 0;
+
+    /** Waits for specified poll events up to timeout, returns positive value if ready */
+    int waitReady(short events);
+};
+
+/**
+ * TCP client socket. Address format is "host:port".
+ * Nagle algorithm is disabled, since protocol sends small frames and expects fast acknowledgement.
+ */
+class TcpSocket: public Socket
+{
+public:
+    using Socket::Socket;
+
+protected:
+    int open() override;
+};
+
+/**
+ * Unix domain stream socket. Address is path to the socket, or "@name" for abstract socket.
+ */
+class UnixSocket: public Socket
+{
+public:
+    using Socket::Socket;
+
+protected:
+    int open() override;
+};
+
+/**
+ * UDP socket. Address format is "host:port[:local_port]": datagrams are sent to host:port,
+ * and socket is bound to local_port if specified. The byte stream is split into datagrams of
+ * DATAGRAM_SIZE bytes, which are sent and received in batches via sendmmsg()/recvmmsg().
+ * Lost or reordered datagrams are detected by the protocol checksum like line errors.
+ */
+class UdpSocket: public Socket
+{
+public:
+    /// Maximum size of single datagram
+    static constexpr int DATAGRAM_SIZE = 1024;
+
+    using Socket::Socket;
+
+    int readBytes(uint8_t *buf, int len) override;
+
+    int write(const uint8_t *buf, int len) override;
+
+protected:
+    int open() override;
+};
+
+} // namespace tinyproto
+
+#endif
@@ -0,0 +1,794 @@
+/*
+    Copyright 2016-2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#if defined(__linux__)
+
+#include "TinyIoEngine.h"
+
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace tinyproto
+{
+
+enum
+{
+    OP_READ = 1,
+    OP_WRITE = 2,
+    OP_POLL_IN = 3,
+    OP_POLL_OUT = 4,
+    OP_CANCEL = 5,
+};
+
+struct IoEngine::Link
+{
+    int fd = -1;
+    RxCallback onRx = nullptr;
+    TxCallback getTx = nullptr;
+    DownCallback onDown = nullptr;
+    void *udata = nullptr;
+    uint8_t *rxBuf = nullptr;
+    uint8_t *txBuf = nullptr;
+    int txLen = 0;
+    int txPos = 0;
+    uint32_t gen = 0;
+    bool rxActive = false;
+    bool down = false;
+    bool tty = false; // ttys return 0 bytes, when no data available, instead of end of stream
+    bool rxInFlight = false;
+    bool txInFlight = false;
+    bool pollOut = false;
+};
+
+struct IoEngine::Ring
+{
+    unsigned *sqHead = nullptr;
+    unsigned *sqTail = nullptr;
+    unsigned *sqMask = nullptr;
+    unsigned *sqArray = nullptr;
+    unsigned sqEntries = 0;
+    io_uring_sqe *sqes = nullptr;
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    unsigned *cqMask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+    void *sqPtr = MAP_FAILED;
+    size_t sqSize = 0;
+    void *cqPtr = MAP_FAILED;
+    size_t cqSize = 0;
+    size_t sqesSize = 0;
+    unsigned pending = 0;
+    bool fixedBuffers = false;
+};
+
+static inline uint64_t makeUserData(uint32_t gen, int id, int op)
+{
+    return (static_cast<uint64_t>(gen) << 32) | (static_cast<uint64_t>(id) << 8) | op;
+}
+
+static void fdRx(void *udata, const uint8_t *data, int len)
+{
+    tiny_fd_on_rx_data(reinterpret_cast<tiny_fd_handle_t>(udata), data, len);
+}
+
+static int fdTx(void *udata, uint8_t *data, int maxLen)
+{
+    int len = tiny_fd_get_tx_data(reinterpret_cast<tiny_fd_handle_t>(udata), data, maxLen, 0);
+    return len > 0 ? len : 0;
+}
+
+static void hdlcRx(void *udata, const uint8_t *data, int len)
+{
+    while ( len > 0 )
+    {
+        int processed = hdlc_ll_run_rx(reinterpret_cast<hdlc_ll_handle_t>(udata), data, len, nullptr);
+        if ( processed <= 0 )
+        {
+            break;
+        }
+        data += processed;
+        len -= processed;
+    }
+}
+
+static int hdlcTx(void *udata, uint8_t *data, int maxLen)
+{
+    return hdlc_ll_run_tx(reinterpret_cast<hdlc_ll_handle_t>(udata), data, maxLen);
+}
+
+IoEngine::IoEngine(int maxLinks, int blockSize)
+    : m_maxLinks(maxLinks)
+    , m_blockSize(blockSize)
+{
+}
+
+IoEngine::~IoEngine()
+{
+    end();
+}
+
+bool IoEngine::begin(bool useUring)
+{
+    m_links = new Link[m_maxLinks];
+    m_buffers = new uint8_t[2 * m_maxLinks * m_blockSize];
+    for ( int i = 0; i < m_maxLinks; i++ )
+    {
+        m_links[i].rxBuf = m_buffers + 2 * i * m_blockSize;
+        m_links[i].txBuf = m_links[i].rxBuf + m_blockSize;
+    }
+    if ( useUring && beginUring() )
+    {
+        return true;
+    }
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if ( m_epollFd < 0 )
+    {
+        end();
+        return false;
+    }
+    return true;
+}
+
+void IoEngine::end()
+{
+    endUring();
+    if ( m_epollFd >= 0 )
+    {
+        close(m_epollFd);
+        m_epollFd = -1;
+    }
+    delete[] m_links;
+    m_links = nullptr;
+    delete[] m_buffers;
+    m_buffers = nullptr;
+}
+
+bool IoEngine::beginUring()
+{
+    io_uring_params params{};
+    // Each link can have one rx and one tx operation in flight, plus cancel requests
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, 4 * m_maxLinks, &params));
+    if ( fd < 0 )
+    {
+        return false;
+    }
+    // Waiting with timeout requires IORING_ENTER_EXT_ARG support
+    if ( !(params.features & IORING_FEAT_EXT_ARG) )
+    {
+        close(fd);
+        return false;
+    }
+    m_ring = new Ring();
+    Ring &ring = *m_ring;
+    m_ringFd = fd;
+    ring.sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring.cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if ( params.features & IORING_FEAT_SINGLE_MMAP )
+    {
+        ring.sqSize = ring.cqSize = ring.sqSize > ring.cqSize ? ring.sqSize : ring.cqSize;
+    }
+    ring.sqPtr = mmap(nullptr, ring.sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if ( ring.sqPtr == MAP_FAILED )
+    {
+        endUring();
+        return false;
+    }
+    if ( params.features & IORING_FEAT_SINGLE_MMAP )
+    {
+        ring.cqPtr = ring.sqPtr;
+    }
+    else
+    {
+        ring.cqPtr = mmap(nullptr, ring.cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if ( ring.cqPtr == MAP_FAILED )
+        {
+            endUring();
+            return false;
+        }
+    }
+    ring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if ( sqes == MAP_FAILED )
+    {
+        endUring();
+        return false;
+    }
+    uint8_t *sq = static_cast<uint8_t *>(ring.sqPtr);
+    uint8_t *cq = static_cast<uint8_t *>(ring.cqPtr);
+    ring.sqes = static_cast<io_uring_sqe *>(sqes);
+    ring.sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    ring.sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    ring.sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    ring.sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    ring.sqEntries = params.sq_entries;
+    ring.cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    ring.cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    ring.cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    ring.cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    // Registered buffers save page pinning on every operation, but may fail due to RLIMIT_MEMLOCK
+    struct iovec iov = {m_buffers, static_cast<size_t>(2 * m_maxLinks * m_blockSize)};
+    ring.fixedBuffers = syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, &iov, 1) == 0;
+    return true;
+}
+
+void IoEngine::endUring()
+{
+    if ( m_ring )
+    {
+        if ( m_ring->sqes )
+        {
+            munmap(m_ring->sqes, m_ring->sqesSize);
+        }
+        if ( m_ring->cqPtr != MAP_FAILED && m_ring->cqPtr != m_ring->sqPtr )
+        {
+            munmap(m_ring->cqPtr, m_ring->cqSize);
+        }
+        if ( m_ring->sqPtr != MAP_FAILED )
+        {
+            munmap(m_ring->sqPtr, m_ring->sqSize);
+        }
+        delete m_ring;
+        m_ring = nullptr;
+    }
+    if ( m_ringFd >= 0 )
+    {
+        close(m_ringFd);
+        m_ringFd = -1;
+    }
+}
+
+int IoEngine::addLink(int fd, RxCallback onRx, TxCallback getTx, void *udata)
+{
+    for ( int id = 0; id < m_maxLinks; id++ )
+    {
+        Link &link = m_links[id];
+        if ( link.fd >= 0 || link.rxInFlight || link.txInFlight )
+        {
+            continue;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        link.fd = fd;
+        link.onRx = onRx;
+        link.getTx = getTx;
+        link.onDown = nullptr;
+        link.udata = udata;
+        link.down = false;
+        link.tty = isatty(fd) != 0;
+        link.txLen = 0;
+        link.txPos = 0;
+        link.pollOut = false;
+        link.rxActive = true;
+        if ( isUring() )
+        {
+            submitRead(id);
+        }
+        else
+        {
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = static_cast<uint64_t>(id);
+            if ( epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev) < 0 )
+            {
+                link.fd = -1;
+                return -1;
+            }
+        }
+        return id;
+    }
+    return -1;
+}
+
+int IoEngine::addFdLink(int fd, tiny_fd_handle_t handle)
+{
+    return addLink(fd, fdRx, fdTx, handle);
+}
+
+int IoEngine::addHdlcLink(int fd, hdlc_ll_handle_t handle)
+{
+    return addLink(fd, hdlcRx, hdlcTx, handle);
+}
+
+void IoEngine::setDownCallback(int id, DownCallback onDown)
+{
+    if ( id >= 0 && id < m_maxLinks )
+    {
+        m_links[id].onDown = onDown;
+    }
+}
+
+void IoEngine::linkDown(int id)
+{
+    Link &link = m_links[id];
+    if ( link.down )
+    {
+        return;
+    }
+    // Closed descriptor is always ready, so it is not polled anymore to avoid spinning
+    link.down = true;
+    link.rxActive = false;
+    link.txLen = 0;
+    if ( !isUring() )
+    {
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, link.fd, nullptr);
+    }
+    if ( link.onDown )
+    {
+        link.onDown(link.udata);
+    }
+}
+
+void IoEngine::removeLink(int id)
+{
+    if ( id < 0 || id >= m_maxLinks || m_links[id].fd < 0 )
+    {
+        return;
+    }
+    Link &link = m_links[id];
+    if ( isUring() )
+    {
+        // The slot is reused only after all operations in flight complete
+        const int ops[] = {OP_READ, OP_WRITE, OP_POLL_IN, OP_POLL_OUT};
+        for ( int op : ops )
+        {
+            io_uring_sqe *sqe = ((op == OP_READ || op == OP_POLL_IN) ? link.rxInFlight : link.txInFlight) ? nextSqe() : nullptr;
+            if ( sqe )
+            {
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->fd = -1;
+                sqe->addr = makeUserData(link.gen, id, op);
+                sqe->user_data = makeUserData(link.gen, id, OP_CANCEL);
+                commitSqe();
+            }
+        }
+    }
+    else if ( !link.down )
+    {
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, link.fd, nullptr);
+    }
+    link.fd = -1;
+    link.rxActive = false;
+    link.gen++;
+}
+
+io_uring_sqe *IoEngine::nextSqe()
+{
+    Ring &ring = *m_ring;
+    unsigned tail = *ring.sqTail;
+    if ( tail - __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE) >= ring.sqEntries )
+    {
+        // Submission queue is full, pass queued entries to the kernel
+        if ( flushSubmissions(0, 0) < 0 || tail - __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE) >= ring.sqEntries )
+        {
+            return nullptr;
+        }
+    }
+    io_uring_sqe *sqe = &ring.sqes[tail & *ring.sqMask];
+    memset(sqe, 0, sizeof(*sqe));
+    ring.sqArray[tail & *ring.sqMask] = tail & *ring.sqMask;
+    return sqe;
+}
+
+void IoEngine::commitSqe()
+{
+    __atomic_store_n(m_ring->sqTail, *m_ring->sqTail + 1, __ATOMIC_RELEASE);
+    m_ring->pending++;
+}
+
+bool IoEngine::submitRead(int id)
+{
+    Link &link = m_links[id];
+    io_uring_sqe *sqe = nextSqe();
+    if ( !sqe )
+    {
+        return false;
+    }
+    sqe->opcode = m_ring->fixedBuffers ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe->fd = link.fd;
+    sqe->addr = reinterpret_cast<uint64_t>(link.rxBuf);
+    sqe->len = m_blockSize;
+    sqe->off = static_cast<uint64_t>(-1); // current file position, required for pipes and ttys
+    sqe->buf_index = 0;
+    sqe->user_data = makeUserData(link.gen, id, OP_READ);
+    commitSqe();
+    link.rxInFlight = true;
+    return true;
+}
+
+bool IoEngine::submitWrite(int id)
+{
+    Link &link = m_links[id];
+    io_uring_sqe *sqe = nextSqe();
+    if ( !sqe )
+    {
+        return false;
+    }
+    sqe->opcode = m_ring->fixedBuffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd = link.fd;
+    sqe->addr = reinterpret_cast<uint64_t>(link.txBuf + link.txPos);
+    sqe->len = link.txLen - link.txPos;
+    sqe->off = static_cast<uint64_t>(-1);
+    sqe->buf_index = 0;
+    sqe->user_data = makeUserData(link.gen, id, OP_WRITE);
+    commitSqe();
+    link.txInFlight = true;
+    return true;
+}
+
+bool IoEngine::submitPoll(int id, uint32_t events, int op)
+{
+    Link &link = m_links[id];
+    io_uring_sqe *sqe = nextSqe();
+    if ( !sqe )
+    {
+        return false;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = link.fd;
+    sqe->poll32_events = events;
+    sqe->user_data = makeUserData(link.gen, id, op);
+    commitSqe();
+    if ( op == OP_POLL_IN )
+    {
+        link.rxInFlight = true;
+    }
+    else
+    {
+        link.txInFlight = true;
+    }
+    return true;
+}
+
+int IoEngine::flushSubmissions(unsigned waitNr, int timeoutMs)
+{
+    unsigned flags = 0;
+    io_uring_getevents_arg arg{};
+    __kernel_timespec ts{};
+    if ( waitNr )
+    {
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = (timeoutMs % 1000) * 1000000LL;
+        arg.sigmask_sz = _NSIG / 8;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    }
+    else if ( !m_ring->pending )
+    {
+        return 0;
+    }
+    int ret;
+    do
+    {
+        ret = static_cast<int>(syscall(__NR_io_uring_enter, m_ringFd, m_ring->pending, waitNr, flags,
+                                       waitNr ? &arg : nullptr, waitNr ? sizeof(arg) : 0));
+    } while ( ret < 0 && errno == EINTR );
+    if ( ret >= 0 )
+    {
+        m_ring->pending -= static_cast<unsigned>(ret) < m_ring->pending ? ret : m_ring->pending;
+    }
+    else if ( errno == ETIME )
+    {
+        // Timeout is not an error, all submissions are consumed in this case
+        m_ring->pending = 0;
+        ret = 0;
+    }
+    return ret;
+}
+
+void IoEngine::fillTx(int id)
+{
+    Link &link = m_links[id];
+    if ( link.fd < 0 || link.down || !link.getTx || link.txLen > 0 )
+    {
+        return;
+    }
+    int len = link.getTx(link.udata, link.txBuf, m_blockSize);
+    if ( len <= 0 )
+    {
+        return;
+    }
+    link.txLen = len;
+    link.txPos = 0;
+    if ( isUring() )
+    {
+        if ( !submitWrite(id) )
+        {
+            // Submission queue is full, the data will be sent on next poll() call
+            link.txInFlight = false;
+        }
+    }
+    else
+    {
+        writeEpoll(id);
+    }
+}
+
+void IoEngine::processCompletion(uint64_t userData, int result)
+{
+    int id = static_cast<int>((userData >> 8) & 0xFFFFFF);
+    int op = static_cast<int>(userData & 0xFF);
+    uint32_t gen = static_cast<uint32_t>(userData >> 32);
+    if ( op == OP_CANCEL || id >= m_maxLinks )
+    {
+        return;
+    }
+    Link &link = m_links[id];
+    if ( op == OP_READ || op == OP_POLL_IN )
+    {
+        link.rxInFlight = false;
+    }
+    else
+    {
+        link.txInFlight = false;
+    }
+    if ( gen != link.gen || link.fd < 0 || link.down )
+    {
+        // Completion of removed or closed link
+        return;
+    }
+    switch ( op )
+    {
+        case OP_READ:
+            if ( result > 0 )
+            {
+                link.onRx(link.udata, link.rxBuf, result);
+                submitRead(id);
+            }
+            else if ( result == -EAGAIN || result == -EINTR || (result == 0 && link.tty) )
+            {
+                // Nothing available: ttys with VMIN=0 return 0, non-blocking descriptors return EAGAIN
+                submitPoll(id, POLLIN | POLLRDHUP, OP_POLL_IN);
+            }
+            else
+            {
+                // End of stream or error
+                linkDown(id);
+            }
+            break;
+        case OP_POLL_IN:
+            if ( result < 0 || (result & POLLERR) || (link.tty && (result & POLLHUP)) )
+            {
+                linkDown(id);
+            }
+            else if ( result & (POLLIN | POLLHUP | POLLRDHUP) )
+            {
+                // Data, received before hang up, are read first, then read returns end of stream
+                submitRead(id);
+            }
+            else
+            {
+                link.rxActive = false;
+            }
+            break;
+        case OP_WRITE:
+            if ( result > 0 )
+            {
+                link.txPos += result;
+                if ( link.txPos < link.txLen )
+                {
+                    submitWrite(id);
+                    break;
+                }
+                link.txLen = 0;
+                // Completion drives next transmission
+                fillTx(id);
+            }
+            else if ( result == -EAGAIN || result == -EINTR || result == 0 )
+            {
+                submitPoll(id, POLLOUT, OP_POLL_OUT);
+            }
+            else
+            {
+                // Drop the block, protocol level retransmissions will recover it
+                link.txLen = 0;
+            }
+            break;
+        case OP_POLL_OUT:
+            if ( result > 0 && (result & POLLOUT) )
+            {
+                submitWrite(id);
+            }
+            else
+            {
+                link.txLen = 0;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+int IoEngine::pollUring(int timeoutMs)
+{
+    Ring &ring = *m_ring;
+    for ( int id = 0; id < m_maxLinks; id++ )
+    {
+        if ( m_links[id].fd >= 0 && m_links[id].txLen > 0 && !m_links[id].txInFlight )
+        {
+            // Write was postponed due to full submission queue
+            submitWrite(id);
+        }
+        fillTx(id);
+    }
+    unsigned head = *ring.cqHead;
+    bool empty = head == __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+    // Single syscall submits all queued operations and waits for at least one completion
+    if ( flushSubmissions(empty && timeoutMs > 0 ? 1 : 0, timeoutMs) < 0 )
+    {
+        return -1;
+    }
+    int count = 0;
+    for ( ;; )
+    {
+        head = *ring.cqHead;
+        unsigned tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+        if ( head == tail )
+        {
+            break;
+        }
+        while ( head != tail )
+        {
+            io_uring_cqe *cqe = &ring.cqes[head & *ring.cqMask];
+            uint64_t userData = cqe->user_data;
+            int result = cqe->res;
+            head++;
+            __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+            processCompletion(userData, result);
+            count++;
+        }
+    }
+    for ( int id = 0; id < m_maxLinks; id++ )
+    {
+        fillTx(id);
+    }
+    flushSubmissions(0, 0);
+    return count;
+}
+
+bool IoEngine::writeEpoll(int id)
+{
+    Link &link = m_links[id];
+    while ( link.txPos < link.txLen )
+    {
+        ssize_t sent = write(link.fd, link.txBuf + link.txPos, link.txLen - link.txPos);
+        if ( sent < 0 && errno == EINTR )
+        {
+            continue;
+        }
+        if ( sent < 0 && errno != EAGAIN )
+        {
+            // Drop the block, protocol level retransmissions will recover it
+            link.txLen = 0;
+            break;
+        }
+        if ( sent <= 0 )
+        {
+            break;
+        }
+        link.txPos += static_cast<int>(sent);
+    }
+    if ( link.txPos >= link.txLen )
+    {
+        link.txLen = 0;
+    }
+    updateEpoll(id, false);
+    return link.txLen == 0;
+}
+
+void IoEngine::updateEpoll(int id, bool force)
+{
+    Link &link = m_links[id];
+    bool pollOut = link.txLen > 0;
+    if ( link.down || (pollOut == link.pollOut && !force) )
+    {
+        return;
+    }
+    epoll_event ev{};
+    ev.events = (link.rxActive ? static_cast<uint32_t>(EPOLLIN) : 0u) |
+                (pollOut ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    ev.data.u64 = static_cast<uint64_t>(id);
+    epoll_ctl(m_epollFd, EPOLL_CTL_MOD, link.fd, &ev);
+    link.pollOut = pollOut;
+}
+
+int IoEngine::pollEpoll(int timeoutMs)
+{
+    for ( int id = 0; id < m_maxLinks; id++ )
+    {
+        fillTx(id);
+    }
+    epoll_event events[64];
+    int n = epoll_wait(m_epollFd, events, sizeof(events) / sizeof(events[0]), timeoutMs);
+    if ( n < 0 )
+    {
+        return errno == EINTR ? 0 : -1;
+    }
+    for ( int i = 0; i < n; i++ )
+    {
+        int id = static_cast<int>(events[i].data.u64);
+        Link &link = m_links[id];
+        if ( link.fd < 0 || link.down )
+        {
+            continue;
+        }
+        if ( events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR) )
+        {
+            // Read everything available in one go
+            for ( ;; )
+            {
+                ssize_t len = read(link.fd, link.rxBuf, m_blockSize);
+                if ( len > 0 )
+                {
+                    link.onRx(link.udata, link.rxBuf, static_cast<int>(len));
+                    continue;
+                }
+                if ( len < 0 && errno == EINTR )
+                {
+                    continue;
+                }
+                if ( (len == 0 && (!link.tty || (events[i].events & EPOLLHUP))) || (len < 0 && errno != EAGAIN) )
+                {
+                    // End of stream or error: stop serving this link
+                    linkDown(id);
+                }
+                break;
+            }
+        }
+        if ( (events[i].events & EPOLLOUT) && !link.down )
+        {
+            writeEpoll(id);
+        }
+    }
+    for ( int id = 0; id < m_maxLinks; id++ )
+    {
+        fillTx(id);
+    }
+    return n;
+}
+
+int IoEngine::poll(int timeoutMs)
+{
+    if ( !m_links )
+    {
+        return -1;
+    }
+    return isUring() ? pollUring(timeoutMs) : pollEpoll(timeoutMs);
+}
+
+} // namespace tinyproto
+
+#endif
@@ -0,0 +1,191 @@
+/*
+    Copyright 2016-2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#pragma once
+
+#if defined(__linux__)
+
+#include "proto/fd/tiny_fd.h"
+#include "proto/hdlc/low_level/hdlc.h"
+
+#include <stdint.h>
+
+struct io_uring_sqe;
+
+namespace tinyproto
+{
+
+/**
+ * IoEngine serves many links (serial ports, sockets, pipes) from a single thread.
+ * All reads and writes are submitted through one io_uring ring with registered buffers,
+ * so one poll() call processes completions for all links with batched syscalls.
+ * If io_uring is not available (old kernel, seccomp restrictions), the engine falls back to epoll.
+ *
+ * Received data are passed to the rx callback of the link, and the tx callback is asked for
+ * new data every time the previous write completes. Use addFdLink() and addHdlcLink() to
+ * connect protocol handles directly. The engine is not thread-safe: all methods must be called
+ * from the thread, which runs poll().
+ * When the remote side closes the socket or pipe, or the descriptor fails, the engine stops serving
+ * the link and calls its down callback. The link stays registered until removeLink() is called.
+ *
+ * @note Available on Linux only.
+ */
+class IoEngine
+{
+public:
+    /**
+     * Callback to process received bytes.
+     * @param udata user data, specified in addLink()
+     * @param data pointer to received bytes
+     * @param len number of received bytes
+     */
+    typedef void (*RxCallback)(void *udata, const uint8_t *data, int len);
+
+    /**
+     * Callback to get next block of bytes to send.
+     * @param udata user data, specified in addLink()
+     * @param data buffer to fill
+     * @param maxLen size of the buffer
+     * @return number of bytes to send, 0 if there is nothing to send
+     */
+    typedef int (*TxCallback)(void *udata, uint8_t *data, int maxLen);
+
+    /**
+     * Callback to report, that the link is closed by remote side or failed.
+     * @param udata user data, specified in addLink()
+     */
+    typedef void (*DownCallback)(void *udata);
+
+    /**
+     * Creates engine object.
+     * @param maxLinks maximum number of links to serve
+     * @param blockSize size of rx and tx buffers allocated per link
+     */
+    explicit IoEngine(int maxLinks = 64, int blockSize = 512);
+
+    ~IoEngine();
+
+    /**
+     * Initializes the engine.
+     * @param useUring true to try io_uring first, false to use epoll only
+     * @return true if successful
+     */
+    bool begin(bool useUring = true);
+
+    /**
+     * Stops the engine. Registered file descriptors are not closed.
+     */
+    void end();
+
+    /**
+     * Registers new link. The file descriptor is switched to non-blocking mode.
+     * @param fd file descriptor of the link
+     * @param onRx callback to process received bytes
+     * @param getTx callback to get bytes to send, can be nullptr for rx only links
+     * @param udata user data to pass to callbacks
+     * @return link id or negative value if there are no free link slots
+     */
+    int addLink(int fd, RxCallback onRx, TxCallback getTx, void *udata);
+
+    /**
+     * Registers link, which passes all data to and from tiny_fd protocol handle.
+     * @param fd file descriptor of the link
+     * @param handle initialized tiny_fd protocol handle
+     * @return link id or negative value if there are no free link slots
+     */
+    int addFdLink(int fd, tiny_fd_handle_t handle);
+
+    /**
+     * Registers link, which passes all data to and from hdlc low level handle.
+     * @param fd file descriptor of the link
+     * @param handle initialized hdlc low level handle
+     * @return link id or negative value if there are no free link slots
+     */
+    int addHdlcLink(int fd, hdlc_ll_handle_t handle);
+
+    /**
+     * Sets callback, called once when end of stream or error is detected on the link.
+     * @param id link id, returned by addLink()
+     * @param onDown callback to call, nullptr to disable
+     */
+    void setDownCallback(int id, DownCallback onDown);
+
+    /**
+     * Unregisters the link. If there are operations in flight for the link, they are cancelled.
+     * @param id link id, returned by addLink()
+     */
+    void removeLink(int id);
+
+    /**
+     * Waits for I/O events and processes them for all links: calls rx callbacks and
+     * submits new writes for links, which have data to send.
+     * @param timeoutMs maximum time to wait for events in milliseconds
+     * @return number of processed events or negative value in case of error
+     */
+    int poll(int timeoutMs);
+
+    /**
+     * Returns true if io_uring is used, false if the engine works via epoll
+     */
+    bool isUring() const
+    {
+        return m_ringFd >= 0;
+    }
+
+private:
+    struct Link;
+    struct Ring;
+
+    int m_maxLinks;
+    int m_blockSize;
+    Link *m_links = nullptr;
+    uint8_t *m_buffers = nullptr;
+    Ring *m_ring = nullptr;
+    int m_ringFd = -1;
+    int m_epollFd = -1;
+
+    bool beginUring();
+    void endUring();
+    ::io_uring_sqe *nextSqe();
+    void commitSqe();
+    bool submitRead(int id);
+    bool submitWrite(int id);
+    bool submitPoll(int id, uint32_t events, int op);
+    int flushSubmissions(unsigned waitNr, int timeoutMs);
+    int pollUring(int timeoutMs);
+    int pollEpoll(int timeoutMs);
+    void processCompletion(uint64_t userData, int result);
+    void fillTx(int id);
+    bool writeEpoll(int id);
+    void updateEpoll(int id, bool force);
+    void linkDown(int id);
+};
+
+} // namespace tinyproto
+
+#endif
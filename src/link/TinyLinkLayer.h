@@ -34,6 +34,10 @@
 #include <stdint.h>
 #include <limits.h>
 
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+#include <atomic>
+#endif
+
 namespace tinyproto
 {
 
@@ -89,6 +93,61 @@ public:
      */
     virtual void flushTx() = 0;
 
+    /**
+     * Returns file descriptor, which becomes readable when new data arrive, or -1
+     * if the link cannot be used with poll/epoll. The descriptor is valid after begin() only.
+     */
+    virtual int getFd()
+    {
+        return -1;
+    }
+
+    /**
+     * Returns true, if the hardware channel has not accepted all data, prepared by runTx(), yet.
+     * The rest of data is sent by next runTx() calls.
+     */
+    virtual bool hasPendingTx()
+    {
+        return false;
+    }
+
+    /**
+     * Returns true, if the link keeps received data, which were not parsed due to holdRx().
+     * These data are parsed by next runRx() call before reading the hardware channel.
+     */
+    virtual bool hasPendingRx()
+    {
+        return false;
+    }
+
+    /**
+     * Asks runRx() to stop parsing received data after the current frame, because the receiver
+     * has no space for more frames. It is called from the frame read callback. Link layers, which
+     * cannot keep received data, ignore the request.
+     */
+    void holdRx()
+    {
+        m_rxHeld = true;
+    }
+
+    /**
+     * Returns false, if the hardware channel is closed: the remote side has closed connection,
+     * or the device is unplugged. Link layers, which cannot detect that, are always up.
+     */
+    bool isUp() const
+    {
+        return m_up;
+    }
+
+    /**
+     * Marks hardware channel as closed. It is called by link layer implementation, or by the runtime,
+     * which detects hang up on file descriptor of the link. The link is up again after begin().
+     */
+    void markDown()
+    {
+        m_up = false;
+    }
+
     /**
      * Sets timeout of Rx/Tx operations in milliseconds for the link layer protocol.
      * This is not the same timeout, as timeout used by put() method.
@@ -133,9 +192,35 @@ public:
      */
     virtual ~ILinkLayer() = default;
 
+protected:
+    void markUp()
+    {
+        m_up = true;
+    }
+
+    /**
+     * Returns true, if holdRx() was called after last releaseRx() call
+     */
+    bool isRxHeld() const
+    {
+        return m_rxHeld;
+    }
+
+    void releaseRx()
+    {
+        m_rxHeld = false;
+    }
+
 private:
     int m_mtu = 16384;
     uint32_t m_timeout = 0;
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1
+    // Link is marked down by Rx or Tx thread, and the state is checked by other threads
+    std::atomic<bool> m_up{true};
+#else
+    bool m_up = true;
+#endif
+    bool m_rxHeld = false;
 };
 
 } // namespace tinyproto
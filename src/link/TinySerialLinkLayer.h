@@ -31,6 +31,8 @@
 #include "link/TinyLinkLayer.h"
 #include "interface/TinySerial.h"
 
+#include <string.h>
+
 namespace tinyproto
 {
 
@@ -39,8 +41,9 @@ namespace tinyproto
  *
  * @param BASE Base class for protocol type: IFdLinkLayer or IHdlcLinkLayer.
  * @param BSIZE Maximum block size which can be transmitted via Serial Link as single block
+ * @param IO Transport class with tinyproto::Serial interface: Serial, TcpSocket, UdpSocket, UnixSocket.
  */
-template <class BASE, int BSIZE> class ISerialLinkLayer: public BASE
+template <class BASE, int BSIZE, class IO = tinyproto::Serial> class ISerialLinkLayer: public BASE
 {
 public:
     ISerialLinkLayer(char *dev, void *buffer, int size)
@@ -53,7 +56,16 @@ public:
     {
         bool result = BASE::begin(onReadCb, onSendCb, udata);
         m_serial.setTimeout( this->getTimeout() );
-        return result && m_serial.begin(m_speed);
+        result = result && m_serial.begin(m_speed);
+        m_rxLen = 0;
+        m_rxPos = 0;
+        m_txLen = 0;
+        m_txPos = 0;
+        if ( result )
+        {
+            this->markUp();
+        }
+        return result;
     }
 
     void end() override
@@ -64,47 +76,96 @@ public:
 
     void runRx() override
     {
-        uint8_t buf[BSIZE];
-        uint8_t *p = buf;
-
-        int len = m_serial.readBytes(p, BSIZE);
-        while ( len > 0 )
+        this->releaseRx();
+        if ( m_rxPos == m_rxLen )
+        {
+            int len = m_serial.readBytes(m_rxBuf, BSIZE);
+            if ( len < 0 )
+            {
+                // Transport reports closed channel: remote side disconnected or device is unplugged
+                this->markDown();
+            }
+            m_rxLen = len > 0 ? len : 0;
+            m_rxPos = 0;
+        }
+        // Data are parsed frame by frame, so the receiver can stop parsing, when it has no space for frames
+        while ( m_rxPos < m_rxLen && !this->isRxHeld() )
         {
-            int temp = BASE::parseData( p, len);
-            if ( temp < 0 )
+            const uint8_t *flag = static_cast<const uint8_t *>(
+                memchr( m_rxBuf + m_rxPos, HDLC_FLAG, m_rxLen - m_rxPos ) );
+            int len = flag ? static_cast<int>(flag - m_rxBuf) - m_rxPos + 1 : m_rxLen - m_rxPos;
+            int temp = BASE::parseData( m_rxBuf + m_rxPos, len );
+            if ( temp <= 0 )
             {
+                m_rxPos = m_rxLen;
                 break;
             }
-            len -= temp;
-            p += temp;
+            m_rxPos += temp;
         }
     }
 
+    bool hasPendingRx() override
+    {
+        return m_rxPos < m_rxLen;
+    }
+
     void runTx() override
     {
-        uint8_t buf[BSIZE];
-        int len = BASE::getData( buf, BSIZE );
-        uint8_t *ptr = buf;
-        while ( len > 0 )
+        if ( m_txPos == m_txLen )
         {
-            int sent = m_serial.write(ptr, len);
+            int len = BASE::getData( m_txBuf, BSIZE );
+            m_txLen = len > 0 ? len : 0;
+            m_txPos = 0;
+        }
+        while ( m_txPos < m_txLen )
+        {
+            int sent = m_serial.write(m_txBuf + m_txPos, m_txLen - m_txPos);
             if ( sent < 0 )
             {
+                // Encoded data cannot be sent anymore
+                this->markDown();
+                m_txLen = 0;
+                m_txPos = 0;
+                break;
+            }
+            if ( sent == 0 )
+            {
+                // Hardware channel is busy, the rest is sent by next runTx() call
                 break;
             }
-            ptr += sent;
-            len -= sent;
+            m_txPos += sent;
         }
     }
 
+    bool hasPendingTx() override
+    {
+        return m_txPos < m_txLen;
+    }
+
     void setSpeed( uint32_t speed )
     {
         m_speed = speed;
     }
 
+#if defined(__linux__)
+    int getFd() override
+    {
+        return m_serial.getFd();
+    }
+#endif
+
 private:
+    /** FD and HDLC links use HDLC framing, each frame ends with flag byte */
+    static constexpr uint8_t HDLC_FLAG = 0x7E;
+
     uint32_t m_speed = 115200;
-    tinyproto::Serial m_serial;
+    IO m_serial;
+    uint8_t m_rxBuf[BSIZE];
+    int m_rxLen = 0;
+    int m_rxPos = 0;
+    uint8_t m_txBuf[BSIZE];
+    int m_txLen = 0;
+    int m_txPos = 0;
 };
 
 } // namespace tinyproto
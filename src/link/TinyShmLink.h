@@ -0,0 +1,97 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#pragma once
+
+#include "TinySerialFdLink.h"
+#include "TinySerialHdlcLink.h"
+
+#if defined(__linux__)
+
+#include <string.h>
+
+namespace tinyproto
+{
+
+/**
+ * Holds "shm:<name>" port name. It is used as the first base class of shared memory links,
+ * so the name is constructed before the serial link layer, which keeps pointer to it.
+ * Names longer than TINY_SHM_MAX_NAME_LEN are rejected: begin() of the link fails.
+ */
+class ShmPortName
+{
+protected:
+    explicit ShmPortName(const char *name)
+    {
+        size_t len = strlen(name);
+        if ( len <= TINY_SHM_MAX_NAME_LEN )
+        {
+            memcpy(m_portName, "shm:", 4);
+            memcpy(m_portName + 4, name, len + 1);
+        }
+        else
+        {
+            // Truncated name would connect to another port, so make the port invalid
+            m_portName[0] = '\0';
+        }
+    }
+
+    char m_portName[sizeof("shm:") + TINY_SHM_MAX_NAME_LEN];
+};
+
+/**
+ * Full duplex link layer over shared memory ring between two processes on the same host.
+ * Both sides must use the same name. No TTY or socket is involved in data transfer.
+ */
+class ShmFdLink: private ShmPortName, public SerialFdLink
+{
+public:
+    explicit ShmFdLink(const char *name)
+        : ShmPortName(name)
+        , SerialFdLink(m_portName)
+    {
+    }
+};
+
+/**
+ * Hdlc link layer over shared memory ring between two processes on the same host.
+ * Both sides must use the same name. No TTY or socket is involved in data transfer.
+ */
+class ShmHdlcLink: private ShmPortName, public SerialHdlcLink
+{
+public:
+    explicit ShmHdlcLink(const char *name)
+        : ShmPortName(name)
+        , SerialHdlcLink(m_portName)
+    {
+    }
+};
+
+} // namespace tinyproto
+
+#endif
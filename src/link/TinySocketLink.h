@@ -0,0 +1,145 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#pragma once
+
+#include "TinySerialLinkLayer.h"
+#include "TinyFdLinkLayer.h"
+#include "TinyHdlcLinkLayer.h"
+#include "interface/TinySocket.h"
+
+#if defined(__linux__)
+
+#include <stdlib.h>
+
+namespace tinyproto
+{
+
+/**
+ * Full duplex link layer over socket transport. The buffer for the protocol is allocated in begin().
+ * @param IO socket class: TcpSocket, UdpSocket or UnixSocket
+ * @param BSIZE size of block, read from or written to socket at once
+ */
+template <class IO, int BSIZE> class SocketFdLink: public ISerialLinkLayer<IFdLinkLayer, BSIZE, IO>
+{
+public:
+    /**
+     * Creates link layer.
+     * @param address socket address, refer to IO class for the format
+     */
+    explicit SocketFdLink(char *address)
+        : ISerialLinkLayer<IFdLinkLayer, BSIZE, IO>(address, nullptr, 0)
+    {
+    }
+
+    ~SocketFdLink()
+    {
+        free(m_buffer);
+    }
+
+    bool begin(on_frame_read_cb_t onReadCb, on_frame_send_cb_t onSendCb, void *udata) override
+    {
+        int size = tiny_fd_buffer_size_by_mtu_ex(1, this->getMtu(), this->getWindow(), this->getCrc(), 3);
+        m_buffer = reinterpret_cast<uint8_t *>(malloc(size));
+        this->setBuffer(m_buffer, size);
+        return ISerialLinkLayer<IFdLinkLayer, BSIZE, IO>::begin(onReadCb, onSendCb, udata);
+    }
+
+    void end() override
+    {
+        ISerialLinkLayer<IFdLinkLayer, BSIZE, IO>::end();
+        free(m_buffer);
+        m_buffer = nullptr;
+    }
+
+private:
+    uint8_t *m_buffer = nullptr;
+};
+
+/**
+ * Hdlc link layer over socket transport. The buffer for the protocol is allocated in begin().
+ * @param IO socket class: TcpSocket, UdpSocket or UnixSocket
+ * @param BSIZE size of block, read from or written to socket at once
+ */
+template <class IO, int BSIZE> class SocketHdlcLink: public ISerialLinkLayer<IHdlcLinkLayer, BSIZE, IO>
+{
+public:
+    /**
+     * Creates link layer.
+     * @param address socket address, refer to IO class for the format
+     */
+    explicit SocketHdlcLink(char *address)
+        : ISerialLinkLayer<IHdlcLinkLayer, BSIZE, IO>(address, nullptr, 0)
+    {
+    }
+
+    ~SocketHdlcLink()
+    {
+        free(m_buffer);
+    }
+
+    bool begin(on_frame_read_cb_t onReadCb, on_frame_send_cb_t onSendCb, void *udata) override
+    {
+        int size = hdlc_ll_get_buf_size_ex(this->getMtu(), this->getCrc(), 3);
+        m_buffer = reinterpret_cast<uint8_t *>(malloc(size));
+        this->setBuffer(m_buffer, size);
+        return ISerialLinkLayer<IHdlcLinkLayer, BSIZE, IO>::begin(onReadCb, onSendCb, udata);
+    }
+
+    void end() override
+    {
+        ISerialLinkLayer<IHdlcLinkLayer, BSIZE, IO>::end();
+        free(m_buffer);
+        m_buffer = nullptr;
+    }
+
+private:
+    uint8_t *m_buffer = nullptr;
+};
+
+/** Full duplex protocol over TCP connection, address is "host:port" */
+using TcpFdLink = SocketFdLink<TcpSocket, 4096>;
+
+/** Hdlc protocol over TCP connection, address is "host:port" */
+using TcpHdlcLink = SocketHdlcLink<TcpSocket, 4096>;
+
+/** Full duplex protocol over unix socket, address is path or "@name" for abstract socket */
+using UnixFdLink = SocketFdLink<UnixSocket, 4096>;
+
+/** Hdlc protocol over unix socket, address is path or "@name" for abstract socket */
+using UnixHdlcLink = SocketHdlcLink<UnixSocket, 4096>;
+
+/** Full duplex protocol over UDP, address is "host:port[:local_port]" */
+using UdpFdLink = SocketFdLink<UdpSocket, 4 * UdpSocket::DATAGRAM_SIZE>;
+
+/** Hdlc protocol over UDP, address is "host:port[:local_port]" */
+using UdpHdlcLink = SocketHdlcLink<UdpSocket, 4 * UdpSocket::DATAGRAM_SIZE>;
+
+} // namespace tinyproto
+
+#endif
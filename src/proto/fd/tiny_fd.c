@@ -75,16 +75,16 @@ static inline uint8_t __number_of_awaiting_tx_i_frames(tiny_fd_handle_t handle,
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static inline uint32_t __time_passed_since_last_frame_received(tiny_fd_handle_t handle, uint8_t peer)
+static inline uint64_t __time_passed_since_last_frame_received(tiny_fd_handle_t handle, uint8_t peer)
 {
-    return (uint32_t)(tiny_millis() - handle->peers[peer].last_ka_ts);
+    return tiny_micros64() - handle->peers[peer].last_ka_ts;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static inline uint32_t __time_passed_since_last_marker_seen(tiny_fd_handle_t handle)
+static inline uint64_t __time_passed_since_last_marker_seen(tiny_fd_handle_t handle)
 {
-    return (uint32_t)(tiny_millis() - handle->last_marker_ts);
+    return tiny_micros64() - handle->last_marker_ts;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -97,17 +97,19 @@ static void __switch_to_connected_state(tiny_fd_handle_t handle, uint8_t peer)
         handle->peers[peer].confirm_ns = 0;
         handle->peers[peer].last_ns = 0;
         handle->peers[peer].next_ns = 0;
+        handle->peers[peer].fresh_ns = 0;
+        handle->peers[peer].urgent_count = 0;
         handle->peers[peer].next_nr = 0;
         handle->peers[peer].sent_nr = 0;
         handle->peers[peer].sent_reject = 0;
         tiny_fd_queue_reset_for( &handle->frames.i_queue, __peer_to_address_field( handle, peer ) );
         // Reset last arrived frame timestamp on connection.
         // This is required to avoid disconnection on keep alive timeout at the beginning of connection
-        handle->peers[peer].last_ka_ts = tiny_millis();
+        handle->peers[peer].last_ka_ts = tiny_micros64();
         tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
         tiny_events_set(
             &handle->events,
-            FD_EVENT_TX_DATA_AVAILABLE |
+            FD_EVENT_TX_DATA_AVAILABLE | FD_EVENT_CHANNEL_HAS_FREE_SLOTS |
                 (tiny_fd_queue_has_free_slots(&handle->frames.i_queue) ? FD_EVENT_QUEUE_HAS_FREE_SLOTS : 0));
         LOG(TINY_LOG_CRIT, "[%p] Connection is established\n", handle);
         if ( handle->on_connect_event_cb )
@@ -127,16 +129,32 @@ static void __switch_to_disconnected_state(tiny_fd_handle_t handle, uint8_t peer
 {
     if ( handle->peers[peer].state != TINY_FD_STATE_DISCONNECTED )
     {
+        uint16_t tickets[8];
+        int tickets_count = __collect_tickets( handle, peer, tickets );
         handle->peers[peer].state = TINY_FD_STATE_DISCONNECTED;
         handle->peers[peer].confirm_ns = 0;
         handle->peers[peer].last_ns = 0;
         handle->peers[peer].next_ns = 0;
+        handle->peers[peer].fresh_ns = 0;
+        handle->peers[peer].urgent_count = 0;
         handle->peers[peer].next_nr = 0;
         handle->peers[peer].sent_nr = 0;
         handle->peers[peer].sent_reject = 0;
         tiny_fd_queue_reset_for( &handle->frames.i_queue, __peer_to_address_field( handle, peer ) );
         tiny_events_clear(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+        tiny_events_set(&handle->events, FD_EVENT_CHANNEL_HAS_FREE_SLOTS);
         LOG(TINY_LOG_CRIT, "[%p] Disconnected\n", handle);
+        if ( tickets_count && handle->on_complete_cb )
+        {
+            tiny_mutex_unlock(&handle->frames.mutex);
+            for ( int i = 0; i < tickets_count; i++ )
+            {
+                handle->on_complete_cb(handle->user_data,
+                                       __is_primary_station( handle ) ? (__peer_to_address_field( handle, peer ) >> 2) : TINY_FD_PRIMARY_ADDR,
+                                       tickets[i], TINY_ERR_FAILED);
+            }
+            tiny_mutex_lock(&handle->frames.mutex);
+        }
         if ( handle->on_connect_event_cb )
         {
             tiny_mutex_unlock(&handle->frames.mutex);
@@ -166,7 +184,7 @@ static void on_frame_read(void *user_data, uint8_t *data, int len)
         return;
     }
     tiny_mutex_lock(&handle->frames.mutex);
-    handle->peers[peer].last_ka_ts = tiny_millis();
+    handle->peers[peer].last_ka_ts = tiny_micros64();
     handle->peers[peer].ka_confirmed = 1;
     uint8_t control = ((uint8_t *)data)[1];
     if ( (control & HDLC_U_FRAME_MASK) == HDLC_U_FRAME_MASK )
@@ -223,14 +241,22 @@ static void on_frame_send(void *user_data, const uint8_t *data, int len)
     tiny_mutex_lock(&handle->frames.mutex);
     if ( (control & HDLC_I_FRAME_MASK) == HDLC_I_FRAME_BITS )
     {
-        (void)(peer);
-        // nothing to do
+        // nothing to do except counting
         // we need to wait for confirmation from remote side
+        handle->peers[peer].stats.i_frames_sent++;
     }
     else if ( (control & HDLC_S_FRAME_MASK) == HDLC_S_FRAME_BITS )
     {
         tiny_fd_queue_free_by_header( &handle->frames.s_queue, data );
     }
+    else if ( (control & HDLC_U_FRAME_MASK) == HDLC_U_FRAME_BITS && handle->tx_datagram != NULL &&
+              data == (const uint8_t *)&handle->tx_datagram->header )
+    {
+        // Datagrams are never confirmed, so the slot is released right after sending
+        tiny_fd_queue_free( &handle->frames.i_queue, handle->tx_datagram );
+        handle->tx_datagram = NULL;
+        tiny_events_set(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS | FD_EVENT_CHANNEL_HAS_FREE_SLOTS);
+    }
     else if ( (control & HDLC_U_FRAME_MASK) == HDLC_U_FRAME_BITS )
     {
         tiny_fd_queue_free_by_header( &handle->frames.s_queue, data );
@@ -287,11 +313,21 @@ int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
         LOG(TINY_LOG_CRIT, "HDLC doesn't support less than 2-frames queue%s", "\n");
         return TINY_ERR_INVALID_DATA;
     }
-    if ( !init->retry_timeout && !init->send_timeout )
+    if ( !init->retry_timeout && !init->retry_timeout_us && !init->send_timeout )
     {
         LOG(TINY_LOG_CRIT, "HDLC uses timeouts for ACK, at least retry_timeout, or send_timeout must be specified%s", "\n");
         return TINY_ERR_INVALID_DATA;
     }
+    if ( init->urgent_slots && init->urgent_slots >= init->window_frames - 1 )
+    {
+        LOG(TINY_LOG_CRIT, "Too many slots reserved for urgent frames %i\n", init->urgent_slots);
+        return TINY_ERR_INVALID_DATA;
+    }
+    if ( init->channels > TINY_FD_MAX_CHANNELS || (init->channels && init->mtu < 2) )
+    {
+        LOG(TINY_LOG_CRIT, "Invalid number of logical channels %i (max %i)\n", init->channels, TINY_FD_MAX_CHANNELS);
+        return TINY_ERR_INVALID_DATA;
+    }
     memset(init->buffer, 0, init->buffer_size);
 
     /* Lets locate main FD protocol data at the beginning of specified buffer.
@@ -367,14 +403,27 @@ int tiny_fd_init(tiny_fd_handle_t *handle, tiny_fd_init_t *init)
     protocol->on_read_cb = init->on_read_cb;
     protocol->on_send_cb = init->on_send_cb;
     protocol->on_connect_event_cb = init->on_connect_event_cb;
+    protocol->on_datagram_cb = init->on_datagram_cb;
+    protocol->on_complete_cb = init->on_complete_cb;
     protocol->send_timeout = init->send_timeout;
     // By default assign primary address
     protocol->addr = (init->addr ? (init->addr << 2) : HDLC_PRIMARY_ADDR ) | HDLC_E_BIT;
     protocol->mode = init->mode;
+    protocol->channels_count = init->channels;
+    protocol->urgent_slots = init->urgent_slots;
     // Primary devices always have markers
-    protocol->ka_timeout = 5000;
-    protocol->retry_timeout =
-        init->retry_timeout ? init->retry_timeout : (protocol->send_timeout / (init->retries + 1));
+    protocol->ka_timeout_us = init->ka_timeout_us ? init->ka_timeout_us : 5000000;
+    protocol->io_chunk = ( init->io_chunk_size && init->io_chunk_size < TINY_FD_IO_CHUNK_SIZE )
+                             ? init->io_chunk_size : TINY_FD_IO_CHUNK_SIZE;
+    if ( init->retry_timeout_us )
+    {
+        protocol->retry_timeout_us = init->retry_timeout_us;
+    }
+    else
+    {
+        protocol->retry_timeout_us = 1000UL * (init->retry_timeout ? init->retry_timeout
+                                                                   : (protocol->send_timeout / (init->retries + 1)));
+    }
     protocol->retries = init->retries;
     for (uint8_t peer = 0; peer < protocol->peers_count; peer++ )
     {
@@ -439,13 +488,22 @@ int tiny_fd_on_rx_data(tiny_fd_handle_t handle, const void *data, int len)
 
 int tiny_fd_run_rx(tiny_fd_handle_t handle, read_block_cb_t read_func)
 {
-    uint8_t buf[4];
-    int len = read_func(handle->user_data, buf, sizeof(buf));
-    if ( len <= 0 )
+    uint8_t buf[TINY_FD_IO_CHUNK_SIZE];
+    bool processed = false;
+    int result = TINY_SUCCESS;
+    int len;
+    do
     {
-        return len;
-    }
-    return tiny_fd_on_rx_data(handle, buf, len);
+        len = read_func(handle->user_data, buf, handle->io_chunk);
+        if ( len <= 0 )
+        {
+            // Do not report error, if some data are already processed
+            return processed ? result : len;
+        }
+        result = tiny_fd_on_rx_data(handle, buf, len);
+        processed = true;
+    } while ( len == handle->io_chunk );
+    return result;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -459,6 +517,8 @@ static uint8_t *tiny_fd_get_next_i_frame(tiny_fd_handle_t handle, int *len, uint
         // If sending of I-frames is not allowed then just exit
         return NULL;
     }
+    // Let high priority channels overtake frames, which were never sent yet
+    __schedule_fresh_i_frames( handle, peer, address );
     ptr = tiny_fd_queue_get_next( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, address, handle->peers[peer].next_ns );
     if ( ptr != NULL )
     {
@@ -468,11 +528,20 @@ static uint8_t *tiny_fd_get_next_i_frame(tiny_fd_handle_t handle, int *len, uint
             handle->peers[peer].next_ns, data[0], __is_primary_station( handle ) ? "secondary" : "primary" );
         ptr->header.control &= 0x0F;
         ptr->header.control |= (handle->peers[peer].next_nr << 5);
+        if ( handle->peers[peer].next_ns == handle->peers[peer].fresh_ns )
+        {
+            handle->peers[peer].fresh_ns = (handle->peers[peer].next_ns + 1) & seq_bits_mask;
+            if ( ptr->urgent )
+            {
+                ptr->urgent = 0;
+                handle->peers[peer].urgent_count--;
+            }
+        }
         handle->peers[peer].next_ns++;
         handle->peers[peer].next_ns &= seq_bits_mask;
         // Move to different place
         handle->peers[peer].sent_nr = handle->peers[peer].next_nr;
-        handle->peers[peer].last_i_ts = tiny_millis();
+        handle->peers[peer].last_i_ts = tiny_micros64();
     }
     return data;
 }
@@ -487,6 +556,10 @@ static uint8_t *tiny_fd_get_next_frame_to_send(tiny_fd_handle_t handle, int *len
     const uint8_t address = __peer_to_address_field( handle, peer );
     data = tiny_fd_get_next_s_u_frame_to_send(handle, len, peer, address);
     if ( data == NULL )
+    {
+        data = tiny_fd_get_next_datagram(handle, len, address);
+    }
+    if ( data == NULL )
     {
         data = tiny_fd_get_next_i_frame(handle, len, peer, address);
     }
@@ -517,8 +590,8 @@ static uint8_t *tiny_fd_get_next_frame_to_send(tiny_fd_handle_t handle, int *len
     {
         tiny_frame_header_t *header = (tiny_frame_header_t *)data;
         header->control |= HDLC_P_BIT;
-        handle->last_marker_ts = tiny_millis();
-        handle->peers[peer].last_ka_ts = tiny_millis();
+        handle->last_marker_ts = tiny_micros64();
+        handle->peers[peer].last_ka_ts = tiny_micros64();
     }
     tiny_mutex_unlock(&handle->frames.mutex);
     return data;
@@ -531,15 +604,14 @@ static void tiny_fd_connected_check_idle_timeout(tiny_fd_handle_t handle, uint8_
     tiny_mutex_lock(&handle->frames.mutex);
     // If all I-frames are sent and no respond from the remote side
     if ( __has_unconfirmed_frames(handle, peer) && __all_frames_are_sent(handle, peer) &&
-         __time_passed_since_last_i_frame(handle, peer) >= handle->retry_timeout )
+         __time_passed_since_last_i_frame(handle, peer) >= handle->retry_timeout_us )
     {
         // if sent frame was not confirmed due to noisy line
         if ( handle->peers[peer].retries > 0 )
         {
             LOG(TINY_LOG_WRN,
-                "[%p] Timeout, resending unconfirmed frames: last(%" PRIu32 " ms, now(%" PRIu32 " ms), timeout(%" PRIu32
-                " ms))\n",
-                handle, handle->peers[peer].last_i_ts, tiny_millis(), handle->retry_timeout);
+                "[%p] Timeout, resending unconfirmed frames: passed(%" PRIu32 " us), timeout(%" PRIu32 " us)\n",
+                handle, (uint32_t)__time_passed_since_last_i_frame(handle, peer), handle->retry_timeout_us);
             handle->peers[peer].retries--;
             // Do not use mutex for confirm_ns value as it is byte-value
             __resend_all_unconfirmed_frames(handle, peer, 0, handle->peers[peer].confirm_ns);
@@ -550,11 +622,12 @@ static void tiny_fd_connected_check_idle_timeout(tiny_fd_handle_t handle, uint8_
             __switch_to_disconnected_state(handle, peer);
         }
     }
-    else if ( __time_passed_since_last_frame_received(handle, peer) > handle->ka_timeout )
+    else if ( __time_passed_since_last_frame_received(handle, peer) > handle->ka_timeout_us )
     {
         if ( !handle->peers[peer].ka_confirmed )
         {
             LOG(TINY_LOG_CRIT, "[%p] No keep alive after timeout\n", handle);
+            handle->peers[peer].stats.ka_timeouts++;
             __switch_to_disconnected_state(handle, peer);
         }
         else
@@ -567,7 +640,7 @@ static void tiny_fd_connected_check_idle_timeout(tiny_fd_handle_t handle, uint8_
             handle->peers[peer].ka_confirmed = 0;
             __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_S_FRAME, &frame, 2);
         }
-        handle->peers[peer].last_ka_ts = tiny_millis();
+        handle->peers[peer].last_ka_ts = tiny_micros64();
     }
     tiny_mutex_unlock(&handle->frames.mutex);
 }
@@ -577,7 +650,7 @@ static void tiny_fd_connected_check_idle_timeout(tiny_fd_handle_t handle, uint8_
 static void tiny_fd_disconnected_check_idle_timeout(tiny_fd_handle_t handle, uint8_t peer)
 {
     tiny_mutex_lock(&handle->frames.mutex);
-    if ( __time_passed_since_last_frame_received(handle, peer) >= handle->retry_timeout )
+    if ( __time_passed_since_last_frame_received(handle, peer) >= handle->retry_timeout_us )
     {
         if ( __is_primary_station( handle ) ) // Only primary station can request connection
         {
@@ -594,7 +667,7 @@ static void tiny_fd_disconnected_check_idle_timeout(tiny_fd_handle_t handle, uin
                        handle->next_peer, __peer_to_address_field( handle, peer ));
             }
             handle->peers[peer].state = TINY_FD_STATE_CONNECTING;
-            handle->peers[peer].last_ka_ts = tiny_millis();
+            handle->peers[peer].last_ka_ts = tiny_micros64();
         }
     }
     tiny_mutex_unlock(&handle->frames.mutex);
@@ -662,7 +735,7 @@ int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t t
             }
             else if ( __is_primary_station( handle ) )
             {
-                if ( __time_passed_since_last_marker_seen(handle) >= handle->retry_timeout )
+                if ( __time_passed_since_last_marker_seen(handle) >= handle->retry_timeout_us )
                 {
                     // Return marker back as remote station not responding
                     LOG(TINY_LOG_CRIT, "[%p] RETURN MARKER BACK\n", handle );
@@ -695,29 +768,40 @@ int tiny_fd_get_tx_data(tiny_fd_handle_t handle, void *data, int len, uint32_t t
 
 int tiny_fd_run_tx(tiny_fd_handle_t handle, write_block_cb_t write_func)
 {
-    uint8_t buf[4];
-    int len = tiny_fd_get_tx_data(handle, buf, sizeof(buf), 1);
+    uint8_t buf[TINY_FD_IO_CHUNK_SIZE];
+    int len = tiny_fd_get_tx_data(handle, buf, handle->io_chunk, 1);
     if ( len <= 0 )
     {
         return len;
     }
-    uint8_t *ptr = buf;
-    while ( len )
+    while ( len > 0 )
     {
-        int result = write_func(handle->user_data, ptr, len);
-        if ( result < 0 )
+        uint8_t *ptr = buf;
+        int size = len;
+        while ( size )
+        {
+            int result = write_func(handle->user_data, ptr, size);
+            if ( result < 0 )
+            {
+                return result;
+            }
+            size -= result;
+            ptr += result;
+        }
+        // Partially filled chunk means, that there is nothing more to send right now
+        if ( len < handle->io_chunk )
         {
-            return result;
+            break;
         }
-        len -= result;
-        ptr += result;
+        len = tiny_fd_get_tx_data(handle, buf, handle->io_chunk, 0);
     }
     return TINY_SUCCESS;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-int tiny_fd_send_packet_to(tiny_fd_handle_t handle, uint8_t address, const void *data, int len, uint32_t timeout)
+static int __send_i_frame(tiny_fd_handle_t handle, uint8_t address, uint8_t channel, bool urgent, const void *data,
+                          int len, uint32_t timeout)
 {
     int result;
     uint8_t peer;
@@ -733,69 +817,326 @@ int tiny_fd_send_packet_to(tiny_fd_handle_t handle, uint8_t address, const void
         LOG(TINY_LOG_ERR, "[%p] PUT frame error: Unknown peer\n", handle);
         return TINY_ERR_UNKNOWN_PEER;
     }
+    if ( channel >= (handle->channels_count ? handle->channels_count : 1) )
+    {
+        LOG(TINY_LOG_ERR, "[%p] PUT frame error: Unknown channel %i\n", handle, channel);
+        return TINY_ERR_INVALID_DATA;
+    }
     // Check frame size againts mtu
     // MTU doesn't include header and crc fields, only user payload
     uint32_t start_ms = tiny_millis();
-    if ( len > tiny_fd_queue_get_mtu( &handle->frames.i_queue ) )
+    if ( len > tiny_fd_get_mtu( handle ) )
     {
-        LOG(TINY_LOG_ERR, "[%p] PUT frame error: data len %i is greater MTU %i\n", handle, len, handle->frames.i_queue.mtu);
-        result = TINY_ERR_DATA_TOO_LARGE;
+        LOG(TINY_LOG_ERR, "[%p] PUT frame error: data len %i is greater MTU %i\n", handle, len, tiny_fd_get_mtu( handle ));
+        return TINY_ERR_DATA_TOO_LARGE;
     }
-    // Wait until there is room for new frame
-    else if ( tiny_events_wait(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES, EVENT_BITS_CLEAR, timeout) )
+    for ( ;; )
     {
         uint32_t delta_ms = (uint32_t)(tiny_millis() - start_ms);
-        if ( tiny_events_wait(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS, EVENT_BITS_CLEAR,
+        // Wait until there is room for new frame
+        if ( !tiny_events_wait(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES, EVENT_BITS_CLEAR,
                                timeout > delta_ms ? (timeout - delta_ms) : 0) )
         {
-            tiny_mutex_lock(&handle->frames.mutex);
-            // Check if space is actually available
-            if ( __put_i_frame_to_tx_queue(handle, peer, data, len) )
+            LOG(TINY_LOG_WRN, "[%p] PUT frame timeout\n", handle);
+            result = TINY_ERR_TIMEOUT;
+            break;
+        }
+        delta_ms = (uint32_t)(tiny_millis() - start_ms);
+        if ( !tiny_events_wait(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS, EVENT_BITS_CLEAR,
+                               timeout > delta_ms ? (timeout - delta_ms) : 0) )
+        {
+            // Put flag back, since HDLC protocol allows to send next frame, while
+            // Tx queue is completely busy
+            tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+            LOG(TINY_LOG_WRN, "[%p] PUT frame timeout\n", handle);
+            result = TINY_ERR_TIMEOUT;
+            break;
+        }
+        tiny_mutex_lock(&handle->frames.mutex);
+        if ( urgent ? !tiny_fd_queue_has_free_slots( &handle->frames.i_queue ) : !__channel_has_free_slots( handle, channel ) )
+        {
+            // Channel quota is exhausted or only reserved slots are left: give the slot back and wait until slots are released
+            tiny_events_clear(&handle->events, FD_EVENT_CHANNEL_HAS_FREE_SLOTS);
+            tiny_events_set(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS);
+            tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+            tiny_mutex_unlock(&handle->frames.mutex);
+            delta_ms = (uint32_t)(tiny_millis() - start_ms);
+            if ( !tiny_events_wait(&handle->events, FD_EVENT_CHANNEL_HAS_FREE_SLOTS, EVENT_BITS_LEAVE,
+                                   timeout > delta_ms ? (timeout - delta_ms) : 0) )
             {
-                if ( tiny_fd_queue_has_free_slots( &handle->frames.i_queue ) )
-                {
-                    LOG(TINY_LOG_INFO, "[%p] I_QUEUE is N(S)queue=%d, N(S)confirm=%d, N(S)next=%d\n", handle,
-                        handle->peers[peer].last_ns, handle->peers[peer].confirm_ns, handle->peers[peer].next_ns);
-                    tiny_events_set(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS);
-                }
-                else
-                {
-                    LOG(TINY_LOG_ERR, "[%p] I_QUEUE is full N(S)queue=%d, N(S)confirm=%d, N(S)next=%d\n", handle,
-                        handle->peers[peer].last_ns, handle->peers[peer].confirm_ns, handle->peers[peer].next_ns);
-                }
-                result = TINY_SUCCESS;
+                LOG(TINY_LOG_WRN, "[%p] PUT frame timeout: channel %i quota is exhausted\n", handle, channel);
+                result = TINY_ERR_TIMEOUT;
+                break;
             }
-            else
+            continue;
+        }
+        // Check if space is actually available
+        if ( __put_i_frame_to_tx_queue(handle, peer, channel, urgent, data, len) )
+        {
+            tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
+            if ( tiny_fd_queue_has_free_slots( &handle->frames.i_queue ) )
             {
-                result = TINY_ERR_TIMEOUT;
-                // !!!! If this log appears, then in the code of the protocol something is definitely wrong !!!!
-                LOG(TINY_LOG_ERR, "[%p] Wrong flag FD_EVENT_QUEUE_HAS_FREE_SLOTS\n", handle);
+                LOG(TINY_LOG_INFO, "[%p] I_QUEUE is N(S)queue=%d, N(S)confirm=%d, N(S)next=%d\n", handle,
+                    handle->peers[peer].last_ns, handle->peers[peer].confirm_ns, handle->peers[peer].next_ns);
+                tiny_events_set(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS);
             }
-            if ( __can_accept_i_frames( handle, peer ) )
+            else
             {
-                tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+                LOG(TINY_LOG_ERR, "[%p] I_QUEUE is full N(S)queue=%d, N(S)confirm=%d, N(S)next=%d\n", handle,
+                    handle->peers[peer].last_ns, handle->peers[peer].confirm_ns, handle->peers[peer].next_ns);
             }
-            tiny_mutex_unlock(&handle->frames.mutex);
+            result = TINY_SUCCESS;
         }
         else
         {
-            // Put flag back, since HDLC protocol allows to send next frame, while
-            // Tx queue is completely busy
-            tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
-            LOG(TINY_LOG_WRN, "[%p] PUT frame timeout\n", handle);
             result = TINY_ERR_TIMEOUT;
+            // !!!! If this log appears, then in the code of the protocol something is definitely wrong !!!!
+            LOG(TINY_LOG_ERR, "[%p] Wrong flag FD_EVENT_QUEUE_HAS_FREE_SLOTS\n", handle);
         }
+        if ( __can_accept_i_frames( handle, peer ) )
+        {
+            tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+        }
+        tiny_mutex_unlock(&handle->frames.mutex);
+        break;
     }
-    else
+    if ( result == TINY_ERR_TIMEOUT )
+    {
+        tiny_mutex_lock(&handle->frames.mutex);
+        handle->peers[peer].stats.queue_full++;
+        tiny_mutex_unlock(&handle->frames.mutex);
+    }
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_send_channel_packet_to(tiny_fd_handle_t handle, uint8_t address, uint8_t channel, const void *data, int len,
+                                   uint32_t timeout)
+{
+    return __send_i_frame(handle, address, channel, false, data, len, timeout);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_send_packet_to(tiny_fd_handle_t handle, uint8_t address, const void *data, int len, uint32_t timeout)
+{
+    return __send_i_frame(handle, address, 0, false, data, len, timeout);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_send_urgent_to(tiny_fd_handle_t handle, uint8_t address, const void *data, int len, uint32_t timeout)
+{
+    return __send_i_frame(handle, address, 0, true, data, len, timeout);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_send_urgent(tiny_fd_handle_t handle, const void *data, int len, uint32_t timeout)
+{
+    return __send_i_frame(handle, TINY_FD_PRIMARY_ADDR, 0, true, data, len, timeout);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_send_datagram_to(tiny_fd_handle_t handle, uint8_t address, const void *data, int len, uint8_t flags)
+{
+    if ( __is_secondary_station( handle ) && address == TINY_FD_PRIMARY_ADDR )
+    {
+        // For secondary stations the address is actually from field
+        address = handle->addr;
+    }
+    uint8_t peer = __address_field_to_peer( handle, (address << 2) | HDLC_E_BIT );
+    if ( peer == 0xFF )
+    {
+        LOG(TINY_LOG_ERR, "[%p] PUT datagram error: Unknown peer\n", handle);
+        return TINY_ERR_UNKNOWN_PEER;
+    }
+    if ( len > tiny_fd_queue_get_mtu( &handle->frames.i_queue ) )
+    {
+        LOG(TINY_LOG_ERR, "[%p] PUT datagram error: data len %i is greater MTU %i\n", handle, len,
+            tiny_fd_queue_get_mtu( &handle->frames.i_queue ));
+        return TINY_ERR_DATA_TOO_LARGE;
+    }
+    tiny_mutex_lock(&handle->frames.mutex);
+    int result = __put_datagram_to_tx_queue(handle, peer, data, len, flags);
+    if ( result == TINY_ERR_BUSY )
+    {
+        handle->peers[peer].stats.queue_full++;
+    }
+    tiny_mutex_unlock(&handle->frames.mutex);
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_send_datagram(tiny_fd_handle_t handle, const void *data, int len, uint8_t flags)
+{
+    return tiny_fd_send_datagram_to(handle, TINY_FD_PRIMARY_ADDR, data, len, flags);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_submit_packet_to(tiny_fd_handle_t handle, uint8_t address, const void *data, int len)
+{
+    if ( __is_secondary_station( handle ) && address == TINY_FD_PRIMARY_ADDR )
     {
-        LOG(TINY_LOG_WRN, "[%p] PUT frame timeout\n", handle);
-        result = TINY_ERR_TIMEOUT;
+        // For secondary stations the address is actually from field
+        address = handle->addr;
     }
+    uint8_t peer = __address_field_to_peer( handle, (address << 2) | HDLC_E_BIT );
+    if ( peer == 0xFF )
+    {
+        LOG(TINY_LOG_ERR, "[%p] SUBMIT frame error: Unknown peer\n", handle);
+        return TINY_ERR_UNKNOWN_PEER;
+    }
+    if ( len > tiny_fd_get_mtu( handle ) )
+    {
+        LOG(TINY_LOG_ERR, "[%p] SUBMIT frame error: data len %i is greater MTU %i\n", handle, len, tiny_fd_get_mtu( handle ));
+        return TINY_ERR_DATA_TOO_LARGE;
+    }
+    int result = TINY_ERR_BUSY;
+    tiny_mutex_lock(&handle->frames.mutex);
+    // The same conditions, which FD_EVENT_CAN_ACCEPT_I_FRAMES and FD_EVENT_QUEUE_HAS_FREE_SLOTS flags reflect
+    if ( handle->peers[peer].state == TINY_FD_STATE_CONNECTED && __can_accept_i_frames( handle, peer ) &&
+         __channel_has_free_slots( handle, 0 ) )
+    {
+        tiny_fd_frame_info_t *slot = __put_i_frame_to_tx_queue(handle, peer, 0, false, data, len);
+        if ( slot != NULL )
+        {
+            result = __assign_ticket( handle, slot );
+            tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
+        }
+        if ( !__can_accept_i_frames( handle, peer ) )
+        {
+            tiny_events_clear(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+        }
+        if ( !tiny_fd_queue_has_free_slots( &handle->frames.i_queue ) )
+        {
+            tiny_events_clear(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS);
+        }
+    }
+    if ( result == TINY_ERR_BUSY )
+    {
+        handle->peers[peer].stats.queue_full++;
+    }
+    tiny_mutex_unlock(&handle->frames.mutex);
     return result;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
+int tiny_fd_send_batch(tiny_fd_handle_t handle, uint8_t address, const tiny_iovec_t *msgs, int count, uint32_t timeout)
+{
+    if ( __is_secondary_station( handle ) && address == TINY_FD_PRIMARY_ADDR )
+    {
+        // For secondary stations the address is actually from field
+        address = handle->addr;
+    }
+    uint8_t peer = __address_field_to_peer( handle, (address << 2) | HDLC_E_BIT );
+    if ( peer == 0xFF )
+    {
+        LOG(TINY_LOG_ERR, "[%p] PUT batch error: Unknown peer\n", handle);
+        return TINY_ERR_UNKNOWN_PEER;
+    }
+    if ( count <= 0 )
+    {
+        return 0;
+    }
+    const int mtu = tiny_fd_get_mtu( handle );
+    if ( msgs[0].len > mtu )
+    {
+        LOG(TINY_LOG_ERR, "[%p] PUT batch error: data len %i is greater MTU %i\n", handle, msgs[0].len, mtu);
+        return TINY_ERR_DATA_TOO_LARGE;
+    }
+    uint32_t start_ms = tiny_millis();
+    int timed_out = 0;
+    // Wait until there is room for the first frame, the same way as __send_i_frame() does
+    for ( ;; )
+    {
+        uint32_t delta_ms = (uint32_t)(tiny_millis() - start_ms);
+        if ( !tiny_events_wait(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES, EVENT_BITS_CLEAR,
+                               timeout > delta_ms ? (timeout - delta_ms) : 0) )
+        {
+            timed_out = 1;
+            break;
+        }
+        delta_ms = (uint32_t)(tiny_millis() - start_ms);
+        if ( !tiny_events_wait(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS, EVENT_BITS_CLEAR,
+                               timeout > delta_ms ? (timeout - delta_ms) : 0) )
+        {
+            tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+            timed_out = 1;
+            break;
+        }
+        tiny_mutex_lock(&handle->frames.mutex);
+        if ( __channel_has_free_slots( handle, 0 ) )
+        {
+            // The lock is kept to put the frames
+            break;
+        }
+        // Channel quota is exhausted or only reserved slots are left: give the slot back and wait until slots are released
+        tiny_events_clear(&handle->events, FD_EVENT_CHANNEL_HAS_FREE_SLOTS);
+        tiny_events_set(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS);
+        tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+        tiny_mutex_unlock(&handle->frames.mutex);
+        delta_ms = (uint32_t)(tiny_millis() - start_ms);
+        if ( !tiny_events_wait(&handle->events, FD_EVENT_CHANNEL_HAS_FREE_SLOTS, EVENT_BITS_LEAVE,
+                               timeout > delta_ms ? (timeout - delta_ms) : 0) )
+        {
+            timed_out = 1;
+            break;
+        }
+    }
+    if ( timed_out )
+    {
+        LOG(TINY_LOG_WRN, "[%p] PUT batch timeout\n", handle);
+        tiny_mutex_lock(&handle->frames.mutex);
+        handle->peers[peer].stats.queue_full++;
+        tiny_mutex_unlock(&handle->frames.mutex);
+        return 0;
+    }
+    int accepted = 0;
+    while ( accepted < count && msgs[accepted].len <= mtu && __can_accept_i_frames( handle, peer ) &&
+            __channel_has_free_slots( handle, 0 ) )
+    {
+        if ( !__put_i_frame_to_tx_queue(handle, peer, 0, false, msgs[accepted].data, msgs[accepted].len) )
+        {
+            break;
+        }
+        accepted++;
+    }
+    LOG(TINY_LOG_INFO, "[%p] I_QUEUE batch of %d frames, N(S)queue=%d, N(S)confirm=%d, N(S)next=%d\n", handle, accepted,
+        handle->peers[peer].last_ns, handle->peers[peer].confirm_ns, handle->peers[peer].next_ns);
+    if ( accepted < count && msgs[accepted].len > mtu )
+    {
+        LOG(TINY_LOG_ERR, "[%p] PUT batch error: message %i len %i is greater MTU %i\n", handle, accepted,
+            msgs[accepted].len, mtu);
+    }
+    else if ( accepted < count )
+    {
+        // Not all messages fit the queue
+        handle->peers[peer].stats.queue_full++;
+    }
+    if ( accepted )
+    {
+        tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
+    }
+    if ( tiny_fd_queue_has_free_slots( &handle->frames.i_queue ) )
+    {
+        tiny_events_set(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS);
+    }
+    if ( __can_accept_i_frames( handle, peer ) )
+    {
+        tiny_events_set(&handle->peers[peer].events, FD_EVENT_CAN_ACCEPT_I_FRAMES);
+    }
+    tiny_mutex_unlock(&handle->frames.mutex);
+    return accepted;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int tiny_fd_send_packet(tiny_fd_handle_t handle, const void *data, int len, uint32_t timeout)
 {
     return tiny_fd_send_packet_to(handle, TINY_FD_PRIMARY_ADDR, data, len, timeout);
@@ -832,14 +1173,39 @@ int tiny_fd_buffer_size_by_mtu_ex(uint8_t peers_count, int mtu, int tx_window, h
 
 void tiny_fd_set_ka_timeout(tiny_fd_handle_t handle, uint32_t keep_alive)
 {
-    handle->ka_timeout = keep_alive;
+    handle->ka_timeout_us = keep_alive * 1000UL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void tiny_fd_set_ka_timeout_us(tiny_fd_handle_t handle, uint32_t keep_alive_us)
+{
+    handle->ka_timeout_us = keep_alive_us;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 int tiny_fd_get_mtu(tiny_fd_handle_t handle)
 {
-    return tiny_fd_queue_get_mtu( &handle->frames.i_queue );
+    return tiny_fd_queue_get_mtu( &handle->frames.i_queue ) - __channel_header_size( handle );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int tiny_fd_set_channel(tiny_fd_handle_t handle, uint8_t channel, const tiny_fd_channel_init_t *init)
+{
+    if ( !handle || !init || channel >= handle->channels_count )
+    {
+        return TINY_ERR_INVALID_DATA;
+    }
+    tiny_mutex_lock(&handle->frames.mutex);
+    handle->channels[channel].priority = init->priority;
+    handle->channels[channel].quota = init->quota;
+    handle->channels[channel].on_read_cb = init->on_read_cb;
+    tiny_mutex_unlock(&handle->frames.mutex);
+    // Quota could be increased
+    tiny_events_set(&handle->events, FD_EVENT_CHANNEL_HAS_FREE_SLOTS);
+    return TINY_SUCCESS;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -850,7 +1216,7 @@ int tiny_fd_send_to(tiny_fd_handle_t handle, uint8_t address, const void *data,
     int left = len;
     while ( left > 0 )
     {
-        int size = left < tiny_fd_queue_get_mtu( &handle->frames.i_queue ) ? left : tiny_fd_queue_get_mtu( &handle->frames.i_queue );
+        int size = left < tiny_fd_get_mtu( handle ) ? left : tiny_fd_get_mtu( handle );
         int result = tiny_fd_send_packet_to(handle, address, ptr, size, timeout);
         if ( result != TINY_SUCCESS )
         {
@@ -889,6 +1255,38 @@ int tiny_fd_get_status(tiny_fd_handle_t handle)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+int tiny_fd_get_stats(tiny_fd_handle_t handle, uint8_t address, tiny_fd_stats_t *stats)
+{
+    if ( !handle || !stats )
+    {
+        return TINY_ERR_INVALID_DATA;
+    }
+    if ( __is_secondary_station( handle ) && address == TINY_FD_PRIMARY_ADDR )
+    {
+        // For secondary stations the address is actually from field
+        address = handle->addr;
+    }
+    hdlc_ll_stats_t link;
+    tiny_mutex_lock(&handle->frames.mutex);
+    uint8_t peer = __address_field_to_peer( handle, (address << 2) | HDLC_E_BIT );
+    if ( peer == 0xFF )
+    {
+        tiny_mutex_unlock(&handle->frames.mutex);
+        return TINY_ERR_UNKNOWN_PEER;
+    }
+    *stats = handle->peers[peer].stats;
+    tiny_mutex_unlock(&handle->frames.mutex);
+    hdlc_ll_get_stats(handle->_hdlc, &link);
+    stats->link_frames_sent = link.frames_sent;
+    stats->link_frames_received = link.frames_received;
+    stats->crc_errors = link.crc_errors;
+    stats->framing_errors = link.framing_errors;
+    stats->overflows = link.overflows;
+    return TINY_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int tiny_fd_disconnect(tiny_fd_handle_t handle)
 {
     uint8_t peer = 0; // TODO: Loop for all peers or for specific peer
@@ -939,7 +1337,7 @@ int tiny_fd_register_peer(tiny_fd_handle_t handle, uint8_t address)
         if ( handle->peers[peer].addr == 0xFF )
         {
             handle->peers[peer].addr = address;
-            handle->peers[peer].last_ka_ts = (uint32_t)(tiny_millis() - handle->retry_timeout);
+            handle->peers[peer].last_ka_ts = tiny_micros64() - handle->retry_timeout_us;
             tiny_mutex_unlock(&handle->frames.mutex);
             return TINY_SUCCESS;
         }
@@ -56,6 +56,22 @@ extern "C"
      */
     #define TINY_FD_PRIMARY_ADDR (0)
 
+#ifndef TINY_FD_MAX_CHANNELS
+    /**
+     * Maximum number of logical channels, which can be multiplexed over single FD connection.
+     * Each channel slot takes a few bytes of tiny_fd_data_t, so it can be redefined for
+     * small controllers.
+     */
+    #define TINY_FD_MAX_CHANNELS (4)
+#endif
+
+    /**
+     * Flag for tiny_fd_send_datagram_to(). If set, all older datagrams to the same peer,
+     * which are still waiting in the queue, are dropped. Useful for telemetry, where only
+     * the newest value matters.
+     */
+    #define TINY_FD_DATAGRAM_LATEST (0x01)
+
     enum
     {
         /**
@@ -78,6 +94,19 @@ extern "C"
         TINY_FD_MODE_ARM = 0x02,
     };
 
+#ifndef TINY_FD_IO_CHUNK_SIZE
+#if defined(__linux__) || defined(_WIN32) || defined(__APPLE__)
+/**
+ * Size of the stack buffer, used by tiny_fd_run_rx() and tiny_fd_run_tx() for single read/write call.
+ * Desktop platforms read large blocks to reduce number of system calls, while small
+ * controllers keep tiny buffer to save stack.
+ */
+#define TINY_FD_IO_CHUNK_SIZE 512
+#else
+#define TINY_FD_IO_CHUNK_SIZE 4
+#endif
+#endif
+
     struct tiny_fd_data_t;
 
     /**
@@ -174,8 +203,79 @@ extern "C"
          */
         uint8_t mode;
 
+        /**
+         * Number of logical channels multiplexed over the connection (up to TINY_FD_MAX_CHANNELS).
+         * If the value is 0, logical channels are disabled and I-frames carry user payload only.
+         * Otherwise each I-frame starts with 1-byte channel header, which is taken from mtu.
+         * Both stations must use the same value.
+         */
+        uint8_t channels;
+
+        /**
+         * Number of I-queue slots reserved for urgent frames, sent via tiny_fd_send_urgent_to().
+         * Regular frames never occupy reserved slots. Must be less than window_frames - 1.
+         * If the value is 0, urgent frames compete for free slots with regular frames.
+         */
+        uint8_t urgent_slots;
+
+        /**
+         * Callback to process incoming datagrams (UI-frames), sent by remote side via
+         * tiny_fd_send_datagram_to(). Callback is called from tiny_fd_run_rx() context.
+         * If NULL, incoming datagrams are dropped.
+         */
+        on_frame_read_cb_t on_datagram_cb;
+
+        /**
+         * Callback to get completion notification for frames, submitted via tiny_fd_submit_packet_to().
+         * The callback is called with TINY_SUCCESS, when the frame is confirmed by remote side,
+         * or with TINY_ERR_FAILED, when the frame is dropped due to disconnect. Can be NULL.
+         */
+        on_frame_complete_cb_t on_complete_cb;
+
+        /**
+         * Timeout for retry operation in microseconds. If not zero, it overrides retry_timeout
+         * and allows sub-millisecond retry timeouts on fast links.
+         */
+        uint32_t retry_timeout_us;
+
+        /**
+         * Keep alive timeout in microseconds. If zero, default value of 5 seconds is used.
+         * Can be changed later via tiny_fd_set_ka_timeout() or tiny_fd_set_ka_timeout_us().
+         */
+        uint32_t ka_timeout_us;
+
+        /**
+         * Maximum number of bytes, passed to read/write callbacks by tiny_fd_run_rx() and tiny_fd_run_tx()
+         * in one call. If zero or greater than TINY_FD_IO_CHUNK_SIZE, TINY_FD_IO_CHUNK_SIZE is used.
+         */
+        uint16_t io_chunk_size;
+
     } tiny_fd_init_t;
 
+    /**
+     * This structure describes logical channel parameters. Refer to tiny_fd_set_channel().
+     */
+    typedef struct tiny_fd_channel_init_t_
+    {
+        /**
+         * Channel priority. The frames of channels with higher priority are sent before
+         * queued frames of channels with lower priority.
+         */
+        uint8_t priority;
+
+        /**
+         * Maximum number of tx queue slots (window_frames), which can be occupied by the channel.
+         * If the value is 0, the channel can use all slots.
+         */
+        uint8_t quota;
+
+        /**
+         * Callback to process incoming frames of the channel. If NULL, the frames
+         * are passed to on_read_cb, specified in tiny_fd_init_t.
+         */
+        on_frame_read_cb_t on_read_cb;
+    } tiny_fd_channel_init_t;
+
     /**
      * @brief Initialized communication for Tiny Full Duplex protocol.
      *
@@ -201,6 +301,66 @@ extern "C"
      */
     extern int tiny_fd_get_status(tiny_fd_handle_t handle);
 
+    /**
+     * Counters of Tiny Full Duplex protocol. I-frame, REJ, keep alive and queue counters are kept
+     * for every peer, link counters are common for all peers. All counters wrap around on overflow.
+     */
+    typedef struct
+    {
+        /** Number of I-frames sent to the peer, including retransmitted ones */
+        uint32_t i_frames_sent;
+
+        /** Number of I-frames received from the peer, including out of order ones */
+        uint32_t i_frames_received;
+
+        /** Number of I-frames scheduled for retransmission due to REJ or retry timeout */
+        uint32_t retransmissions;
+
+        /** Number of REJ frames sent to the peer */
+        uint32_t rej_sent;
+
+        /** Number of REJ frames received from the peer */
+        uint32_t rej_received;
+
+        /** Number of disconnects due to missing keep alive frames from the peer */
+        uint32_t ka_timeouts;
+
+        /** Number of send requests to the peer, failed because there was no room in tx queue */
+        uint32_t queue_full;
+
+        /** Number of all frames sent by the link */
+        uint32_t link_frames_sent;
+
+        /** Number of all valid frames received by the link */
+        uint32_t link_frames_received;
+
+        /** Number of frames with wrong crc field, received by the link */
+        uint32_t crc_errors;
+
+        /** Number of framing errors on the link */
+        uint32_t framing_errors;
+
+        /** Number of received frames, which do not fit mtu */
+        uint32_t overflows;
+    } tiny_fd_stats_t;
+
+    /**
+     * @brief Returns protocol counters for specific peer
+     *
+     * The function copies per-peer counters together with common link counters.
+     * Counters are updated by the protocol always, and this doesn't require additional
+     * synchronization, so it is cheap to keep them in release builds.
+     *
+     * @param handle pointer to Tiny Full Duplex data
+     * @param address address of the peer. Use TINY_FD_PRIMARY_ADDR for secondary station
+     *        or for point-to-point connection.
+     * @param stats pointer to structure to copy counters to
+     * @return TINY_SUCCESS in case of success
+     *         TINY_ERR_INVALID_DATA if invalid arguments are passed
+     *         TINY_ERR_UNKNOWN_PEER if peer with the address is not registered
+     */
+    extern int tiny_fd_get_stats(tiny_fd_handle_t handle, uint8_t address, tiny_fd_stats_t *stats);
+
     /**
      * @brief Sends DISC command to remote side
      *
@@ -239,9 +399,10 @@ extern "C"
      * @brief sends tx data to the communication channel via user callback `write_func()`.
      *
      * Sends tx data to the communication channel via user callback `write_func()`.
-     * Internally this function generates next 4 bytes to send (or less if nothing to send),
+     * Internally this function generates next io_chunk_size bytes to send (or less if nothing to send),
      * and calls user callback write_func() until all generated bytes are sent, or error
-     * happens. This function helps to simplify application code.
+     * happens. Generation is repeated until there is no more data ready for sending.
+     * This function helps to simplify application code.
      *
      * @param handle handle of full-duplex protocol
      * @param write_func callback to the function to write data to the physical channel.
@@ -269,9 +430,10 @@ extern "C"
      * @brief reads rx data from the communication channel via user callback `read_func()`
      *
      * Reads rx data from the communication channel via user callback `read_func()`.
-     * Internally this function has 4-byte buffer, and tries to read 4 bytes from the channel.
+     * Internally this function tries to read io_chunk_size bytes from the channel.
      * Then received bytes are processed by the protocol. If FD protocol detects new incoming
-     * message then it calls on_send_callback.
+     * message then it calls on_send_callback. Reading is repeated, while read_func() fills
+     * the whole chunk, i.e. until the channel is drained.
      * If no data available in the channel, the function returns immediately after read_func() callback
      * returns control.
      *
@@ -335,7 +497,8 @@ extern "C"
     /**
      * @brief returns max packet size in bytes.
      *
-     * Returns max packet size in bytes.
+     * Returns max packet size in bytes. If logical channels are enabled, the value is
+     * 1 byte less than mtu, specified during initialization.
      *
      * @param handle   tiny_fd_handle_t handle
      * @return mtu size in bytes
@@ -371,6 +534,13 @@ extern "C"
      */
     extern void tiny_fd_set_ka_timeout(tiny_fd_handle_t handle, uint32_t keep_alive);
 
+    /**
+     * Sets keep alive timeout in microseconds. For details, please, refer to tiny_fd_set_ka_timeout().
+     * @param handle   pointer to tiny_fd_handle_t
+     * @param keep_alive_us timeout in microseconds
+     */
+    extern void tiny_fd_set_ka_timeout_us(tiny_fd_handle_t handle, uint32_t keep_alive_us);
+
     /**
      * Registers remote peer with specified address. This API can be used only in NRM mode
      * on primary station. The allowable range of the addresses is 1 - 62.
@@ -412,6 +582,142 @@ extern "C"
      */
     extern int tiny_fd_send_packet(tiny_fd_handle_t handle, const void *buf, int len, uint32_t timeout);
 
+    /**
+     * Configures logical channel. Logical channels must be enabled via channels field of tiny_fd_init_t.
+     * By default all channels have zero priority, no quota and use on_read_cb from tiny_fd_init_t.
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param channel  channel number in range 0 - (channels - 1)
+     * @param init     pointer to channel parameters
+     *
+     * @return TINY_SUCCESS in case of success or TINY_ERR_INVALID_DATA if channel number is invalid.
+     */
+    extern int tiny_fd_set_channel(tiny_fd_handle_t handle, uint8_t channel, const tiny_fd_channel_init_t *init);
+
+    /**
+     * Sends packet over specified logical channel. For details, please, refer to tiny_fd_send_packet_to().
+     * tiny_fd_send_packet_to() sends the data over channel 0.
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param address  address of remote peer. For primary device, please use TINY_FD_PRIMARY_ADDR
+     * @param channel  logical channel number
+     * @param buf      data to send
+     * @param len      length of data to send
+     * @param timeout  timeout in milliseconds to wait until data are placed to outgoing queue
+     *
+     * @return Success result or error code:
+     *         * TINY_SUCCESS          if user data are put to internal queue.
+     *         * TINY_ERR_TIMEOUT      if no room in internal queue or channel quota is exhausted.
+     *         * TINY_ERR_INVALID_DATA if channel number is invalid.
+     *         * TINY_ERR_UNKNOWN_PEER if peer is not known to the system.
+     *         * TINY_ERR_DATA_TOO_LARGE if user data are too big to fit in tx buffer.
+     */
+    extern int tiny_fd_send_channel_packet_to(tiny_fd_handle_t handle, uint8_t address, uint8_t channel,
+                                              const void *buf, int len, uint32_t timeout);
+
+    /**
+     * Sends urgent packet to remote peer. The packet is placed ahead of all I-frames, which
+     * were not transmitted yet, so it goes out right after the frame currently being sent.
+     * N(S) numbers of the frames being overtaken are updated, so the sequence remains valid.
+     * Urgent packets can use I-queue slots reserved via urgent_slots field of tiny_fd_init_t.
+     * If logical channels are enabled, the packet is delivered over channel 0.
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param address  address of remote peer. For primary device, please use TINY_FD_PRIMARY_ADDR
+     * @param buf      data to send
+     * @param len      length of data to send
+     * @param timeout  timeout in milliseconds to wait until data are placed to outgoing queue
+     *
+     * @return Success result or error code, the same as for tiny_fd_send_packet_to().
+     */
+    extern int tiny_fd_send_urgent_to(tiny_fd_handle_t handle, uint8_t address, const void *buf, int len,
+                                      uint32_t timeout);
+
+    /**
+     * Sends urgent packet to primary station. For details, please, refer to tiny_fd_send_urgent_to().
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param buf      data to send
+     * @param len      length of data to send
+     * @param timeout  timeout in milliseconds to wait until data are placed to outgoing queue
+     *
+     * @return Success result or error code
+     */
+    extern int tiny_fd_send_urgent(tiny_fd_handle_t handle, const void *buf, int len, uint32_t timeout);
+
+    /**
+     * Sends datagram to remote peer using UI-frame (unnumbered information). Datagrams do not
+     * use N(S) numbers, are never confirmed and never retransmitted, so they can be lost.
+     * Datagrams are sent before queued I-frames, but their relative order is not guaranteed.
+     * The function never blocks. Remote side receives datagrams via on_datagram_cb callback.
+     * Datagrams do not carry logical channel header, so the max size is the same as mtu
+     * field of tiny_fd_init_t.
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param address  address of remote peer. For primary device, please use TINY_FD_PRIMARY_ADDR
+     * @param buf      data to send
+     * @param len      length of data to send
+     * @param flags    0 or TINY_FD_DATAGRAM_LATEST
+     *
+     * @return Success result or error code:
+     *         * TINY_SUCCESS          if datagram is put to internal queue.
+     *         * TINY_ERR_BUSY         if there is no free slot in internal queue.
+     *         * TINY_ERR_UNKNOWN_PEER if peer is not known to the system.
+     *         * TINY_ERR_DATA_TOO_LARGE if user data are too big to fit in tx buffer.
+     */
+    extern int tiny_fd_send_datagram_to(tiny_fd_handle_t handle, uint8_t address, const void *buf, int len,
+                                        uint8_t flags);
+
+    /**
+     * Sends datagram to primary station. For details, please, refer to tiny_fd_send_datagram_to().
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param buf      data to send
+     * @param len      length of data to send
+     * @param flags    0 or TINY_FD_DATAGRAM_LATEST
+     *
+     * @return Success result or error code
+     */
+    extern int tiny_fd_send_datagram(tiny_fd_handle_t handle, const void *buf, int len, uint8_t flags);
+
+    /**
+     * Puts packet to outgoing queue without waiting. Unlike tiny_fd_send_packet_to() the function
+     * never blocks: if the packet cannot be queued right now, TINY_ERR_BUSY is returned.
+     * The returned ticket is passed to on_complete_cb callback, when the packet is confirmed
+     * by remote side or dropped.
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param address  address of remote peer. For primary device, please use TINY_FD_PRIMARY_ADDR
+     * @param buf      data to send
+     * @param len      length of data to send
+     *
+     * @return positive ticket number or error code:
+     *         * TINY_ERR_BUSY         if connection is not established or there is no room in internal queue.
+     *         * TINY_ERR_UNKNOWN_PEER if peer is not known to the system.
+     *         * TINY_ERR_DATA_TOO_LARGE if user data are too big to fit in tx buffer.
+     */
+    extern int tiny_fd_submit_packet_to(tiny_fd_handle_t handle, uint8_t address, const void *buf, int len);
+
+    /**
+     * Puts several packets to outgoing queue at once. The function waits until at least one packet
+     * can be queued, and then puts as many packets as fit, under single lock. Each message is sent
+     * as separate I-frame, the same way as tiny_fd_send_packet_to() does.
+     * Messages are queued in order. Queuing stops at the first message, which is greater than MTU,
+     * so the returned number is the index of that message: check msgs[result].len to detect it.
+     *
+     * @param handle   tiny_fd_handle_t handle
+     * @param address  address of remote peer. For primary device, please use TINY_FD_PRIMARY_ADDR
+     * @param msgs     array of messages to send
+     * @param count    number of messages in the array
+     * @param timeout  timeout in milliseconds to wait until the first message can be placed to outgoing queue
+     *
+     * @return number of messages accepted (0 on timeout) or error code:
+     *         * TINY_ERR_UNKNOWN_PEER if peer is not known to the system.
+     *         * TINY_ERR_DATA_TOO_LARGE if the first message is too big to fit in tx buffer.
+     */
+    extern int tiny_fd_send_batch(tiny_fd_handle_t handle, uint8_t address, const tiny_iovec_t *msgs, int count,
+                                  uint32_t timeout);
+
     /**
      * @}
      */
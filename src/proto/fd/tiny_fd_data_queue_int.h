@@ -33,6 +33,8 @@
 #include "tiny_fd_defines_int.h"
 #include "tiny_fd_peers_int.h"
 
+#include <string.h>
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static inline bool __has_unconfirmed_frames(tiny_fd_handle_t handle, uint8_t peer)
@@ -49,27 +51,212 @@ static inline bool __all_frames_are_sent(tiny_fd_handle_t handle, uint8_t peer)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static inline uint32_t __time_passed_since_last_i_frame(tiny_fd_handle_t handle, uint8_t peer)
+static inline uint64_t __time_passed_since_last_i_frame(tiny_fd_handle_t handle, uint8_t peer)
 {
-    return (uint32_t)(tiny_millis() - handle->peers[peer].last_i_ts);
+    return tiny_micros64() - handle->peers[peer].last_i_ts;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static bool __put_i_frame_to_tx_queue(tiny_fd_handle_t handle, uint8_t peer, const void *data, int len)
+static inline uint8_t __channel_header_size(tiny_fd_handle_t handle)
 {
-    tiny_fd_frame_info_t *slot = tiny_fd_queue_allocate( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, (const uint8_t *)data, len );
+    return handle->channels_count ? 1 : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static tiny_fd_frame_info_t *__put_i_frame_to_tx_queue(tiny_fd_handle_t handle, uint8_t peer, uint8_t channel,
+                                                       bool urgent, const void *data, int len)
+{
+    const uint8_t header_size = __channel_header_size( handle );
+    tiny_fd_frame_info_t *slot = tiny_fd_queue_allocate( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, NULL, len + header_size );
     // Check if space is actually available
     if ( slot != NULL )
     {
         LOG(TINY_LOG_DEB, "[%p] QUEUE I-PUT: [%02X] [%02X]\n", handle, slot->header.address, slot->header.control);
+        if ( header_size )
+        {
+            slot->payload[0] = channel;
+        }
+        memcpy( &slot->payload[header_size], data, len );
+        slot->channel = channel;
+        slot->urgent = urgent;
+        slot->ticket = 0;
+        if ( urgent )
+        {
+            handle->peers[peer].urgent_count++;
+        }
         slot->header.address = __peer_to_address_field( handle, peer );
         slot->header.control = handle->peers[peer].last_ns << 1;
         handle->peers[peer].last_ns = (handle->peers[peer].last_ns + 1) & seq_bits_mask;
-        tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
-        return true;
+        // FD_EVENT_TX_DATA_AVAILABLE is set by the caller, so the batch of frames signals only once
+    }
+    return slot;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static uint16_t __assign_ticket(tiny_fd_handle_t handle, tiny_fd_frame_info_t *slot)
+{
+    // Tickets are positive int values on all platforms, 0 means no ticket
+    handle->last_ticket = (handle->last_ticket + 1) & 0x7FFF;
+    if ( !handle->last_ticket )
+    {
+        handle->last_ticket = 1;
+    }
+    slot->ticket = handle->last_ticket;
+    return slot->ticket;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static int __collect_tickets(tiny_fd_handle_t handle, uint8_t peer, uint16_t *tickets)
+{
+    // There can be no more than seq_bits_mask unconfirmed frames per peer
+    int count = 0;
+    const uint8_t address = __peer_to_address_field( handle, peer );
+    for ( uint8_t ns = handle->peers[peer].confirm_ns; ns != handle->peers[peer].last_ns; ns = (ns + 1) & seq_bits_mask )
+    {
+        tiny_fd_frame_info_t *slot = tiny_fd_queue_get_next( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, address, ns );
+        if ( slot != NULL && slot->ticket )
+        {
+            tickets[count++] = slot->ticket;
+        }
+    }
+    return count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static int __put_datagram_to_tx_queue(tiny_fd_handle_t handle, uint8_t peer, const void *data, int len, uint8_t flags)
+{
+    const uint8_t address = __peer_to_address_field( handle, peer ) | HDLC_CR_BIT;
+    if ( flags & TINY_FD_DATAGRAM_LATEST )
+    {
+        // Datagram, which is being sent right now, cannot be dropped
+        int dropped = tiny_fd_queue_free_for( &handle->frames.i_queue, TINY_FD_QUEUE_U_FRAME, address, handle->tx_datagram );
+        if ( dropped )
+        {
+            LOG(TINY_LOG_INFO, "[%p] %d outdated datagrams dropped\n", handle, dropped);
+            // Released slots can be used by senders, waiting for free slots
+            tiny_events_set(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS);
+            tiny_events_set(&handle->events, FD_EVENT_CHANNEL_HAS_FREE_SLOTS);
+        }
+    }
+    // Datagrams cannot use slots reserved for urgent frames
+    if ( tiny_fd_queue_get_free_count( &handle->frames.i_queue ) <= handle->urgent_slots )
+    {
+        return TINY_ERR_BUSY;
+    }
+    tiny_fd_frame_info_t *slot = tiny_fd_queue_allocate( &handle->frames.i_queue, TINY_FD_QUEUE_U_FRAME, (const uint8_t *)data, len );
+    if ( slot == NULL )
+    {
+        return TINY_ERR_BUSY;
+    }
+    slot->header.address = address;
+    slot->header.control = HDLC_U_FRAME_TYPE_UI | HDLC_U_FRAME_BITS;
+    LOG(TINY_LOG_DEB, "[%p] QUEUE UI-PUT: [%02X] [%02X]\n", handle, slot->header.address, slot->header.control);
+    if ( !tiny_fd_queue_has_free_slots( &handle->frames.i_queue ) )
+    {
+        tiny_events_clear(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS);
+    }
+    tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
+    return TINY_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static uint8_t *tiny_fd_get_next_datagram(tiny_fd_handle_t handle, int *len, uint8_t address)
+{
+    tiny_fd_frame_info_t *ptr = tiny_fd_queue_get_next( &handle->frames.i_queue, TINY_FD_QUEUE_U_FRAME, address, 0 );
+    if ( ptr == NULL )
+    {
+        return NULL;
+    }
+    LOG(TINY_LOG_INFO, "[%p] Sending UI-Frame with address [%02X]\n", handle, ptr->header.address);
+    handle->tx_datagram = ptr;
+    *len = ptr->len + sizeof(tiny_frame_header_t);
+    return (uint8_t *)&ptr->header;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static bool __channel_has_free_slots(tiny_fd_handle_t handle, uint8_t channel)
+{
+    // Regular frames cannot occupy slots reserved for urgent frames. Also slots can be taken by datagrams
+    if ( tiny_fd_queue_get_free_count( &handle->frames.i_queue ) <= handle->urgent_slots )
+    {
+        return false;
+    }
+    const uint8_t quota = handle->channels[channel].quota;
+    return !quota || tiny_fd_queue_get_channel_count( &handle->frames.i_queue, channel ) < quota;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void __set_i_frame_ns(tiny_fd_frame_info_t *frame, uint8_t ns)
+{
+    frame->header.control = (frame->header.control & ~(seq_bits_mask << 1)) | (ns << 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static uint16_t __get_i_frame_priority(tiny_fd_handle_t handle, tiny_fd_frame_info_t *frame)
+{
+    // Urgent frames go ahead of any channel priority
+    if ( frame->urgent )
+    {
+        return 0x100;
+    }
+    return handle->channels_count ? handle->channels[frame->channel].priority : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void __schedule_fresh_i_frames(tiny_fd_handle_t handle, uint8_t peer, uint8_t address)
+{
+    tiny_fd_peer_info_t *info = &handle->peers[peer];
+    // Frames can be reordered only if they were never sent to remote side, otherwise N(S) is already known
+    if ( ( !handle->channels_count && !info->urgent_count ) || info->next_ns != info->fresh_ns )
+    {
+        return;
+    }
+    tiny_fd_frame_info_t *best = NULL;
+    uint16_t best_priority = 0;
+    uint8_t best_ns = info->next_ns;
+    for ( uint8_t ns = info->next_ns; ns != info->last_ns; ns = (ns + 1) & seq_bits_mask )
+    {
+        tiny_fd_frame_info_t *frame = tiny_fd_queue_get_next( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, address, ns );
+        if ( frame == NULL )
+        {
+            continue;
+        }
+        uint16_t priority = __get_i_frame_priority( handle, frame );
+        // Strict comparison keeps the order of frames with the same priority
+        if ( best == NULL || priority > best_priority )
+        {
+            best = frame;
+            best_priority = priority;
+            best_ns = ns;
+        }
+    }
+    if ( best == NULL || best_ns == info->next_ns )
+    {
+        return;
+    }
+    LOG(TINY_LOG_INFO, "[%p] Moving I-Frame N(S)=%02X of channel %d ahead of N(S)=%02X\n", handle, best_ns,
+        best->channel, info->next_ns);
+    // Shift all frames, preceding the selected one, by one position to keep their order
+    for ( uint8_t ns = best_ns; ns != info->next_ns; ns = (ns - 1) & seq_bits_mask )
+    {
+        tiny_fd_frame_info_t *frame =
+            tiny_fd_queue_get_next( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, address, (ns - 1) & seq_bits_mask );
+        if ( frame != NULL )
+        {
+            __set_i_frame_ns( frame, ns );
+        }
     }
-    return false;
+    __set_i_frame_ns( best, info->next_ns );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
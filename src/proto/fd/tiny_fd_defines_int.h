@@ -47,6 +47,7 @@ enum
     FD_EVENT_QUEUE_HAS_FREE_SLOTS = 0x04,  // Global event
     FD_EVENT_CAN_ACCEPT_I_FRAMES = 0x08,   // Local event
     FD_EVENT_HAS_MARKER          = 0x10,   // Global event
+    FD_EVENT_CHANNEL_HAS_FREE_SLOTS = 0x20, // Global event
 };
 
 #define HDLC_I_FRAME_BITS 0x00
@@ -67,6 +68,7 @@ enum
 #define HDLC_U_FRAME_TYPE_SABM 0x2C
 #define HDLC_U_FRAME_TYPE_SNRM 0x80
 #define HDLC_U_FRAME_TYPE_DISC 0x40
+#define HDLC_U_FRAME_TYPE_UI 0x00
 #define HDLC_U_FRAME_TYPE_MASK 0xEC
 
 #define HDLC_P_BIT 0x10
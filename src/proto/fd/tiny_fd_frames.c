@@ -93,7 +93,10 @@ tiny_fd_frame_info_t *tiny_fd_queue_allocate(tiny_fd_queue_t *queue, uint8_t typ
     tiny_fd_frame_info_t *ptr = len <= queue->mtu ?  tiny_fd_queue_get_next(queue, TINY_FD_QUEUE_FREE, 0, 0) : NULL;
     if ( ptr != NULL )
     {
-        memcpy( &ptr->payload[0], data, len );
+        if ( data != NULL )
+        {
+            memcpy( &ptr->payload[0], data, len );
+        }
         ptr->len = len;
         ptr->type = type;
     }
@@ -162,11 +165,52 @@ void tiny_fd_queue_free_by_header(tiny_fd_queue_t *queue, const void *header)
     }
 }
 
+int tiny_fd_queue_free_for(tiny_fd_queue_t *queue, uint8_t type, uint8_t address, const tiny_fd_frame_info_t *keep)
+{
+    int count = 0;
+    for (int i=0; i < queue->size; i++)
+    {
+        if ( queue->frames[i]->type == type && queue->frames[i] != keep &&
+             ( queue->frames[i]->header.address & 0xFC ) == (address & 0xFC) )
+        {
+            queue->frames[i]->type = TINY_FD_QUEUE_FREE;
+            count++;
+        }
+    }
+    return count;
+}
+
 int tiny_fd_queue_get_mtu(tiny_fd_queue_t *queue)
 {
     return queue->mtu;
 }
 
+int tiny_fd_queue_get_free_count(tiny_fd_queue_t *queue)
+{
+    int count = 0;
+    for (int i=0; i < queue->size; i++)
+    {
+        if ( queue->frames[i]->type == TINY_FD_QUEUE_FREE )
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+int tiny_fd_queue_get_channel_count(tiny_fd_queue_t *queue, uint8_t channel)
+{
+    int count = 0;
+    for (int i=0; i < queue->size; i++)
+    {
+        if ( queue->frames[i]->type == TINY_FD_QUEUE_I_FRAME && queue->frames[i]->channel == channel )
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
 bool tiny_fd_queue_has_free_slots(tiny_fd_queue_t *queue)
 {
     return tiny_fd_queue_get_next(queue, TINY_FD_QUEUE_FREE, 0, 0) != NULL;
@@ -55,8 +55,11 @@ extern "C"
 
     typedef struct
     {
-        uint8_t type; ///< tiny_fd_queue_type_t value
-        int len;      ///< payload of the frame
+        uint8_t type;    ///< tiny_fd_queue_type_t value
+        uint8_t channel; ///< logical channel of I-frame
+        uint8_t urgent;  ///< non-zero if I-frame must overtake all frames, which were not sent yet
+        uint16_t ticket; ///< ticket of asynchronously submitted I-frame or 0
+        int len;         ///< payload of the frame
         /* Aligning header to 1 byte, since header and user_payload together are the byte-stream */
         TINY_ALIGNED(1) tiny_frame_header_t header; ///< header, fill every time, when user payload is sending
         uint8_t payload[2];       ///< this byte and all bytes after are user payload
@@ -99,6 +102,16 @@ extern "C"
      */
     bool tiny_fd_queue_has_free_slots(tiny_fd_queue_t *queue);
 
+    /**
+     * Returns number of free slots in the queue
+     */
+    int tiny_fd_queue_get_free_count(tiny_fd_queue_t *queue);
+
+    /**
+     * Returns number of I-frames of specified logical channel, stored in the queue
+     */
+    int tiny_fd_queue_get_channel_count(tiny_fd_queue_t *queue, uint8_t channel);
+
     /**
      * Returns max payload size, supported for the queued frames
      */
@@ -107,6 +120,7 @@ extern "C"
     /**
      * Allocates free slot in the queue and copies user data to the queue.
      * If there are no space returns NULL, otherwise returns pointer to allocated frame info structure.
+     * If data is NULL, the payload is not initialized, and must be filled by the caller.
      */
     tiny_fd_frame_info_t *tiny_fd_queue_allocate(tiny_fd_queue_t *queue, uint8_t type, const uint8_t *data, int len);
 
@@ -121,6 +135,17 @@ extern "C"
      */
     tiny_fd_frame_info_t *tiny_fd_queue_get_next(tiny_fd_queue_t *queue, uint8_t type, uint8_t address, uint8_t arg);
 
+    /**
+     * Marks all frames of specified type and address as free except the specified one.
+     * Returns number of freed slots.
+     *
+     * @param queue pointer to queue structure
+     * @param type type of the records to free: tiny_fd_queue_type_t
+     * @param address address field of the records to free
+     * @param keep pointer to the frame, which must not be freed, or NULL
+     */
+    int tiny_fd_queue_free_for(tiny_fd_queue_t *queue, uint8_t type, uint8_t address, const tiny_fd_frame_info_t *keep);
+
     /**
      * Marks frame slot as free
      *
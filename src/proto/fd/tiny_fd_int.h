@@ -42,6 +42,7 @@ extern "C"
 #include "proto/hdlc/low_level/hdlc_int.h"
 #include "hal/tiny_types.h"
 #include "tiny_fd_frames_int.h"
+#include "tiny_fd.h"
 
 #define FD_PEER_BUF_SIZE() ( sizeof(tiny_fd_peer_info_t) )
 
@@ -57,7 +58,7 @@ extern "C"
     (sizeof(tiny_fd_data_t) + TINY_ALIGN_STRUCT_VALUE - 1 + \
      HDLC_BUF_SIZE_EX(mtu + sizeof(tiny_frame_header_t), crc, rx_window) +           \
       ( 1 * FD_PEER_BUF_SIZE() ) + \
-      (sizeof(tiny_fd_frame_info_t *) + sizeof(tiny_i_frame_info_t) + mtu \
+      (sizeof(tiny_fd_frame_info_t *) + sizeof(tiny_fd_frame_info_t) + mtu \
                                       - sizeof(((tiny_fd_frame_info_t *)0)->payload)) * tx_window + \
        ( sizeof(tiny_fd_frame_info_t) + sizeof(tiny_fd_frame_info_t *) ) * TINY_FD_U_QUEUE_MAX_SIZE)
 
@@ -88,16 +89,26 @@ extern "C"
         uint8_t next_ns;     // next frame to be sent
         uint8_t confirm_ns;  // next frame to be confirmed
         uint8_t last_ns;     // next free frame in cycle buffer
+        uint8_t fresh_ns;    // first frame, which was never sent
+        uint8_t urgent_count; // number of urgent frames, which were never sent
 
-        uint32_t last_i_ts;  // last sent I-frame timestamp
-        uint32_t last_ka_ts; // last keep alive timestamp
+        uint64_t last_i_ts;  // last sent I-frame timestamp in microseconds
+        uint64_t last_ka_ts; // last keep alive timestamp in microseconds
         uint8_t ka_confirmed;
         uint8_t retries;     // Number of retries to perform before timeout takes place
 
         tiny_events_t events;
+        tiny_fd_stats_t stats; // Peer counters, protected by frames.mutex, link counters are not used
 
     } tiny_fd_peer_info_t;
 
+    typedef struct
+    {
+        uint8_t priority;              // Channel priority, higher values are sent first
+        uint8_t quota;                 // Max number of I-queue slots, 0 - no limit
+        on_frame_read_cb_t on_read_cb; // Channel specific callback or NULL
+    } tiny_fd_channel_info_t;
+
     typedef struct
     {
         /// Storage for all I- frames
@@ -117,14 +128,20 @@ extern "C"
         on_frame_send_cb_t on_send_cb;
         /// Callback to get connect/disconnect notification
         on_connect_event_cb_t on_connect_event_cb;
+        /// Callback to process received datagrams
+        on_frame_read_cb_t on_datagram_cb;
+        /// Callback to get completion of asynchronously submitted frames
+        on_frame_complete_cb_t on_complete_cb;
         /// hdlc information
         hdlc_ll_handle_t _hdlc;
         /// Timeout for operations with acknowledge
         uint16_t send_timeout;
-        /// Timeout before retrying resend I-frames
-        uint16_t retry_timeout;
-        /// Timeout before sending keep alive HDLC frame (RR)
-        uint16_t ka_timeout;
+        /// Timeout before retrying resend I-frames in microseconds
+        uint32_t retry_timeout_us;
+        /// Timeout before sending keep alive HDLC frame (RR) in microseconds
+        uint32_t ka_timeout_us;
+        /// Number of bytes to read/write by single callback call
+        uint16_t io_chunk;
         /// Number of retries to perform before timeout takes place
         uint8_t retries;
         /// Information for frames being processed
@@ -137,10 +154,20 @@ extern "C"
         uint8_t addr;
         /// Next peer to process
         uint8_t next_peer;
-        /// Last marker timestamp
-        uint32_t last_marker_ts;
+        /// Last marker timestamp in microseconds
+        uint64_t last_marker_ts;
         /// HDLC mode;
         uint8_t mode;
+        /// Number of logical channels, 0 if channel header is not used
+        uint8_t channels_count;
+        /// Logical channels information
+        tiny_fd_channel_info_t channels[TINY_FD_MAX_CHANNELS];
+        /// Number of I-queue slots reserved for urgent frames
+        uint8_t urgent_slots;
+        /// Datagram passed to hdlc low level, but not sent yet
+        tiny_fd_frame_info_t *tx_datagram;
+        /// Last ticket assigned to asynchronously submitted frame
+        uint16_t last_ticket;
         /// Global events for HDLC protocol
         tiny_events_t events;
         /// user specific data
@@ -61,12 +61,14 @@ static void __confirm_sent_frames(tiny_fd_handle_t handle, uint8_t peer, uint8_t
         tiny_fd_frame_info_t *slot = tiny_fd_queue_get_next( &handle->frames.i_queue, TINY_FD_QUEUE_I_FRAME, address, handle->peers[peer].confirm_ns );
         if ( slot != NULL )
         {
+            const uint16_t ticket = slot->ticket;
             if ( handle->on_send_cb )
             {
+                const uint8_t header_size = __channel_header_size( handle );
                 tiny_mutex_unlock(&handle->frames.mutex);
                 handle->on_send_cb(handle->user_data,
                                    __is_primary_station( handle ) ? (__peer_to_address_field( handle, peer ) >> 2) : TINY_FD_PRIMARY_ADDR,
-                                   &slot->payload[0], slot->len);
+                                   &slot->payload[header_size], slot->len - header_size);
                 tiny_mutex_lock(&handle->frames.mutex);
             }
             tiny_fd_queue_free( &handle->frames.i_queue, slot );
@@ -75,6 +77,16 @@ static void __confirm_sent_frames(tiny_fd_handle_t handle, uint8_t peer, uint8_t
                 // Unblock tx queue to allow application to put new frames for sending
                 tiny_events_set(&handle->events, FD_EVENT_QUEUE_HAS_FREE_SLOTS);
             }
+            // Channel quota might be released
+            tiny_events_set(&handle->events, FD_EVENT_CHANNEL_HAS_FREE_SLOTS);
+            if ( ticket && handle->on_complete_cb )
+            {
+                tiny_mutex_unlock(&handle->frames.mutex);
+                handle->on_complete_cb(handle->user_data,
+                                       __is_primary_station( handle ) ? (__peer_to_address_field( handle, peer ) >> 2) : TINY_FD_PRIMARY_ADDR,
+                                       ticket, TINY_SUCCESS);
+                tiny_mutex_lock(&handle->frames.mutex);
+            }
         }
         else
         {
@@ -123,6 +135,7 @@ static int __check_received_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t
                 .control = HDLC_S_FRAME_BITS | HDLC_S_FRAME_TYPE_REJ | (handle->peers[peer].next_nr << 5),
             };
             handle->peers[peer].sent_reject = 1;
+            handle->peers[peer].stats.rej_sent++;
             __put_u_s_frame_to_tx_queue(handle, TINY_FD_QUEUE_S_FRAME, &frame, sizeof(tiny_frame_header_t));
         }
         result = TINY_ERR_FAILED;
@@ -134,6 +147,7 @@ static int __check_received_frame(tiny_fd_handle_t handle, uint8_t peer, uint8_t
 
 static void __resend_all_unconfirmed_frames(tiny_fd_handle_t handle, uint8_t peer, uint8_t control, uint8_t nr)
 {
+    const uint8_t next_ns = handle->peers[peer].next_ns;
     // First, we need to check if that is possible. Maybe remote side is not in sync
     while ( handle->peers[peer].next_ns != nr )
     {
@@ -154,29 +168,54 @@ static void __resend_all_unconfirmed_frames(tiny_fd_handle_t handle, uint8_t pee
         handle->peers[peer].next_ns = (handle->peers[peer].next_ns - 1) & seq_bits_mask;
     }
     LOG(TINY_LOG_DEB, "[%p] N(s) is set to %02X\n", handle, handle->peers[peer].next_ns);
+    handle->peers[peer].stats.retransmissions += (next_ns - handle->peers[peer].next_ns) & seq_bits_mask;
     tiny_events_set(&handle->events, FD_EVENT_TX_DATA_AVAILABLE);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static on_frame_read_cb_t __get_channel_read_cb(tiny_fd_handle_t handle, uint8_t **payload, int *len)
+{
+    if ( !handle->channels_count )
+    {
+        return handle->on_read_cb;
+    }
+    // Strip channel header from user payload
+    if ( *len < 1 || (*payload)[0] >= handle->channels_count )
+    {
+        LOG(TINY_LOG_WRN, "[%p] I-Frame for unknown channel is dropped\n", handle);
+        return NULL;
+    }
+    uint8_t channel = (*payload)[0];
+    (*payload)++;
+    (*len)--;
+    return handle->channels[channel].on_read_cb ? handle->channels[channel].on_read_cb : handle->on_read_cb;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 static int __on_i_frame_read(tiny_fd_handle_t handle, uint8_t peer, void *data, int len)
 {
     uint8_t control = ((uint8_t *)data)[1];
     uint8_t nr = control >> 5;
     uint8_t ns = (control >> 1) & 0x07;
     LOG(TINY_LOG_INFO, "[%p] Receiving I-Frame N(R)=%02X,N(S)=%02X with address [%02X]\n", handle, nr, ns, ((uint8_t *)data)[0]);
+    handle->peers[peer].stats.i_frames_received++;
     int result = __check_received_frame(handle, peer, ns);
     // Confirm all previously sent frames up to received N(R)
     __confirm_sent_frames(handle, peer, nr);
     // Provide data to user only if we expect this frame
     if ( result == TINY_SUCCESS )
     {
-        if ( handle->on_read_cb )
+        uint8_t *payload = (uint8_t *)data + 2;
+        int payload_len = len - 2;
+        on_frame_read_cb_t on_read_cb = __get_channel_read_cb(handle, &payload, &payload_len);
+        if ( on_read_cb )
         {
             tiny_mutex_unlock(&handle->frames.mutex);
-            handle->on_read_cb(handle->user_data,
-                               __is_primary_station( handle ) ? (__peer_to_address_field( handle, peer ) >> 2) : TINY_FD_PRIMARY_ADDR,
-                               (uint8_t *)data + 2, len - 2);
+            on_read_cb(handle->user_data,
+                       __is_primary_station( handle ) ? (__peer_to_address_field( handle, peer ) >> 2) : TINY_FD_PRIMARY_ADDR,
+                       payload, payload_len);
             tiny_mutex_lock(&handle->frames.mutex);
         }
         // Decide whenever we need to send RR after user callback
@@ -208,6 +247,7 @@ static int __on_s_frame_read(tiny_fd_handle_t handle, uint8_t peer, void *data,
     {
         // Confirm all previously sent frames up to received N(R)
         __confirm_sent_frames(handle, peer, nr);
+        handle->peers[peer].stats.rej_received++;
         __resend_all_unconfirmed_frames(handle, peer, control, nr);
     }
     else if ( (control & HDLC_S_FRAME_TYPE_MASK) == HDLC_S_FRAME_TYPE_RR )
@@ -270,6 +310,18 @@ static int __on_u_frame_read(tiny_fd_handle_t handle, uint8_t peer, void *data,
         // response of secondary in case of protocol errors: invalid control field, invalid N(R),
         // information field too long or not expected in this frame
     }
+    else if ( type == HDLC_U_FRAME_TYPE_UI )
+    {
+        if ( handle->on_datagram_cb )
+        {
+            tiny_mutex_unlock(&handle->frames.mutex);
+            handle->on_datagram_cb(handle->user_data,
+                                   __is_primary_station( handle ) ? (__peer_to_address_field( handle, peer ) >> 2) : TINY_FD_PRIMARY_ADDR,
+                                   (uint8_t *)data + 2, len - 2);
+            tiny_mutex_lock(&handle->frames.mutex);
+        }
+        result = TINY_SUCCESS;
+    }
     else if ( type == HDLC_U_FRAME_TYPE_UA )
     {
         if ( handle->peers[peer].state == TINY_FD_STATE_CONNECTING )
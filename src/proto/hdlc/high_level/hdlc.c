@@ -32,6 +32,7 @@
 #include "hal/tiny_debug.h"
 
 #include <stddef.h>
+#include <string.h>
 
 #ifndef TINY_HDLC_DEBUG
 #define TINY_HDLC_DEBUG 0
@@ -58,6 +59,7 @@ enum
 
 static void on_frame_read(void *user_data, uint8_t *data, int len);
 static void on_frame_send(void *user_data, const uint8_t *data, int len);
+static void hdlc_flush_tx_queue(hdlc_handle_t handle);
 
 ////////////////////////////////////////////////////////////////////////////////////////
 
@@ -76,6 +78,19 @@ hdlc_handle_t hdlc_init(hdlc_struct_t *hdlc_info)
         return NULL;
     }
 
+    if ( !hdlc_info->tx_queue || hdlc_info->tx_queue_size <= 0 )
+    {
+        hdlc_info->tx_queue = &hdlc_info->tx_slot;
+        hdlc_info->tx_queue_size = 1;
+    }
+    if ( !hdlc_info->tx_buf || hdlc_info->tx_buf_size <= 0 )
+    {
+        hdlc_info->tx_buf = hdlc_info->tx_stream;
+        hdlc_info->tx_buf_size = sizeof(hdlc_info->tx_stream);
+    }
+    hdlc_info->tx_put_seq = 0;
+    hdlc_info->tx_done_seq = 0;
+    tiny_mutex_create(&hdlc_info->tx_mutex);
     tiny_events_create(&hdlc_info->events);
     tiny_events_set(&hdlc_info->events, TX_ACCEPT_BIT);
     // Must be last
@@ -89,6 +104,7 @@ int hdlc_close(hdlc_handle_t handle)
 {
     hdlc_ll_close(handle->handle);
     tiny_events_destroy(&handle->events);
+    tiny_mutex_destroy(&handle->tx_mutex);
     return 0;
 }
 
@@ -96,9 +112,26 @@ int hdlc_close(hdlc_handle_t handle)
 
 void hdlc_reset(hdlc_handle_t handle)
 {
-    hdlc_ll_reset(handle->handle, HDLC_LL_RESET_BOTH);
+    hdlc_ll_reset(handle->handle, HDLC_LL_RESET_RX_ONLY);
     tiny_events_clear(&handle->events, EVENT_BITS_ALL);
+    hdlc_flush_tx_queue(handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+
+static void hdlc_flush_tx_queue(hdlc_handle_t handle)
+{
+    tiny_mutex_lock(&handle->tx_mutex);
+    hdlc_ll_reset(handle->handle, HDLC_LL_RESET_TX_ONLY);
+    // Dropped frames are considered as completed, so nobody waits for them
+    handle->tx_done_seq = handle->tx_put_seq;
+    handle->tx_head = 0;
+    handle->tx_count = 0;
+    handle->tx_pos = 0;
+    handle->tx_len = 0;
+    tiny_events_clear(&handle->events, TX_DATA_READY_BIT);
     tiny_events_set(&handle->events, TX_ACCEPT_BIT);
+    tiny_mutex_unlock(&handle->tx_mutex);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
@@ -106,20 +139,45 @@ void hdlc_reset(hdlc_handle_t handle)
 static void on_frame_send(void *user_data, const uint8_t *data, int len)
 {
     hdlc_handle_t handle = (hdlc_handle_t)user_data;
+    // Callbacks are called in the order of frames, since only the head of the queue is being sent
     if ( handle->on_frame_send )
     {
         handle->on_frame_send(handle->user_data, data, len);
     }
+    tiny_mutex_lock(&handle->tx_mutex);
+    if ( handle->tx_count )
+    {
+        handle->tx_head = (handle->tx_head + 1) % handle->tx_queue_size;
+        handle->tx_count--;
+        handle->tx_done_seq++;
+    }
+    if ( handle->tx_count )
+    {
+        // Pass next frame to the encoder right away, so frames go back-to-back
+        const tiny_iovec_t *next = &handle->tx_queue[handle->tx_head];
+        hdlc_ll_put(handle->handle, next->data, next->len);
+    }
+    else
+    {
+        tiny_events_clear(&handle->events, TX_DATA_READY_BIT);
+    }
     tiny_events_set(&handle->events, TX_DATA_SENT_BIT);
     tiny_events_set(&handle->events, TX_ACCEPT_BIT);
+    tiny_mutex_unlock(&handle->tx_mutex);
 }
 
 static void hdlc_send_terminate(hdlc_handle_t handle)
 {
     LOG(TINY_LOG_INFO, "[HDLC:%p] hdlc_send_terminate HDLC send failed on timeout\n", handle);
-    tiny_events_clear(&handle->events, TX_DATA_READY_BIT);
-    hdlc_ll_reset(handle->handle, HDLC_LL_RESET_TX_ONLY);
-    tiny_events_set(&handle->events, TX_ACCEPT_BIT);
+    hdlc_flush_tx_queue(handle);
+}
+
+static bool hdlc_is_sent(hdlc_handle_t handle, uint16_t seq)
+{
+    tiny_mutex_lock(&handle->tx_mutex);
+    bool sent = (int16_t)(handle->tx_done_seq - seq) >= 0;
+    tiny_mutex_unlock(&handle->tx_mutex);
+    return sent;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
@@ -127,31 +185,33 @@ static void hdlc_send_terminate(hdlc_handle_t handle)
 int hdlc_run_tx(hdlc_handle_t handle)
 {
     LOG(TINY_LOG_DEB, "[HDLC:%p] hdlc_run_tx ENTER\n", handle);
+    uint8_t *buf = (uint8_t *)handle->tx_buf;
     int result = 0;
     for ( ;; )
     {
-        uint8_t buf[1];
-        int temp_result = hdlc_ll_run_tx(handle->handle, buf, sizeof(buf));
-        while ( temp_result > 0 )
+        if ( handle->tx_pos == handle->tx_len )
         {
-            int temp = handle->send_tx(handle->user_data, buf, temp_result);
-            if ( temp < 0 )
+            handle->tx_pos = 0;
+            handle->tx_len = hdlc_ll_run_tx(handle->handle, buf, handle->tx_buf_size);
+            if ( handle->tx_len == 0 )
             {
-                temp_result = temp;
                 break;
             }
-            temp_result -= temp;
-            result += temp;
         }
-        if ( temp_result <= 0 )
+        int temp = handle->send_tx(handle->user_data, &buf[handle->tx_pos], handle->tx_len - handle->tx_pos);
+        if ( temp < 0 )
         {
-#if TINY_HDLC_DEBUG
-            if ( temp_result < 0 )
-                LOG(TINY_LOG_ERR, "[HDLC:%p] failed to run state with result: %d\n", handle, temp_result);
-#endif
-            result = result ? result : temp_result;
+            LOG(TINY_LOG_ERR, "[HDLC:%p] failed to send data with result: %d\n", handle, temp);
+            result = result ? result : temp;
             break;
         }
+        if ( temp == 0 )
+        {
+            // Hw is busy, not accepted bytes are sent by next call
+            break;
+        }
+        handle->tx_pos += temp;
+        result += temp;
     }
     LOG(TINY_LOG_DEB, "[HDLC:%p] hdlc_run_tx EXIT\n", handle);
     return result;
@@ -161,39 +221,34 @@ int hdlc_run_tx(hdlc_handle_t handle)
 
 int hdlc_get_tx_data(hdlc_handle_t handle, void *data, int len)
 {
-    return hdlc_ll_run_tx(handle->handle, data, len);
+    int carried = handle->tx_len - handle->tx_pos;
+    if ( carried > len )
+    {
+        carried = len;
+    }
+    memcpy(data, (uint8_t *)handle->tx_buf + handle->tx_pos, carried);
+    handle->tx_pos += carried;
+    return carried + hdlc_ll_run_tx(handle->handle, (uint8_t *)data + carried, len - carried);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-static int hdlc_run_tx_until_sent(hdlc_handle_t handle, uint32_t timeout)
+static int hdlc_run_tx_until_sent(hdlc_handle_t handle, uint16_t seq, uint32_t timeout)
 {
     LOG(TINY_LOG_DEB, "[HDLC:%p] hdlc_run_tx_until_sent\n", handle);
     uint32_t ts = tiny_millis();
     int result = 0;
     for ( ;; )
     {
-        uint8_t buf[1];
-        result = hdlc_ll_run_tx(handle->handle, buf, sizeof(buf));
-        while ( result > 0 )
-        {
-            int temp = handle->send_tx(handle->user_data, buf, result);
-            if ( temp < 0 )
-            {
-                result = temp;
-                break;
-            }
-            result -= temp;
-        }
-
+        result = hdlc_run_tx(handle);
         if ( result < 0 )
         {
             hdlc_send_terminate(handle);
             LOG(TINY_LOG_ERR, "[HDLC:%p] hdlc_run_tx_until_sent failed: %d\n", handle, result);
             break;
         }
-        uint8_t bits = tiny_events_wait(&handle->events, TX_DATA_SENT_BIT, EVENT_BITS_CLEAR, 0);
-        if ( bits != 0 )
+        // Frame is completed by encoder earlier, than its last block is accepted by send_tx()
+        if ( hdlc_is_sent(handle, seq) && handle->tx_pos == handle->tx_len )
         {
             result = TINY_SUCCESS;
             break;
@@ -210,22 +265,37 @@ static int hdlc_run_tx_until_sent(hdlc_handle_t handle, uint32_t timeout)
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-static int hdlc_put(hdlc_handle_t handle, const void *data, int len, uint32_t timeout)
+static int hdlc_put(hdlc_handle_t handle, const void *data, int len, uint32_t timeout, uint16_t *seq)
 {
     if ( !len )
     {
         return TINY_ERR_INVALID_DATA;
     }
-    // Check if TX thread is ready to accept new data
+    // Check if TX queue has free slot
     if ( tiny_events_wait(&handle->events, TX_ACCEPT_BIT, EVENT_BITS_CLEAR, timeout) == 0 )
     {
         LOG(TINY_LOG_WRN, "[HDLC:%p] hdlc_put FAILED\n", handle);
         return TINY_ERR_TIMEOUT;
     }
-    hdlc_ll_put(handle->handle, data, len);
+    tiny_mutex_lock(&handle->tx_mutex);
+    tiny_iovec_t *slot = &handle->tx_queue[(handle->tx_head + handle->tx_count) % handle->tx_queue_size];
+    slot->data = data;
+    slot->len = len;
+    handle->tx_count++;
+    *seq = ++handle->tx_put_seq;
+    if ( handle->tx_count == 1 )
+    {
+        // Encoder is idle, otherwise the frame is taken from the queue, when previous one is sent
+        hdlc_ll_put(handle->handle, data, len);
+    }
+    if ( handle->tx_count < handle->tx_queue_size )
+    {
+        tiny_events_set(&handle->events, TX_ACCEPT_BIT);
+    }
     LOG(TINY_LOG_DEB, "[HDLC:%p] hdlc_put SUCCESS\n", handle);
     // Indicate that now we have something to send
     tiny_events_set(&handle->events, TX_DATA_READY_BIT);
+    tiny_mutex_unlock(&handle->tx_mutex);
     return TINY_SUCCESS;
 }
 
@@ -235,9 +305,11 @@ int hdlc_send(hdlc_handle_t handle, const void *data, int len, uint32_t timeout)
 {
     LOG(TINY_LOG_DEB, "[HDLC:%p] hdlc_send (timeout = %u)\n", handle, timeout);
     int result = TINY_SUCCESS;
+    // Without new data wait for all frames, which are already queued
+    uint16_t seq = handle->tx_put_seq;
     if ( data != NULL )
     {
-        result = hdlc_put(handle, data, len, timeout);
+        result = hdlc_put(handle, data, len, timeout, &seq);
         if ( result == TINY_ERR_TIMEOUT )
             result = TINY_ERR_BUSY;
     }
@@ -248,13 +320,24 @@ int hdlc_send(hdlc_handle_t handle, const void *data, int len, uint32_t timeout)
             LOG(TINY_LOG_DEB, "[HDLC:%p] hdlc_send waits for send operation completes (timeout = %u)\n", handle,
                 timeout);
             // in multithreaded mode we must wait, until Tx thread sends the data
-            uint8_t bits = tiny_events_wait(&handle->events, TX_DATA_SENT_BIT, EVENT_BITS_CLEAR, timeout);
-            result = bits == 0 ? TINY_ERR_TIMEOUT : TINY_SUCCESS;
+            uint32_t ts = tiny_millis();
+            result = TINY_SUCCESS;
+            while ( !hdlc_is_sent(handle, seq) )
+            {
+                uint32_t passed = (uint32_t)(tiny_millis() - ts);
+                // Other frames can be completed earlier, so the bit is only a hint to check the queue
+                if ( passed >= timeout ||
+                     tiny_events_wait(&handle->events, TX_DATA_SENT_BIT, EVENT_BITS_CLEAR, timeout - passed) == 0 )
+                {
+                    result = hdlc_is_sent(handle, seq) ? TINY_SUCCESS : TINY_ERR_TIMEOUT;
+                    break;
+                }
+            }
         }
         else
         {
             // while in single thread mode we must send the data by ourselves
-            result = hdlc_run_tx_until_sent(handle, timeout);
+            result = hdlc_run_tx_until_sent(handle, seq, timeout);
         }
     }
     else
@@ -48,6 +48,17 @@ extern "C"
      *          framing only according to RFC 1662: 0x7E, 0x7D, 0x20 (ISO Standard 3309-1979).
      */
 
+#ifndef HDLC_TX_BUF_SIZE
+#if defined(__AVR__)
+/**
+ * Size of internal block buffer, used by hdlc_run_tx(), if application doesn't provide own tx_buf.
+ */
+#define HDLC_TX_BUF_SIZE 4
+#else
+#define HDLC_TX_BUF_SIZE 64
+#endif
+#endif
+
     /**
      * Structure describes configuration of lowest HDLC level
      * Initialize this structure by 0 before passing to hdlc_init()
@@ -117,6 +128,26 @@ extern "C"
         /** User data, which will be passed to user-defined callback as first argument */
         void *user_data;
 
+        /**
+         * Optional array of slots for outgoing frames. If it is set, hdlc_send() accepts up to
+         * tx_queue_size frames without waiting, and the frames are encoded back-to-back.
+         * on_frame_send() is called for the frames in the order they were put.
+         * If NULL, only one frame can be queued at a time.
+         */
+        tiny_iovec_t *tx_queue;
+
+        /** Number of slots in tx_queue array */
+        int tx_queue_size;
+
+        /**
+         * Optional buffer for encoded data. hdlc_run_tx() encodes data into this buffer and passes
+         * whole blocks to send_tx(). If NULL, internal buffer of HDLC_TX_BUF_SIZE bytes is used.
+         */
+        void *tx_buf;
+
+        /** Size of tx_buf in bytes */
+        int tx_buf_size;
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
         /** Parameters in DOXYGEN_SHOULD_SKIP_THIS section should not be modified by a user */
         tiny_events_t events;
@@ -124,6 +155,19 @@ extern "C"
         hdlc_ll_handle_t handle;
 
         int rx_len;
+
+        tiny_mutex_t tx_mutex;
+        tiny_iovec_t tx_slot;
+        int tx_head;
+        int tx_count;
+        /// Number of frames put to the queue, used to wait for specific frame
+        uint16_t tx_put_seq;
+        /// Number of frames, which sending is completed
+        uint16_t tx_done_seq;
+        /// Encoded bytes, which are not accepted by send_tx() yet, are kept in tx_buf
+        int tx_pos;
+        int tx_len;
+        uint8_t tx_stream[HDLC_TX_BUF_SIZE];
 #endif
     } hdlc_struct_t, *hdlc_handle_t; ///< hdlc handle
 
@@ -187,9 +231,10 @@ extern "C"
 
     /**
      * Runs transmission at hdlc level. If there is frame to send, or
-     * send is in progress, this function will call send_tx() callback
-     * multiple times. If send_tx() callback reports 0, that means that
+     * send is in progress, this function encodes data into tx_buf and passes
+     * whole blocks to send_tx() callback. If send_tx() callback reports 0, that means that
      * hw device is busy and in this case hdlc_run_tx() will return immediately.
+     * If send_tx() accepts only part of the block, the rest is sent by next call.
      *
      * @warning this function must be called from one thread only.
      *
@@ -203,7 +248,8 @@ extern "C"
     /**
      * If hdlc protocol has some data to send it will full data with
      * This function returns either if no more data to send, or specified
-     * buffer is filled completely.
+     * buffer is filled completely. Encoded bytes, left by previous hdlc_run_tx() call,
+     * go first.
      *
      * @param handle handle to hdlc instance
      * @param data pointer to buffer to fill with data
@@ -236,6 +282,8 @@ extern "C"
      * wait or perform send operation, but only pass data pointer to
      * hdlc state machine. In this case, some other thread needs to
      * or in the same thread you need to send data using hdlc_run_tx().
+     * If tx_queue is configured, several frames can be put this way, and
+     * TINY_ERR_BUSY is returned only when all slots are occupied.
      *
      * @param handle handle to hdlc instance
      * @param data pointer to new data to send (can be NULL is you need to retry sending)
@@ -95,6 +95,7 @@ int hdlc_ll_init(hdlc_ll_handle_t *handle, hdlc_ll_init_t *init)
     (*handle)->user_data = init->user_data;
     (*handle)->phys_mtu = init->mtu ? (init->mtu + get_crc_field_size((*handle)->crc_type)): ((*handle)->rx_buf_size);
     (*handle)->rx.frame_buf = (*handle)->rx_buf;
+    (*handle)->stats = (hdlc_ll_stats_t){0};
 
     // Must be last
     hdlc_ll_reset(*handle, HDLC_LL_RESET_BOTH);
@@ -123,6 +124,7 @@ void hdlc_ll_reset(hdlc_ll_handle_t handle, uint8_t flags)
     if ( flags != HDLC_LL_RESET_TX_ONLY )
     {
         handle->rx.state = hdlc_ll_read_start;
+        handle->rx.garbage = 0;
     }
     if ( flags != HDLC_LL_RESET_RX_ONLY )
     {
@@ -279,6 +281,7 @@ static int hdlc_ll_send_end(hdlc_ll_handle_t handle)
         const void *ptr = handle->tx.origin_data;
         handle->tx.origin_data = NULL;
         handle->tx.data = NULL;
+        handle->stats.frames_sent++;
         if ( handle->on_frame_send )
         {
             handle->on_frame_send(handle->user_data, ptr, len);
@@ -383,14 +386,18 @@ static int hdlc_ll_read_start(hdlc_ll_handle_t handle, const uint8_t *data, int
     }
     if ( data[0] != FLAG_SEQUENCE )
     {
-        if ( data[0] != FILL_BYTE )
+        if ( data[0] != FILL_BYTE && !handle->rx.garbage )
         {
-            // TODO: Skip byte, but we received some wrong data
+            // Skip byte, but we received some wrong data. Count the whole sequence as single error
+            handle->rx.garbage = 1;
+            handle->stats.framing_errors++;
         }
         return 1;
     }
     LOG(TINY_LOG_DEB, "[HDLC:%p] RX: %02X\n", handle, data[0]);
+    handle->rx.garbage = 0;
     handle->rx.escape = 0;
+    handle->rx.overflow = 0;
     handle->rx.data = handle->rx.frame_buf;
     handle->rx.state = hdlc_ll_read_data;
     return 1;
@@ -432,6 +439,7 @@ static int hdlc_ll_read_data(hdlc_ll_handle_t handle, const uint8_t *data, int l
         {
             LOG(TINY_LOG_WRN, "[HDLC:%p] No space for incoming byte: len=%i (mtu = %i)\n",
                               handle, (int)(handle->rx.data - handle->rx.frame_buf), handle->phys_mtu);
+            handle->rx.overflow = 1;
         }
         result++;
         data++;
@@ -454,16 +462,18 @@ static int hdlc_ll_read_end(hdlc_ll_handle_t handle, const uint8_t *data, int le
     }
     handle->rx.state = hdlc_ll_read_start;
     int len = (int)(handle->rx.data - handle->rx.frame_buf);
-    if ( len > handle->phys_mtu )
+    if ( handle->rx.overflow || len > handle->phys_mtu )
     {
         // Buffer size issue, too long packet
         LOG(TINY_LOG_ERR, "[HDLC:%p] RX: tool long frame\n", handle);
+        handle->stats.overflows++;
         return TINY_ERR_DATA_TOO_LARGE;
     }
     if ( len < (uint8_t)handle->crc_type / 8 )
     {
         // CRC size issue
         LOG(TINY_LOG_ERR, "[HDLC:%p] RX: crc field is too short\n", handle);
+        handle->stats.framing_errors++;
         return TINY_ERR_WRONG_CRC;
     }
     crc_t calc_crc = 0;
@@ -505,11 +515,13 @@ static int hdlc_ll_read_end(hdlc_ll_handle_t handle, const uint8_t *data, int le
                 fprintf(stderr, " %02X ", (handle->rx.frame_buf)[i]);
         LOG(TINY_LOG_DEB, "\n%s\n","------------");
 #endif
+        handle->stats.crc_errors++;
         return TINY_ERR_WRONG_CRC;
     }
     // Shift back data pointer, pointing to the last byte after payload
     len -= (uint8_t)handle->crc_type / 8;
     LOG(TINY_LOG_INFO, "[HDLC:%p] RX: Frame success: %d bytes\n", handle, len);
+    handle->stats.frames_received++;
     if ( handle->on_frame_read )
     {
         handle->on_frame_read(handle->user_data, handle->rx.frame_buf, len);
@@ -551,6 +563,13 @@ int hdlc_ll_run_rx(hdlc_ll_handle_t handle, const void *data, int len, int *erro
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+void hdlc_ll_get_stats(hdlc_ll_handle_t handle, hdlc_ll_stats_t *stats)
+{
+    *stats = handle->stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 int hdlc_ll_get_buf_size(int mtu)
 {
     // TINY_ALIGN_STRUCT_VALUE is added to satisfy alignment requirements
@@ -67,6 +67,28 @@ extern "C"
     /** Handle for HDLC low level protocol */
     typedef struct hdlc_ll_data_t *hdlc_ll_handle_t;
 
+    /**
+     * Counters of HDLC low level framing. Counters are set to 0 by hdlc_ll_init(),
+     * are not cleared by hdlc_ll_reset() and wrap around on overflow.
+     */
+    typedef struct
+    {
+        /** Number of frames completely passed to tx channel */
+        uint32_t frames_sent;
+
+        /** Number of frames received with valid crc field */
+        uint32_t frames_received;
+
+        /** Number of received frames dropped due to wrong crc field */
+        uint32_t crc_errors;
+
+        /** Number of frames too short to hold crc field and of unexpected byte sequences between frames */
+        uint32_t framing_errors;
+
+        /** Number of received frames dropped, because they do not fit mtu */
+        uint32_t overflows;
+    } hdlc_ll_stats_t;
+
     /**
      * Structure describes configuration of lowest HDLC level
      * Initialize this structure by 0 before passing to hdlc_ll_init()
@@ -148,6 +170,16 @@ extern "C"
      */
     void hdlc_ll_reset(hdlc_ll_handle_t handle, uint8_t flags);
 
+    /**
+     * Returns framing counters of hdlc level. Counters are updated without synchronization
+     * from hdlc_ll_run_rx() and hdlc_ll_run_tx() contexts, so the values, read from other thread,
+     * can be slightly outdated.
+     *
+     * @param handle hdlc handle
+     * @param stats pointer to structure to copy counters to
+     */
+    void hdlc_ll_get_stats(hdlc_ll_handle_t handle, hdlc_ll_stats_t *stats);
+
     //------------------------ RX FUNCIONS ------------------------------
 
     /**
@@ -29,6 +29,7 @@
 
 #include "hal/tiny_types.h"
 #include "proto/crc/tiny_crc.h"
+#include "proto/hdlc/low_level/hdlc.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -47,15 +48,21 @@ extern "C"
  *          framing only according to RFC 1662: 0x7E, 0x7D, 0x20 (ISO Standard 3309-1979).
  */
 
+/**
+ * Macro calculating size of crc field in bytes. Compile-time version of get_crc_field_size().
+ */
+#define HDLC_CRC_FIELD_SIZE(crc) ((crc) == HDLC_CRC_OFF ? 0 : (crc) == HDLC_CRC_DEFAULT ? 4 : (int)(crc) / 8)
+
 /**
  * Macro calculating minimum buffer size required for specific packet size in bytes
  */
-#define HDLC_MIN_BUF_SIZE(mtu, crc) (sizeof(hdlc_ll_data_t) + (int)(crc) / 8 + (mtu) + TINY_ALIGN_STRUCT_VALUE - 1)
+#define HDLC_MIN_BUF_SIZE(mtu, crc) (sizeof(hdlc_ll_data_t) + HDLC_CRC_FIELD_SIZE(crc) + (mtu) + TINY_ALIGN_STRUCT_VALUE - 1)
 
 /**
  * Macro calculating buffer size required for specific packet size in bytes, and window
  */
-#define HDLC_BUF_SIZE_EX(mtu, crc, window) (sizeof(hdlc_ll_data_t) + ((int)(crc) / 8 + (mtu)) * (window) + TINY_ALIGN_STRUCT_VALUE - 1)
+#define HDLC_BUF_SIZE_EX(mtu, crc, window)                                                                             \
+    (sizeof(hdlc_ll_data_t) + (HDLC_CRC_FIELD_SIZE(crc) + (mtu)) * (window) + TINY_ALIGN_STRUCT_VALUE - 1)
 
     /**
      * Structure describes configuration of lowest HDLC level
@@ -112,6 +119,8 @@ extern "C"
             int (*state)(hdlc_ll_handle_t handle, const uint8_t *data, int len);
             uint8_t *data;
             uint8_t escape;
+            uint8_t overflow;
+            uint8_t garbage;
             uint8_t *frame_buf;
         } rx;
         struct
@@ -125,6 +134,7 @@ extern "C"
             crc_t crc;
             uint8_t escape;
         } tx;
+        hdlc_ll_stats_t stats;
 #endif
     } hdlc_ll_data_t;
 
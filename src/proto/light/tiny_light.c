@@ -80,6 +80,13 @@ int tiny_light_init(STinyLightData *handle, write_block_cb_t write_func, read_bl
     handle->user_data = pdata;
     handle->read_func = read_func;
     handle->write_func = write_func;
+    handle->tx_len = 0;
+    handle->tx_pos = 0;
+    if ( !handle->tx_buf || handle->tx_buf_size <= 0 )
+    {
+        handle->tx_buf = handle->tx_stream;
+        handle->tx_buf_size = sizeof(handle->tx_stream);
+    }
 
     return hdlc_ll_init(&handle->_hdlc, &init);
 }
@@ -110,29 +117,66 @@ static void on_frame_send(void *user_data, const uint8_t *data, int len)
 
 /////////////////////////////////////////////////////////////////////////////////////////
 
-int tiny_light_send(STinyLightData *handle, const uint8_t *pbuf, int len)
+int tiny_light_run_tx(STinyLightData *handle)
 {
-    uint32_t ts = tiny_millis();
-    int result = TINY_SUCCESS;
-    hdlc_ll_put(handle->_hdlc, pbuf, len);
-    while ( handle->_hdlc->tx.origin_data )
+    for ( ;; )
     {
-        uint8_t stream[1];
-        int stream_len = hdlc_ll_run_tx(handle->_hdlc, stream, sizeof(stream));
-        do
+        if ( handle->tx_pos == handle->tx_len )
         {
-            result = handle->write_func(handle->user_data, stream, stream_len);
-            if ( result < 0 )
-            {
-                return result;
-            }
-            if ( (uint32_t)(tiny_millis() - ts) >= 1000 )
+            if ( !handle->_hdlc->tx.origin_data )
             {
-                hdlc_ll_reset(handle->_hdlc, HDLC_LL_RESET_TX_ONLY);
-                result = TINY_ERR_TIMEOUT;
-                break;
+                return TINY_SUCCESS;
             }
-        } while ( result < stream_len );
+            // Encode as much of the frame as output buffer can hold
+            handle->tx_len = hdlc_ll_run_tx(handle->_hdlc, handle->tx_buf, handle->tx_buf_size);
+            handle->tx_pos = 0;
+            continue;
+        }
+        int result = handle->write_func(handle->user_data, &handle->tx_buf[handle->tx_pos],
+                                        handle->tx_len - handle->tx_pos);
+        if ( result < 0 )
+        {
+            return result;
+        }
+        if ( result == 0 )
+        {
+            return TINY_ERR_AGAIN;
+        }
+        handle->tx_pos += result;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+int tiny_light_put(STinyLightData *handle, const uint8_t *pbuf, int len)
+{
+    if ( handle->tx_pos != handle->tx_len )
+    {
+        return TINY_ERR_BUSY;
+    }
+    int result = hdlc_ll_put(handle->_hdlc, pbuf, len);
+    if ( result != TINY_SUCCESS )
+    {
+        return result;
+    }
+    return tiny_light_run_tx(handle);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+int tiny_light_send(STinyLightData *handle, const uint8_t *pbuf, int len)
+{
+    uint32_t ts = tiny_millis();
+    int result = tiny_light_put(handle, pbuf, len);
+    while ( result == TINY_ERR_AGAIN )
+    {
+        if ( (uint32_t)(tiny_millis() - ts) >= 1000 )
+        {
+            hdlc_ll_reset(handle->_hdlc, HDLC_LL_RESET_TX_ONLY);
+            handle->tx_pos = handle->tx_len = 0;
+            return TINY_ERR_TIMEOUT;
+        }
+        result = tiny_light_run_tx(handle);
     }
     return result >= 0 ? len : result;
 }
@@ -55,9 +55,21 @@ extern "C"
  *************************************************************/
 
 /**
- * This macro defines buffer size required for tiny light protocol
+ * This macro defines buffer size required for tiny light protocol, including hdlc counters
  */
-#define LIGHT_BUF_SIZE (sizeof(uintptr_t) * 18)
+#define LIGHT_BUF_SIZE (sizeof(uintptr_t) * 18 + sizeof(uint32_t) * 5)
+
+#ifndef LIGHT_TX_BUF_SIZE
+#if defined(__AVR__)
+/**
+ * This macro defines size of internal output buffer, used if application doesn't provide own buffer.
+ * Encoded frame is passed to write function in blocks of this size.
+ */
+#define LIGHT_TX_BUF_SIZE 4
+#else
+#define LIGHT_TX_BUF_SIZE 64
+#endif
+#endif
 
     /**
      * This structure contains information about communication channel and its state.
@@ -72,12 +84,22 @@ extern "C"
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
         hdlc_ll_handle_t _hdlc;
         int rx_len;
+        int tx_len;
+        int tx_pos;
         TINY_ALIGNED_STRUCT uint8_t buffer[LIGHT_BUF_SIZE];
+        uint8_t tx_stream[LIGHT_TX_BUF_SIZE];
 #endif
         /// user-specific data
         void *user_data;
         /// CRC type to use
         hdlc_crc_t crc_type;
+        /**
+         * Optional output buffer for encoded data, NULL to use internal buffer of LIGHT_TX_BUF_SIZE bytes.
+         * If the buffer can hold the whole encoded frame, the frame is passed to write function in one call.
+         */
+        uint8_t *tx_buf;
+        /// size of the output buffer in bytes
+        int tx_buf_size;
     } STinyLightData;
 
     /**
@@ -121,6 +143,33 @@ extern "C"
      */
     extern int tiny_light_send(STinyLightData *handle, const uint8_t *pbuf, int len);
 
+    /**
+     * @brief puts frame for sending in non-blocking mode
+     *
+     * The function starts sending of the frame and writes as much data as write function accepts
+     * without waiting. The rest of the frame is sent by tiny_light_run_tx() calls.
+     * The buffer must remain valid until tiny_light_run_tx() returns TINY_SUCCESS.
+     * @param handle - pointer to Tiny Light data.
+     * @param pbuf - buffer with data to send
+     * @param len - length of data to send
+     * @return TINY_SUCCESS if the frame is completely sent,
+     *         TINY_ERR_AGAIN if the frame is accepted, but not sent yet,
+     *         TINY_ERR_BUSY if previous frame is not sent yet, or error code of write function.
+     * @remarks This function is not thread safe.
+     */
+    extern int tiny_light_put(STinyLightData *handle, const uint8_t *pbuf, int len);
+
+    /**
+     * @brief continues sending of the frame, put by tiny_light_put()
+     *
+     * The function never waits: it returns as soon as write function accepts less data than requested.
+     * @param handle - pointer to Tiny Light data.
+     * @return TINY_SUCCESS if there is no data to send,
+     *         TINY_ERR_AGAIN if some data are still waiting for the channel, or error code of write function.
+     * @remarks This function is not thread safe.
+     */
+    extern int tiny_light_run_tx(STinyLightData *handle);
+
     /**
      * @brief reads frame from the channel in blocking mode.
      *
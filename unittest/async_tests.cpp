@@ -0,0 +1,144 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include <CppUTest/TestHarness.h>
+#include "TinyProtocol.h"
+
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1 && defined(__linux__) && defined(__cpp_impl_coroutine)
+
+#include "helpers/shm_proto_helper.h"
+#include <coroutine>
+#include <exception>
+#include <string>
+#include <vector>
+
+TEST_GROUP(ASYNC){void setup(){
+    // ...
+}
+
+                void teardown(){
+                    // ...
+                }};
+
+/** Coroutine, which starts immediately and destroys itself upon completion */
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask get_return_object()
+        {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void()
+        {
+        }
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+static DetachedTask sendMany(tinyproto::Proto &proto, tinyproto::ProtoExecutor &executor, int count, int &sent)
+{
+    for ( int i = 0; i < count; i++ )
+    {
+        tinyproto::StaticPacket<16> packet;
+        packet.put(static_cast<uint8_t>(i));
+        if ( !co_await proto.asyncSend(packet, &executor) )
+        {
+            break;
+        }
+        sent++;
+    }
+}
+
+static DetachedTask readMany(tinyproto::Proto &proto, tinyproto::ProtoExecutor &executor, int count,
+                             std::vector<int> &received)
+{
+    for ( int i = 0; i < count; i++ )
+    {
+        tinyproto::IPacket *packet = co_await proto.asyncRead(&executor);
+        if ( packet == nullptr )
+        {
+            break;
+        }
+        received.push_back(packet->getByte());
+        proto.release(packet);
+    }
+}
+
+TEST(ASYNC, coroutines_exchange_packets_in_order)
+{
+    ShmProtoPair pair("async-order");
+    // Coroutines are resumed later by executor, so frames must wait for free packets in the link
+    pair.receiver.setRxOverflow(tinyproto::RxOverflow::BACKPRESSURE);
+    pair.addRxPool();
+    CHECK_TRUE(pair.receiver.begin());
+    CHECK_TRUE(pair.sender.begin());
+    tinyproto::SimpleExecutor executor;
+    int sent = 0;
+    std::vector<int> received;
+    readMany(pair.receiver, executor, 20, received);
+    sendMany(pair.sender, executor, 20, sent);
+    for ( int i = 0; i < 100 && received.size() < 20; i++ )
+    {
+        executor.runFor(50);
+    }
+    CHECK_EQUAL(20, sent);
+    CHECK_EQUAL(20, (int)received.size());
+    CHECK_EQUAL(0, pair.receiver.getLostRxFrames());
+    for ( int i = 0; i < (int)received.size(); i++ )
+    {
+        CHECK_EQUAL(i, received[i]);
+    }
+}
+
+TEST(ASYNC, end_resumes_pending_read)
+{
+    ShmProtoPair pair("async-cancel");
+    pair.addRxPool();
+    CHECK_TRUE(pair.receiver.begin());
+    tinyproto::SimpleExecutor executor;
+    std::vector<int> received;
+    readMany(pair.receiver, executor, 1, received);
+    CHECK_EQUAL(0, executor.poll());
+    pair.receiver.end();
+    CHECK_EQUAL(1, executor.runFor(100));
+    CHECK_EQUAL(0, (int)received.size());
+}
+
+#endif
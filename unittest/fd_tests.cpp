@@ -31,9 +31,13 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include <thread>
+#include <vector>
+#include <string>
 #include "helpers/tiny_fd_helper.h"
 #include "helpers/fake_connection.h"
+#include "TinyProtocolFd.h"
 
 TEST_GROUP(FD){void setup(){
     // ...
@@ -201,6 +205,39 @@ TEST(FD, error_on_rej)
     CHECK_EQUAL(2, helper1.rx_count());
 }
 
+TEST(FD, stats_count_rej_and_crc_errors)
+{
+    FakeSetup conn;
+    TinyHelperFd helper1(&conn.endpoint1(), 4096, nullptr, 7, 250);
+    TinyHelperFd helper2(&conn.endpoint2(), 4096, nullptr, 7, 250);
+    conn.line2().generate_single_error(6 + 6 + 4); // Put error on first I-frame
+    helper1.run(true);
+    helper2.run(true);
+
+    for ( int i = 0; i < 2; i++ )
+    {
+        uint8_t txbuf[4] = {0xAA, 0xFF, 0xCC, 0x66};
+        CHECK_EQUAL(TINY_SUCCESS, helper2.send(txbuf, sizeof(txbuf)));
+    }
+    helper1.wait_until_rx_count(2, 400);
+    CHECK_EQUAL(2, helper1.rx_count());
+    helper1.stop();
+    helper2.stop();
+    tiny_fd_stats_t rx_stats{};
+    tiny_fd_stats_t tx_stats{};
+    CHECK_EQUAL(TINY_SUCCESS, helper1.get_stats(&rx_stats));
+    CHECK_EQUAL(TINY_SUCCESS, helper2.get_stats(&tx_stats));
+    CHECK_EQUAL(1, rx_stats.crc_errors);
+    CHECK_EQUAL(1, rx_stats.rej_sent);
+    CHECK_EQUAL(3, rx_stats.i_frames_received);
+    CHECK_EQUAL(1, tx_stats.rej_received);
+    CHECK_EQUAL(2, tx_stats.retransmissions);
+    CHECK_EQUAL(4, tx_stats.i_frames_sent);
+    CHECK_EQUAL(0, tx_stats.queue_full);
+    CHECK_TRUE(rx_stats.link_frames_received >= 4);
+    CHECK_EQUAL(TINY_ERR_UNKNOWN_PEER, helper1.get_stats(&rx_stats, 5));
+}
+
 TEST(FD, no_ka_switch_to_disconnected)
 {
     FakeSetup conn(32, 32);
@@ -315,3 +352,225 @@ TEST(FD, on_connect_callback)
     }
     CHECK_EQUAL(false, connected);
 }
+
+TEST(FD, logical_channels_priority_and_quota)
+{
+    TinyHelperFdPair pair(7, 2);
+    CHECK_EQUAL(TINY_SUCCESS, pair.status());
+    tiny_fd_handle_t handle1 = pair.side1.handle;
+    CHECK_EQUAL(31, tiny_fd_get_mtu(handle1));
+    CHECK_EQUAL(TINY_SUCCESS, pair.setChannel(1, 10, 1));
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, pair.setChannel(2, 10, 1));
+    CHECK_TRUE(pair.connect());
+
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_channel_packet_to(handle1, TINY_FD_PRIMARY_ADDR, 0, "low1", 4, 0));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_channel_packet_to(handle1, TINY_FD_PRIMARY_ADDR, 0, "low2", 4, 0));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_channel_packet_to(handle1, TINY_FD_PRIMARY_ADDR, 1, "high", 4, 0));
+    // Channel 1 quota is exhausted until the frame is confirmed
+    CHECK_EQUAL(TINY_ERR_TIMEOUT, tiny_fd_send_channel_packet_to(handle1, TINY_FD_PRIMARY_ADDR, 1, "high", 4, 0));
+    CHECK_EQUAL(TINY_ERR_INVALID_DATA, tiny_fd_send_channel_packet_to(handle1, TINY_FD_PRIMARY_ADDR, 2, "bad", 3, 0));
+
+    pair.pump();
+    auto &frames = pair.side2.frames;
+    CHECK_EQUAL(3, (int)frames.size());
+    CHECK_EQUAL(1, frames[0].first);
+    STRCMP_EQUAL("high", frames[0].second.c_str());
+    STRCMP_EQUAL("low1", frames[1].second.c_str());
+    STRCMP_EQUAL("low2", frames[2].second.c_str());
+    CHECK_EQUAL(0, frames[2].first);
+    // Quota is released after confirmation
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_channel_packet_to(handle1, TINY_FD_PRIMARY_ADDR, 1, "next", 4, 0));
+}
+
+TEST(FD, urgent_frame_overtakes_queued_frames)
+{
+    TinyHelperFdPair pair(4, 1, 1);
+    CHECK_EQUAL(TINY_SUCCESS, pair.status());
+    CHECK_TRUE(pair.connect());
+    tiny_fd_handle_t handle1 = pair.side1.handle;
+
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle1, "bulk1", 5, 0));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle1, "bulk2", 5, 0));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle1, "bulk3", 5, 0));
+    // The last slot is reserved for urgent frames
+    CHECK_EQUAL(TINY_ERR_TIMEOUT, tiny_fd_send_packet(handle1, "bulk4", 5, 0));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_urgent(handle1, "stop", 4, 0));
+
+    pair.pump();
+    auto &frames = pair.side2.frames;
+    CHECK_EQUAL(4, (int)frames.size());
+    STRCMP_EQUAL("stop", frames[0].second.c_str());
+    STRCMP_EQUAL("bulk1", frames[1].second.c_str());
+    STRCMP_EQUAL("bulk2", frames[2].second.c_str());
+    STRCMP_EQUAL("bulk3", frames[3].second.c_str());
+}
+
+TEST(FD, datagrams_latest_value_wins)
+{
+    TinyHelperFdPair pair(4);
+    CHECK_EQUAL(TINY_SUCCESS, pair.status());
+    CHECK_TRUE(pair.connect());
+    tiny_fd_handle_t handle1 = pair.side1.handle;
+
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle1, "cmd", 3, 0));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_datagram(handle1, "t=1", 3, TINY_FD_DATAGRAM_LATEST));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_datagram(handle1, "t=2", 3, TINY_FD_DATAGRAM_LATEST));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_datagram(handle1, "t=3", 3, TINY_FD_DATAGRAM_LATEST));
+    pair.pump();
+    auto &frames = pair.side2.frames;
+    CHECK_EQUAL(2, (int)frames.size());
+    // Datagrams are sent ahead of I-frames
+    CHECK_EQUAL(TinyFdSide::DATAGRAM, frames[0].first);
+    STRCMP_EQUAL("t=3", frames[0].second.c_str());
+    CHECK_EQUAL(0, frames[1].first);
+    STRCMP_EQUAL("cmd", frames[1].second.c_str());
+
+    // Without the flag all datagrams are delivered, and slots are released after sending
+    for ( int i = 0; i < 4; i++ )
+    {
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_datagram(handle1, "abc", 3, 0));
+    }
+    CHECK_EQUAL(TINY_ERR_BUSY, tiny_fd_send_datagram(handle1, "abc", 3, 0));
+    TinyHelperFdPair::pump(handle1, pair.side2.handle);
+    CHECK_EQUAL(6, (int)frames.size());
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle1, "cmd", 3, 0));
+    TinyHelperFdPair::pump(handle1, pair.side2.handle);
+
+    // Slots of dropped datagrams can be used by I-frames at once
+    while ( tiny_fd_send_datagram(handle1, "abc", 3, 0) == TINY_SUCCESS )
+    {
+    }
+    CHECK_EQUAL(TINY_ERR_TIMEOUT, tiny_fd_send_packet(handle1, "cmd", 3, 0));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_datagram(handle1, "t=4", 3, TINY_FD_DATAGRAM_LATEST));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle1, "cmd", 3, 0));
+}
+
+TEST(FD, submit_packet_with_completion_ticket)
+{
+    TinyHelperFdPair pair(2);
+    CHECK_EQUAL(TINY_SUCCESS, pair.status());
+    tiny_fd_handle_t handle1 = pair.side1.handle;
+    auto &completions = pair.side1.completions;
+
+    // Not connected yet
+    CHECK_EQUAL(TINY_ERR_BUSY, tiny_fd_submit_packet_to(handle1, TINY_FD_PRIMARY_ADDR, "data", 4));
+    CHECK_TRUE(pair.connect());
+
+    int ticket1 = tiny_fd_submit_packet_to(handle1, TINY_FD_PRIMARY_ADDR, "data1", 5);
+    int ticket2 = tiny_fd_submit_packet_to(handle1, TINY_FD_PRIMARY_ADDR, "data2", 5);
+    CHECK(ticket1 > 0);
+    CHECK(ticket2 > 0);
+    CHECK(ticket1 != ticket2);
+    // Queue is full, the call must not block
+    CHECK_EQUAL(TINY_ERR_BUSY, tiny_fd_submit_packet_to(handle1, TINY_FD_PRIMARY_ADDR, "data3", 5));
+    pair.pump();
+    CHECK_EQUAL(2, (int)pair.side2.frames.size());
+    CHECK_EQUAL(2, (int)completions.size());
+    CHECK_EQUAL(ticket1, completions[0].first);
+    CHECK_EQUAL(TINY_SUCCESS, completions[0].second);
+    CHECK_EQUAL(ticket2, completions[1].first);
+
+    // Frames, dropped on disconnect, are reported as failed
+    int ticket3 = tiny_fd_submit_packet_to(handle1, TINY_FD_PRIMARY_ADDR, "data3", 5);
+    CHECK(ticket3 > 0);
+    tiny_fd_disconnect(handle1);
+    pair.pump();
+    CHECK_EQUAL(3, (int)completions.size());
+    CHECK_EQUAL(ticket3, completions[2].first);
+    CHECK_EQUAL(TINY_ERR_FAILED, completions[2].second);
+}
+
+TEST(FD, send_batch_accepts_what_fits)
+{
+    TinyHelperFdPair pair(4);
+    CHECK_EQUAL(TINY_SUCCESS, pair.status());
+    CHECK_TRUE(pair.connect());
+    tiny_fd_handle_t handle1 = pair.side1.handle;
+
+    tiny_iovec_t msgs[5] = {{"m1", 2}, {"m2", 2}, {"m3", 2}, {"m4", 2}, {"m5", 2}};
+    CHECK_EQUAL(4, tiny_fd_send_batch(handle1, TINY_FD_PRIMARY_ADDR, msgs, 5, 0));
+    CHECK_EQUAL(0, tiny_fd_send_batch(handle1, TINY_FD_PRIMARY_ADDR, &msgs[4], 1, 0));
+    pair.pump();
+    CHECK_EQUAL(1, tiny_fd_send_batch(handle1, TINY_FD_PRIMARY_ADDR, &msgs[4], 1, 0));
+    pair.pump();
+    auto &frames = pair.side2.frames;
+    CHECK_EQUAL(5, (int)frames.size());
+    STRCMP_EQUAL("m1", frames[0].second.c_str());
+    STRCMP_EQUAL("m4", frames[3].second.c_str());
+    STRCMP_EQUAL("m5", frames[4].second.c_str());
+}
+
+TEST(FD, send_batch_waits_for_reserved_slots_and_stops_at_large_message)
+{
+    TinyHelperFdPair pair(4, 1, 1);
+    CHECK_EQUAL(TINY_SUCCESS, pair.status());
+    CHECK_TRUE(pair.connect());
+    tiny_fd_handle_t handle1 = pair.side1.handle;
+
+    std::string large(tiny_fd_get_mtu(handle1) + 1, 'x');
+    tiny_iovec_t msgs[3] = {{"m1", 2}, {large.c_str(), (int)large.size()}, {"m3", 2}};
+    CHECK_EQUAL(1, tiny_fd_send_batch(handle1, TINY_FD_PRIMARY_ADDR, msgs, 3, 0));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle1, "bulk2", 5, 0));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(handle1, "bulk3", 5, 0));
+    // The last slot is reserved for urgent frames, so the batch waits until timeout expires
+    uint32_t start_ms = tiny_millis();
+    CHECK_EQUAL(0, tiny_fd_send_batch(handle1, TINY_FD_PRIMARY_ADDR, &msgs[2], 1, 50));
+    CHECK_TRUE(static_cast<uint32_t>(tiny_millis() - start_ms) >= 45);
+    pair.pump();
+    CHECK_EQUAL(1, tiny_fd_send_batch(handle1, TINY_FD_PRIMARY_ADDR, &msgs[2], 1, 50));
+}
+
+TEST(FD, run_rx_tx_drain_by_chunks)
+{
+    TinyHelperFdPair pair(4, 1, 0, 16);
+    CHECK_EQUAL(TINY_SUCCESS, pair.status());
+    CHECK_TRUE(pair.connect());
+    TinyFdSide &side1 = pair.side1;
+    TinyFdSide &side2 = pair.side2;
+
+    for ( int i = 0; i < 3; i++ )
+    {
+        CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet(side1.handle, "twenty bytes payload", 20, 0));
+    }
+    // All queued frames are written by single call, every write passes up to 16 bytes
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_run_tx(side1.handle, TinyFdSide::writeWire));
+    CHECK_TRUE(side1.wire.size() > 60);
+    CHECK_EQUAL((int)(side1.wire.size() + 15) / 16, side1.ioCalls);
+    // Receiver reads until the wire is drained
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_run_rx(side2.handle, TinyFdSide::readWire));
+    CHECK_EQUAL(side1.wire.size(), side1.wirePos);
+    CHECK_EQUAL((int)side1.wire.size() / 16 + 1, side2.ioCalls);
+    CHECK_EQUAL(3, (int)side2.frames.size());
+}
+
+TEST(FD, static_fd_is_sized_by_mtu_and_windows)
+{
+    using LinkFd = tinyproto::StaticFd<32, 4, 2, HDLC_CRC_16>;
+    CHECK_EQUAL(tiny_fd_buffer_size_by_mtu_ex(0, 32, 4, HDLC_CRC_16, 2), (int)FD_BUF_SIZE_EX(32, 4, HDLC_CRC_16, 2));
+    CHECK_TRUE(sizeof(LinkFd) < sizeof(tinyproto::IFd) + FD_BUF_SIZE_EX(32, 4, HDLC_CRC_16, 2) + TINY_ALIGN_STRUCT_VALUE);
+    LinkFd fd1, fd2;
+    tinyproto::FdConfig config = fd1.getConfig();
+    CHECK_EQUAL(32, config.mtu);
+    CHECK_EQUAL(4, config.window);
+    config.retries = 5;
+    config.retryTimeout = 50;
+    config.keepAliveUs = 2000000;
+    fd1.setConfig(config);
+    fd2.setConfig(config);
+    fd1.begin();
+    fd2.begin();
+    CHECK_TRUE(fd1.getHandle() != nullptr);
+    CHECK_EQUAL(32, tiny_fd_get_mtu(fd1.getHandle()));
+    uint8_t buf[16];
+    for ( int i = 0; i < 10 && fd1.getStatus() != TINY_SUCCESS; i++ )
+    {
+        int len;
+        while ( (len = fd1.run_tx(buf, sizeof(buf))) > 0 )
+            fd2.run_rx(buf, len);
+        while ( (len = fd2.run_tx(buf, sizeof(buf))) > 0 )
+            fd1.run_rx(buf, len);
+    }
+    CHECK_EQUAL(TINY_SUCCESS, fd1.getStatus());
+    fd1.end();
+    fd2.end();
+}
@@ -36,6 +36,10 @@
 #include "hal/tiny_list.h"
 #include "hal/tiny_debug.h"
 #include "proto/crc/tiny_crc.h"
+#include "hal/tiny_serial.h"
+#include <unistd.h>
+#include <string>
+#include <vector>
 #include <thread>
 
 TEST_GROUP(HAL){void setup(){
@@ -67,6 +71,26 @@ TEST(HAL, mutex)
     }
 }
 
+TEST(HAL, events)
+{
+    tiny_events_t events;
+    tiny_events_create(&events);
+    CHECK_EQUAL(0, tiny_events_wait(&events, 0x01, EVENT_BITS_LEAVE, 0));
+    tiny_events_set(&events, 0x03);
+    CHECK_EQUAL(0x03, tiny_events_wait(&events, 0x01, EVENT_BITS_CLEAR, 0));
+    CHECK_EQUAL(0x02, tiny_events_wait(&events, 0x02, EVENT_BITS_LEAVE, 0));
+    tiny_events_clear(&events, 0x02);
+    CHECK_EQUAL(0, tiny_events_wait(&events, 0x03, EVENT_BITS_LEAVE, 10));
+    std::thread setter([&events]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        tiny_events_set(&events, 0x04);
+    });
+    CHECK_EQUAL(0x04, tiny_events_wait(&events, 0x04, EVENT_BITS_CLEAR, 1000));
+    setter.join();
+    CHECK_EQUAL(0, tiny_events_wait(&events, 0x04, EVENT_BITS_LEAVE, 0));
+    tiny_events_destroy(&events);
+}
+
 extern "C" void tiny_list_init(void);
 
 TEST(HAL, list)
@@ -160,3 +184,127 @@ TEST(HAL, micros)
     CHECK_TEXT( delta >= 1500, "Sleep function works incorrectly" );
     CHECK_TEXT( delta < 4000, "Sleep function works incorrectly" );
 }
+
+TEST(HAL, micros64)
+{
+    uint64_t start = tiny_micros64();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    uint64_t delta = tiny_micros64() - start;
+    CHECK_TEXT( delta >= 1000, "Timestamping functions are incorrect" );
+    CHECK_TEXT( delta < 4000, "Timestamping functions are incorrect" );
+}
+
+#if defined(__linux__)
+TEST(HAL, shm_serial)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "shm:hal-test-%d", (int)getpid());
+    tiny_serial_handle_t a = tiny_serial_open(name, 115200);
+    tiny_serial_handle_t b = tiny_serial_open(name, 115200);
+    CHECK_TRUE(a != TINY_SERIAL_INVALID);
+    CHECK_TRUE(b != TINY_SERIAL_INVALID);
+    // Data, sent before the handshake is complete, must not be lost
+    CHECK_EQUAL(5, tiny_serial_send_timeout(a, "hello", 5, 0));
+    char buf[16] = {};
+    CHECK_EQUAL(5, tiny_serial_read_timeout(b, buf, sizeof(buf), 100));
+    STRCMP_EQUAL("hello", buf);
+    CHECK_EQUAL(3, tiny_serial_send_timeout(b, "abc", 3, 0));
+    CHECK_EQUAL(3, tiny_serial_read_timeout(a, buf, sizeof(buf), 100));
+    CHECK_EQUAL(0, tiny_serial_read_timeout(a, buf, sizeof(buf), 0));
+
+    // Transfer more data than ring can hold, while the other thread reads it
+    std::vector<uint8_t> tx(300000), rx;
+    for ( size_t i = 0; i < tx.size(); i++ )
+    {
+        tx[i] = static_cast<uint8_t>(i * 7);
+    }
+    std::thread reader([&]() {
+        uint8_t chunk[1000];
+        while ( rx.size() < tx.size() )
+        {
+            int len = tiny_serial_read_timeout(b, chunk, sizeof(chunk), 1000);
+            if ( len < 0 )
+            {
+                break;
+            }
+            rx.insert(rx.end(), chunk, chunk + len);
+        }
+    });
+    size_t sent = 0;
+    while ( sent < tx.size() )
+    {
+        int len = tiny_serial_send_timeout(a, tx.data() + sent, static_cast<int>(tx.size() - sent), 1000);
+        CHECK_TRUE(len >= 0);
+        sent += len;
+    }
+    reader.join();
+    CHECK_TRUE(tx == rx);
+    tiny_serial_close(a);
+    tiny_serial_close(b);
+}
+
+TEST(HAL, shm_serial_handshake_from_rx_and_tx_threads)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "shm:hal-handshake-%d", (int)getpid());
+    for ( int n = 0; n < 20; n++ )
+    {
+        tiny_serial_handle_t a = tiny_serial_open(name, 115200);
+        tiny_serial_handle_t b = tiny_serial_open(name, 115200);
+        CHECK_TRUE(a != TINY_SERIAL_INVALID);
+        CHECK_TRUE(b != TINY_SERIAL_INVALID);
+        // Both sides progress the handshake from separate Rx and Tx threads at the same time
+        int received[2] = {};
+        std::vector<std::thread> threads;
+        for ( int i = 0; i < 2; i++ )
+        {
+            tiny_serial_handle_t port = i ? b : a;
+            threads.emplace_back([port]() { tiny_serial_send_timeout(port, "x", 1, 1000); });
+            threads.emplace_back([port, &received, i]() {
+                char buf[4];
+                // Handshake completion wakes up the reader, so it may return before data arrive
+                for ( int wait = 0; wait < 100 && received[i] == 0; wait++ )
+                {
+                    received[i] = tiny_serial_read_timeout(port, buf, sizeof(buf), 10);
+                }
+            });
+        }
+        for ( auto &thread: threads )
+        {
+            thread.join();
+        }
+        CHECK_EQUAL(1, received[0]);
+        CHECK_EQUAL(1, received[1]);
+        tiny_serial_close(a);
+        tiny_serial_close(b);
+    }
+}
+
+TEST(HAL, shm_serial_handles_are_stable)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "shm:hal-first-%d", (int)getpid());
+    tiny_serial_handle_t a = tiny_serial_open(name, 115200);
+    tiny_serial_handle_t b = tiny_serial_open(name, 115200);
+    snprintf(name, sizeof(name), "shm:hal-second-%d", (int)getpid());
+    tiny_serial_handle_t c = tiny_serial_open(name, 115200);
+    tiny_serial_handle_t d = tiny_serial_open(name, 115200);
+    // Closing one port must not affect others, and closed handle must not refer to any port
+    tiny_serial_close(a);
+    CHECK_TRUE(tiny_serial_read_timeout(a, name, sizeof(name), 0) < 0);
+    snprintf(name, sizeof(name), "shm:hal-third-%d", (int)getpid());
+    tiny_serial_handle_t e = tiny_serial_open(name, 115200);
+    CHECK_TRUE(e != a);
+    CHECK_TRUE(tiny_serial_send_timeout(a, "x", 1, 0) < 0);
+    CHECK_EQUAL(3, tiny_serial_send_timeout(c, "abc", 3, 0));
+    CHECK_EQUAL(3, tiny_serial_read_timeout(d, name, sizeof(name), 100));
+    tiny_serial_close(b);
+    tiny_serial_close(c);
+    tiny_serial_close(d);
+    tiny_serial_close(e);
+
+    // Too long name is rejected instead of being truncated
+    std::string longName = "shm:" + std::string(TINY_SHM_MAX_NAME_LEN + 1, 'x');
+    CHECK_EQUAL(TINY_SERIAL_INVALID, tiny_serial_open(longName.c_str(), 115200));
+}
+#endif
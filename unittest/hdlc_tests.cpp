@@ -31,6 +31,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <vector>
 #include "helpers/tiny_hdlc_helper.h"
 #include "helpers/fake_connection.h"
 #include <TinyProtocolHdlc.h>
@@ -300,6 +301,164 @@ TEST(HDLC, hdlc_incomplete_send_on_close)
     CHECK_EQUAL(sizeof(frame), bytes_sent);
 }
 
+struct HdlcQueueSink
+{
+    std::vector<uint8_t> wire;
+    std::vector<const void *> sent;
+    bool busy = false;
+
+    static int write(void *user_data, const void *data, int len)
+    {
+        HdlcQueueSink *sink = reinterpret_cast<HdlcQueueSink *>(user_data);
+        if ( sink->busy )
+        {
+            return 0;
+        }
+        sink->wire.insert(sink->wire.end(), (const uint8_t *)data, (const uint8_t *)data + len);
+        return len;
+    }
+
+    static int on_send(void *user_data, const void *data, int len)
+    {
+        reinterpret_cast<HdlcQueueSink *>(user_data)->sent.push_back(data);
+        return 0;
+    }
+};
+
+TEST(HDLC, tx_queue_keeps_frames_order)
+{
+    HdlcQueueSink sink;
+    tiny_iovec_t queue[3];
+    uint8_t rx_buf[256];
+    hdlc_struct_t conf{};
+    conf.send_tx = HdlcQueueSink::write;
+    conf.on_frame_send = HdlcQueueSink::on_send;
+    conf.rx_buf = rx_buf;
+    conf.rx_buf_size = sizeof(rx_buf);
+    conf.crc_type = HDLC_CRC_OFF;
+    conf.user_data = &sink;
+    conf.tx_queue = queue;
+    conf.tx_queue_size = 3;
+    hdlc_handle_t handle = hdlc_init(&conf);
+    CHECK_TRUE(handle != nullptr);
+    const uint8_t frames[4][2] = {{0x01, 0x02}, {0x03, 0x04}, {0x05, 0x06}, {0x07, 0x08}};
+    sink.busy = true;
+    for ( int i = 0; i < 3; i++ )
+    {
+        CHECK_EQUAL(TINY_SUCCESS, hdlc_send(handle, frames[i], sizeof(frames[i]), 0));
+    }
+    CHECK_EQUAL(TINY_ERR_BUSY, hdlc_send(handle, frames[3], sizeof(frames[3]), 0));
+    sink.busy = false;
+    while ( hdlc_run_tx(handle) > 0 )
+    {
+    }
+    CHECK_EQUAL(3, (int)sink.sent.size());
+    for ( int i = 0; i < 3; i++ )
+    {
+        CHECK_EQUAL((const void *)frames[i], sink.sent[i]);
+    }
+    const uint8_t wire[] = {0x7E, 0x01, 0x02, 0x7E, 0x7E, 0x03, 0x04, 0x7E, 0x7E, 0x05, 0x06, 0x7E};
+    CHECK_EQUAL(sizeof(wire), sink.wire.size());
+    MEMCMP_EQUAL(wire, sink.wire.data(), sizeof(wire));
+    // Blocking send waits only for own frame
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_send(handle, frames[3], sizeof(frames[3]), 100));
+    CHECK_EQUAL(4, (int)sink.sent.size());
+    hdlc_close(handle);
+}
+
+struct HdlcBlockSink
+{
+    std::vector<uint8_t> wire;
+    int calls = 0;
+    int limit = 0; // maximum bytes accepted by single call
+
+    static int write(void *user_data, const void *data, int len)
+    {
+        HdlcBlockSink *sink = reinterpret_cast<HdlcBlockSink *>(user_data);
+        sink->calls++;
+        len = len < sink->limit ? len : sink->limit;
+        sink->wire.insert(sink->wire.end(), (const uint8_t *)data, (const uint8_t *)data + len);
+        return len;
+    }
+};
+
+TEST(HDLC, run_tx_writes_blocks_with_carry_over)
+{
+    HdlcBlockSink sink;
+    uint8_t rx_buf[256];
+    uint8_t tx_buf[32];
+    hdlc_struct_t conf{};
+    conf.send_tx = HdlcBlockSink::write;
+    conf.rx_buf = rx_buf;
+    conf.rx_buf_size = sizeof(rx_buf);
+    conf.crc_type = HDLC_CRC_OFF;
+    conf.user_data = &sink;
+    conf.tx_buf = tx_buf;
+    conf.tx_buf_size = sizeof(tx_buf);
+    hdlc_handle_t handle = hdlc_init(&conf);
+    const uint8_t frame[] = {0x01, 0x7E, 0x02, 0x7D, 0x03};
+    const uint8_t wire[] = {0x7E, 0x01, 0x7D, 0x5E, 0x02, 0x7D, 0x5D, 0x03, 0x7E};
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_send(handle, frame, sizeof(frame), 0));
+    // Whole frame is passed to send_tx() by single call
+    sink.limit = 1024;
+    CHECK_EQUAL(sizeof(wire), hdlc_run_tx(handle));
+    CHECK_EQUAL(1, sink.calls);
+    MEMCMP_EQUAL(wire, sink.wire.data(), sizeof(wire));
+
+    // Hw accepts only part of the block, nothing must be lost
+    sink.wire.clear();
+    sink.limit = 4;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_send(handle, frame, sizeof(frame), 0));
+    CHECK_EQUAL(sizeof(wire), hdlc_run_tx(handle));
+    sink.limit = 0;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_send(handle, frame, sizeof(frame), 0));
+    CHECK_EQUAL(0, hdlc_run_tx(handle));
+    sink.limit = 3;
+    while ( hdlc_run_tx(handle) > 0 )
+    {
+    }
+    CHECK_EQUAL(2 * sizeof(wire), sink.wire.size());
+    MEMCMP_EQUAL(wire, sink.wire.data(), sizeof(wire));
+    MEMCMP_EQUAL(wire, sink.wire.data() + sizeof(wire), sizeof(wire));
+    hdlc_close(handle);
+}
+
+TEST(HDLC, hdlc_ll_stats)
+{
+    uint8_t buffer[256];
+    hdlc_ll_init_t init{};
+    init.buf = buffer;
+    init.buf_size = sizeof(buffer);
+    init.crc_type = HDLC_CRC_8;
+    init.mtu = 4;
+    hdlc_ll_handle_t handle;
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_init(&handle, &init));
+    int error;
+    // Garbage between frames is counted once, fill bytes are ignored
+    const uint8_t garbage[] = {0x11, 0x22, 0x33, 0xFF};
+    CHECK_EQUAL(sizeof(garbage), hdlc_ll_run_rx(handle, garbage, sizeof(garbage), &error));
+    const uint8_t good[] = {0x7E, 0x01, 0x02, 0xFC, 0x7E};
+    hdlc_ll_run_rx(handle, good, sizeof(good), &error);
+    CHECK_EQUAL(TINY_SUCCESS, error);
+    const uint8_t wrong_crc[] = {0x7E, 0x01, 0x02, 0x03, 0x7E};
+    hdlc_ll_run_rx(handle, wrong_crc, sizeof(wrong_crc), &error);
+    CHECK_EQUAL(TINY_ERR_WRONG_CRC, error);
+    const uint8_t too_long[] = {0x7E, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x7E};
+    hdlc_ll_run_rx(handle, too_long, sizeof(too_long), &error);
+    CHECK_EQUAL(TINY_ERR_DATA_TOO_LARGE, error);
+    uint8_t tx[16];
+    CHECK_EQUAL(TINY_SUCCESS, hdlc_ll_put(handle, good + 1, 2));
+    CHECK_EQUAL(5, hdlc_ll_run_tx(handle, tx, sizeof(tx)));
+    hdlc_ll_stats_t stats;
+    hdlc_ll_get_stats(handle, &stats);
+    CHECK_EQUAL(1, stats.frames_sent);
+    CHECK_EQUAL(1, stats.frames_received);
+    CHECK_EQUAL(1, stats.crc_errors);
+    CHECK_EQUAL(1, stats.framing_errors);
+    CHECK_EQUAL(1, stats.overflows);
+    hdlc_ll_close(handle);
+}
+
 TEST(HDLC, check_buf_size_calculations)
 {
     CHECK_EQUAL( sizeof(hdlc_ll_data_t) + 13 + TINY_ALIGN_STRUCT_VALUE, hdlc_ll_get_buf_size(10) );
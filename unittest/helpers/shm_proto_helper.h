@@ -0,0 +1,99 @@
+/*
+    Copyright 2020,2022 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#pragma once
+
+#include "TinyProtocol.h"
+
+#if defined(__linux__)
+
+#include "link/TinyShmLink.h"
+#include <unistd.h>
+#include <stdint.h>
+#include <string>
+
+/**
+ * Sender and receiver Proto objects, connected by shared memory links with 64 bytes mtu
+ * and window of 4 frames. Link name is unique for the test and the process.
+ * Protos are not started: tests configure them and call begin() or add them to the reactor.
+ */
+struct ShmProtoPair
+{
+    explicit ShmProtoPair(const std::string &test, bool multithread = true)
+        : name(test + "-" + std::to_string(getpid()))
+        , linkA(name.c_str())
+        , linkB(name.c_str())
+        , sender(multithread)
+        , receiver(multithread)
+    {
+        for ( auto link: {&linkA, &linkB} )
+        {
+            link->setMtu(64);
+            link->setWindow(4);
+        }
+        sender.setLink(linkA);
+        receiver.setLink(linkB);
+    }
+
+    ~ShmProtoPair()
+    {
+        sender.end();
+        receiver.end();
+    }
+
+    /** Gives all packets of the pair to the receiver */
+    void addRxPool()
+    {
+        for ( auto &packet: packets )
+        {
+            receiver.addRxPool(packet);
+        }
+    }
+
+    /** Sends count single-byte frames 0, 1, 2 ... and returns number of sent frames */
+    int send(int count, uint32_t timeout = 1000)
+    {
+        int sent = 0;
+        for ( int i = 0; i < count; i++ )
+        {
+            tinyproto::StaticPacket<16> packet;
+            packet.put(static_cast<uint8_t>(i));
+            sent += sender.send(packet, timeout) ? 1 : 0;
+        }
+        return sent;
+    }
+
+    std::string name;
+    tinyproto::ShmFdLink linkA;
+    tinyproto::ShmFdLink linkB;
+    tinyproto::Proto sender;
+    tinyproto::Proto receiver;
+    tinyproto::StaticPacket<64> packets[4];
+};
+
+#endif
@@ -28,6 +28,8 @@
 
 #include "tiny_fd_helper.h"
 #include <unistd.h>
+#include <string.h>
+#include <algorithm>
 
 TinyHelperFd::TinyHelperFd(FakeEndpoint *endpoint, int rxBufferSize,
                            const std::function<void(uint8_t address, uint8_t *, int)> &onRxFrameCb, int window_frames, int timeout)
@@ -200,3 +202,116 @@ TinyHelperFd::~TinyHelperFd()
     stop();
     tiny_fd_close(m_handle);
 }
+
+int TinyFdSide::writeWire(void *user_data, const void *buf, int len)
+{
+    TinyFdSide *side = reinterpret_cast<TinyFdSide *>(user_data);
+    side->ioCalls++;
+    side->wire.insert(side->wire.end(), (const uint8_t *)buf, (const uint8_t *)buf + len);
+    return len;
+}
+
+int TinyFdSide::readWire(void *user_data, void *buf, int len)
+{
+    TinyFdSide *side = reinterpret_cast<TinyFdSide *>(user_data);
+    TinyFdSide *src = side->peer;
+    side->ioCalls++;
+    int size = std::min<int>(len, src->wire.size() - src->wirePos);
+    memcpy(buf, src->wire.data() + src->wirePos, size);
+    src->wirePos += size;
+    return size;
+}
+
+TinyHelperFdPair::TinyHelperFdPair(int windowFrames, uint8_t channels, uint8_t urgentSlots, int ioChunkSize)
+{
+    side1.peer = &side2;
+    side2.peer = &side1;
+    tiny_fd_init_t init{};
+    init.on_read_cb = onRead<0>;
+    init.on_datagram_cb = onRead<TinyFdSide::DATAGRAM>;
+    init.on_complete_cb = onComplete;
+    init.window_frames = windowFrames;
+    init.send_timeout = 1000;
+    init.retries = 2;
+    init.mtu = 32;
+    init.channels = channels;
+    init.urgent_slots = urgentSlots;
+    init.io_chunk_size = ioChunkSize;
+    for ( TinyFdSide *side : {&side1, &side2} )
+    {
+        side->buffer.resize(2048);
+        init.buffer = side->buffer.data();
+        init.buffer_size = side->buffer.size();
+        init.pdata = side;
+        int result = tiny_fd_init(&side->handle, &init);
+        if ( result != TINY_SUCCESS )
+        {
+            side->handle = nullptr;
+            m_status = result;
+        }
+    }
+}
+
+TinyHelperFdPair::~TinyHelperFdPair()
+{
+    for ( TinyFdSide *side : {&side1, &side2} )
+    {
+        if ( side->handle )
+        {
+            tiny_fd_close(side->handle);
+        }
+    }
+}
+
+int TinyHelperFdPair::setChannel(uint8_t channel, uint8_t priority, uint8_t quota)
+{
+    static const on_frame_read_cb_t callbacks[] = {onRead<0>, onRead<1>, onRead<2>, onRead<3>};
+    tiny_fd_channel_init_t config{};
+    config.priority = priority;
+    config.quota = quota;
+    config.on_read_cb = channel < sizeof(callbacks) / sizeof(callbacks[0]) ? callbacks[channel] : nullptr;
+    int result = tiny_fd_set_channel(side1.handle, channel, &config);
+    if ( result == TINY_SUCCESS )
+    {
+        result = tiny_fd_set_channel(side2.handle, channel, &config);
+    }
+    return result;
+}
+
+bool TinyHelperFdPair::connect()
+{
+    for ( int i = 0; i < 10 && tiny_fd_get_status(side1.handle) != TINY_SUCCESS; i++ )
+    {
+        pump(1);
+    }
+    return tiny_fd_get_status(side1.handle) == TINY_SUCCESS;
+}
+
+void TinyHelperFdPair::pump(int rounds)
+{
+    while ( rounds-- )
+    {
+        pump(side1.handle, side2.handle);
+        pump(side2.handle, side1.handle);
+    }
+}
+
+void TinyHelperFdPair::pump(tiny_fd_handle_t src, tiny_fd_handle_t dst)
+{
+    uint8_t buf[16];
+    int len;
+    while ( (len = tiny_fd_get_tx_data(src, buf, sizeof(buf), 0)) > 0 )
+    {
+        tiny_fd_on_rx_data(dst, buf, len);
+    }
+}
+
+template <int CHANNEL> void TinyHelperFdPair::onRead(void *user_data, uint8_t address, uint8_t *buf, int len)
+{
+    reinterpret_cast<TinyFdSide *>(user_data)->frames.push_back({CHANNEL, std::string((char *)buf, len)});
+}
+
+void TinyHelperFdPair::onComplete(void *user_data, uint8_t address, int ticket, int result)
+{
+    reinterpret_cast<TinyFdSide *>(user_data)->completions.push_back({ticket, result});
+}
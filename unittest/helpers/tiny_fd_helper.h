@@ -33,6 +33,8 @@
 #include <stdint.h>
 #include <thread>
 #include <atomic>
+#include <string>
+#include <vector>
 #include "proto/fd/tiny_fd.h"
 #include "fake_endpoint.h"
 
@@ -65,6 +67,10 @@ public:
     {
         tiny_fd_set_ka_timeout(m_handle, timeout);
     }
+    int get_stats(tiny_fd_stats_t *stats, uint8_t address = TINY_FD_PRIMARY_ADDR)
+    {
+        return tiny_fd_get_stats(m_handle, address, stats);
+    }
     using IBaseHelper<TinyHelperFd>::run;
 
     void wait_until_rx_count(int count, uint32_t timeout);
@@ -100,3 +106,64 @@ private:
     static void onConnect(void *handle, uint8_t addr, bool connected);
     static void MessageSender(TinyHelperFd *helper, int count, std::string message);
 };
+
+/**
+ * Single side of TinyHelperFdPair. It records everything, received from the peer.
+ */
+struct TinyFdSide
+{
+    static constexpr int DATAGRAM = -1; ///< channel number, recorded for datagrams
+
+    tiny_fd_handle_t handle = nullptr;
+    std::vector<uint8_t> buffer;
+    std::vector<std::pair<int, std::string>> frames; ///< channel and payload of received frames
+    std::vector<std::pair<int, int>> completions;    ///< ticket and result of sent frames
+    std::vector<uint8_t> wire;                       ///< bytes, written by tiny_fd_run_tx()
+    size_t wirePos = 0;                              ///< bytes, already read by the peer
+    int ioCalls = 0;                                 ///< calls of writeWire() and readWire()
+    TinyFdSide *peer = nullptr;
+
+    /** Write callback for tiny_fd_run_tx(), user_data is the side */
+    static int writeWire(void *user_data, const void *buf, int len);
+
+    /** Read callback for tiny_fd_run_rx(), user_data is the side */
+    static int readWire(void *user_data, void *buf, int len);
+};
+
+/**
+ * Two FD endpoints in ABM mode, which exchange data in the caller thread without fake wire.
+ * Both sides use 32 bytes mtu, 1000 ms send timeout and 2 retries.
+ */
+class TinyHelperFdPair
+{
+public:
+    TinyHelperFdPair(int windowFrames, uint8_t channels = 1, uint8_t urgentSlots = 0, int ioChunkSize = 0);
+    ~TinyHelperFdPair();
+
+    /** Returns result of tiny_fd_init() for both sides */
+    int status() const
+    {
+        return m_status;
+    }
+
+    /** Sets the same logical channel on both sides. Frames are recorded with the channel number */
+    int setChannel(uint8_t channel, uint8_t priority, uint8_t quota);
+
+    /** Exchanges data until the first side is connected */
+    bool connect();
+
+    /** Exchanges data in both directions */
+    void pump(int rounds = 10);
+
+    /** Moves data from src to dst */
+    static void pump(tiny_fd_handle_t src, tiny_fd_handle_t dst);
+
+    TinyFdSide side1;
+    TinyFdSide side2;
+
+private:
+    int m_status = TINY_SUCCESS;
+
+    template <int CHANNEL> static void onRead(void *user_data, uint8_t address, uint8_t *buf, int len);
+    static void onComplete(void *user_data, uint8_t address, int ticket, int result);
+};
@@ -0,0 +1,168 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#if defined(__linux__)
+
+#include <CppUTest/TestHarness.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include <string>
+#include "link/TinyIoEngine.h"
+#include "proto/fd/tiny_fd.h"
+
+TEST_GROUP(IO_ENGINE){void setup(){
+    // ...
+}
+
+                void teardown(){
+                    // ...
+                }};
+
+static void on_engine_read(void *user_data, uint8_t address, uint8_t *buf, int len)
+{
+    reinterpret_cast<std::vector<std::string> *>(user_data)->push_back(std::string((char *)buf, len));
+}
+
+static void check_engine_transfer(bool useUring)
+{
+    int fds[2];
+    CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    std::vector<std::string> rx1, rx2;
+    std::vector<uint8_t> buffer1(2048), buffer2(2048);
+    tiny_fd_handle_t handle1, handle2;
+    tiny_fd_init_t init{};
+    init.on_read_cb = on_engine_read;
+    init.window_frames = 4;
+    init.send_timeout = 1000;
+    init.retries = 2;
+    init.mtu = 64;
+    init.buffer_size = buffer1.size();
+    init.buffer = buffer1.data();
+    init.pdata = &rx1;
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_init(&handle1, &init));
+    init.buffer = buffer2.data();
+    init.pdata = &rx2;
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_init(&handle2, &init));
+
+    tinyproto::IoEngine engine(4, 64);
+    CHECK_TRUE(engine.begin(useUring));
+    CHECK_TRUE(engine.addFdLink(fds[0], handle1) >= 0);
+    CHECK_TRUE(engine.addFdLink(fds[1], handle2) >= 0);
+    for ( int i = 0; i < 100 && (tiny_fd_get_status(handle1) != TINY_SUCCESS ||
+                                 tiny_fd_get_status(handle2) != TINY_SUCCESS); i++ )
+    {
+        CHECK_TRUE(engine.poll(10) >= 0);
+    }
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_get_status(handle1));
+
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet_to(handle1, TINY_FD_PRIMARY_ADDR, "ping", 4, 0));
+    CHECK_EQUAL(TINY_SUCCESS, tiny_fd_send_packet_to(handle2, TINY_FD_PRIMARY_ADDR, "pong", 4, 0));
+    for ( int i = 0; i < 100 && (rx1.empty() || rx2.empty()); i++ )
+    {
+        CHECK_TRUE(engine.poll(10) >= 0);
+    }
+    CHECK_EQUAL(1, (int)rx2.size());
+    STRCMP_EQUAL("ping", rx2[0].c_str());
+    CHECK_EQUAL(1, (int)rx1.size());
+    STRCMP_EQUAL("pong", rx1[0].c_str());
+
+    engine.end();
+    tiny_fd_close(handle1);
+    tiny_fd_close(handle2);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(IO_ENGINE, fd_links_over_uring)
+{
+    // Falls back to epoll automatically if io_uring is not permitted
+    check_engine_transfer(true);
+}
+
+TEST(IO_ENGINE, fd_links_over_epoll)
+{
+    check_engine_transfer(false);
+}
+
+static void on_raw_read(void *udata, const uint8_t *data, int len)
+{
+}
+
+static void on_link_down(void *udata)
+{
+    (*reinterpret_cast<int *>(udata))++;
+}
+
+static void check_engine_peer_close(bool useUring)
+{
+    int fds[2];
+    CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    int downCount = 0;
+    tinyproto::IoEngine engine(4, 64);
+    CHECK_TRUE(engine.begin(useUring));
+    int id = engine.addLink(fds[0], on_raw_read, nullptr, &downCount);
+    CHECK_TRUE(id >= 0);
+    engine.setDownCallback(id, on_link_down);
+    CHECK_EQUAL(0, engine.poll(10));
+    close(fds[1]);
+    for ( int i = 0; i < 10 && downCount == 0; i++ )
+    {
+        CHECK_TRUE(engine.poll(10) >= 0);
+    }
+    CHECK_EQUAL(1, downCount);
+    // Closed link must not wake up the engine anymore, every poll() waits for its timeout
+    auto start = std::chrono::steady_clock::now();
+    int calls = 0;
+    int events = 0;
+    while ( std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100) )
+    {
+        events += engine.poll(25);
+        calls++;
+    }
+    CHECK_EQUAL(0, events);
+    // Allow extra wakeups by signals, spinning engine makes thousands of calls
+    CHECK_TRUE(calls <= 8);
+    CHECK_EQUAL(1, downCount);
+    engine.removeLink(id);
+    engine.end();
+    close(fds[0]);
+}
+
+TEST(IO_ENGINE, peer_close_stops_polling_over_uring)
+{
+    check_engine_peer_close(true);
+}
+
+TEST(IO_ENGINE, peer_close_stops_polling_over_epoll)
+{
+    check_engine_peer_close(false);
+}
+
+#endif
@@ -33,6 +33,7 @@
 #include <string.h>
 #include "helpers/tiny_light_helper.h"
 #include "helpers/fake_connection.h"
+#include <vector>
 
 TEST_GROUP(LIGHT){void setup(){
     // ...
@@ -82,4 +83,66 @@ TEST(LIGHT, small_frames)
     CHECK_EQUAL('T', rxbuf[0]);
 }
 
+struct LightSink
+{
+    std::vector<uint8_t> data;
+    int calls = 0;
+    int limit = 1024; // number of bytes, sink accepts before it becomes busy
+
+    static int write(void *appdata, const void *buf, int length)
+    {
+        LightSink *sink = reinterpret_cast<LightSink *>(appdata);
+        int len = length < sink->limit ? length : sink->limit;
+        if ( len > 0 )
+        {
+            sink->calls++;
+            sink->data.insert(sink->data.end(), (const uint8_t *)buf, (const uint8_t *)buf + len);
+            sink->limit -= len;
+        }
+        return len;
+    }
+
+    static int read(void *appdata, void *buf, int length)
+    {
+        return 0;
+    }
+};
+
+TEST(LIGHT, frame_is_written_by_single_call)
+{
+    LightSink sink;
+    STinyLightData handle{};
+    uint8_t out[64];
+    handle.tx_buf = out;
+    handle.tx_buf_size = sizeof(out);
+    tiny_light_init(&handle, LightSink::write, LightSink::read, &sink);
+    uint8_t payload[] = "Light frame";
+    CHECK_EQUAL(sizeof(payload), tiny_light_send(&handle, payload, sizeof(payload)));
+    CHECK_EQUAL(1, sink.calls);
+    CHECK_EQUAL(0x7E, sink.data.front());
+    CHECK_EQUAL(0x7E, sink.data.back());
+    tiny_light_close(&handle);
+}
+
+TEST(LIGHT, put_does_not_wait_for_channel)
+{
+    LightSink reference;
+    STinyLightData handle{};
+    tiny_light_init(&handle, LightSink::write, LightSink::read, &reference);
+    uint8_t payload[] = {0x01, 0x7E, 0x02, 0x7D, 0x03};
+    CHECK_EQUAL(sizeof(payload), tiny_light_send(&handle, payload, sizeof(payload)));
+    tiny_light_close(&handle);
+
+    LightSink sink;
+    sink.limit = 3;
+    tiny_light_init(&handle, LightSink::write, LightSink::read, &sink);
+    CHECK_EQUAL(TINY_ERR_AGAIN, tiny_light_put(&handle, payload, sizeof(payload)));
+    CHECK_EQUAL(TINY_ERR_BUSY, tiny_light_put(&handle, payload, sizeof(payload)));
+    CHECK_EQUAL(TINY_ERR_AGAIN, tiny_light_run_tx(&handle));
+    sink.limit = 1024;
+    CHECK_EQUAL(TINY_SUCCESS, tiny_light_run_tx(&handle));
+    CHECK_TRUE(reference.data == sink.data);
+    tiny_light_close(&handle);
+}
+
 #endif
@@ -0,0 +1,278 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include <CppUTest/TestHarness.h>
+#include <stdint.h>
+#include <string.h>
+#include "TinyMessage.h"
+
+TEST_GROUP(MESSAGE){void setup(){
+    // ...
+}
+
+                    void teardown(){
+                        // ...
+                    }};
+
+struct Telemetry
+{
+    uint16_t sensor;
+    uint16_t flags;
+    float value;
+};
+
+/** Structure with padding, and fields are sent not in declaration order */
+struct Command
+{
+    uint8_t code;
+    uint32_t arg;
+    int16_t offsets[2];
+};
+
+using TelemetryMsg = tinyproto::Message<Telemetry, 0x10, &Telemetry::sensor, &Telemetry::flags, &Telemetry::value>;
+using CommandMsg = tinyproto::MessageEx<Command, uint16_t, 0x0201, &Command::arg, &Command::code, &Command::offsets>;
+
+/** Command with 1-byte ID, which can be dispatched together with telemetry */
+using ShortCommandMsg = tinyproto::Message<Command, 0x12, &Command::code, &Command::arg>;
+
+static_assert(TelemetryMsg::SIZE == 9, "Telemetry size must be known at compile time");
+static_assert(CommandMsg::SIZE == 2 + 4 + 1 + 4, "Command size must be known at compile time");
+
+TEST(MESSAGE, encode_matches_manual_layout)
+{
+    TelemetryMsg::Packet packet;
+    CHECK_TRUE(TelemetryMsg::encode(Telemetry{0x1234, 0x0001, 1.5f}, packet));
+    tinyproto::StaticPacket<16> expected;
+    expected.put((uint8_t)0x10);
+    expected.put((uint16_t)0x1234);
+    expected.put((uint16_t)0x0001);
+    expected.put(1.5f);
+    CHECK_EQUAL(expected.size(), packet.size());
+    MEMCMP_EQUAL(expected.data(), packet.data(), expected.size());
+    // No room for the second message
+    CHECK_FALSE(TelemetryMsg::encode(Telemetry{}, packet));
+
+    CommandMsg::Packet command;
+    CHECK_TRUE(CommandMsg::encode(Command{7, 0xAABBCCDD, {-1, 2}}, command));
+    const uint8_t layout[] = {0x01, 0x02, 0xDD, 0xCC, 0xBB, 0xAA, 7, 0xFF, 0xFF, 0x02, 0x00};
+    CHECK_EQUAL((int)sizeof(layout), command.size());
+    MEMCMP_EQUAL(layout, command.data(), sizeof(layout));
+}
+
+TEST(MESSAGE, decode_checks_message_id)
+{
+    tinyproto::StaticPacket<32> packet;
+    CHECK_TRUE(CommandMsg::encode(Command{7, 100, {-5, 5}}, packet));
+    CHECK_TRUE(TelemetryMsg::encode(Telemetry{1, 2, -0.25f}, packet));
+
+    Telemetry telemetry{};
+    CHECK_FALSE(TelemetryMsg::decode(packet, telemetry));
+    Command command{};
+    CHECK_TRUE(CommandMsg::decode(packet, command));
+    CHECK_EQUAL(7, command.code);
+    CHECK_EQUAL(100, command.arg);
+    CHECK_EQUAL(-5, command.offsets[0]);
+    CHECK_EQUAL(5, command.offsets[1]);
+    CHECK_TRUE(TelemetryMsg::decode(packet, telemetry));
+    CHECK_EQUAL(2, telemetry.flags);
+    CHECK_EQUAL(-0.25f, telemetry.value);
+    CHECK_EQUAL(0, (int)packet.availableBytes());
+    // Truncated message is not decoded
+    CHECK_FALSE(TelemetryMsg::decode(packet, telemetry));
+}
+
+struct FakeProto
+{
+    bool send(const tinyproto::IPacket &packet, uint32_t)
+    {
+        memcpy(last.data(), packet.data(), packet.size());
+        last.clear();
+        last.allocate(packet.size());
+        return true;
+    }
+
+    tinyproto::StaticPacket<32> last;
+};
+
+TEST(MESSAGE, message_set_dispatches_by_id)
+{
+    FakeProto proto;
+    struct Handler
+    {
+        void operator()(const Telemetry &msg)
+        {
+            telemetry = msg.sensor;
+        }
+        void operator()(const Command &msg)
+        {
+            command = msg.code;
+        }
+        int telemetry = 0;
+        int command = 0;
+    } handler;
+    using Messages = tinyproto::MessageSet<TelemetryMsg, ShortCommandMsg>;
+    static_assert(Messages::RANGE == 3, "Jump table must cover IDs 0x10 - 0x12");
+
+    CHECK_TRUE(tinyproto::sendMessage<ShortCommandMsg>(proto, Command{9, 0, {}}, 100));
+    CHECK_TRUE(Messages::dispatch(proto.last, handler));
+    CHECK_EQUAL(9, handler.command);
+    CHECK_TRUE(tinyproto::sendMessage<TelemetryMsg>(proto, Telemetry{3, 0, 0}, 100));
+    CHECK_TRUE(Messages::dispatch(proto.last, handler));
+    CHECK_EQUAL(3, handler.telemetry);
+
+    tinyproto::StaticPacket<16> unknown;
+    unknown.put((uint8_t)0x55);
+    unknown.put((uint32_t)0);
+    CHECK_FALSE(Messages::dispatch(unknown, handler));
+}
+
+TEST(MESSAGE, message_set_rejects_unknown_id_in_range)
+{
+    using Messages = tinyproto::MessageSet<TelemetryMsg>;
+    static_assert(Messages::RANGE == 1, "Single message takes single table entry");
+    struct Handler
+    {
+        void operator()(const Telemetry &)
+        {
+            calls++;
+        }
+        int calls = 0;
+    } handler;
+    tinyproto::StaticPacket<16> packet;
+    packet.put((uint8_t)0x11);
+    packet.put((uint32_t)0);
+    packet.put((uint32_t)0);
+    CHECK_FALSE(Messages::dispatch(packet, handler));
+    CHECK_EQUAL(0, handler.calls);
+}
+
+struct DispatchLog
+{
+    int telemetry = 0;
+    int raw = 0;
+    int unknown = 0;
+    uint8_t rawByte = 0;
+};
+
+static void onTelemetry(void *userData, const Telemetry &msg)
+{
+    static_cast<DispatchLog *>(userData)->telemetry = msg.sensor;
+}
+
+static void onRaw(void *userData, tinyproto::IPacket &packet)
+{
+    DispatchLog *log = static_cast<DispatchLog *>(userData);
+    log->raw++;
+    log->rawByte = packet.getByte();
+}
+
+static void onUnknown(void *userData, tinyproto::IPacket &)
+{
+    static_cast<DispatchLog *>(userData)->unknown++;
+}
+
+TEST(MESSAGE, dispatcher_calls_registered_handlers)
+{
+    DispatchLog log;
+    tinyproto::MessageDispatcher<uint8_t, 32> dispatcher(0x08);
+    CHECK_TRUE(dispatcher.on<TelemetryMsg>(onTelemetry, &log));
+    CHECK_TRUE(dispatcher.on(0x20, onRaw, &log));
+    // Out of table range
+    CHECK_FALSE(dispatcher.on(0x28, onRaw, &log));
+    CHECK_FALSE(dispatcher.on(0x07, onRaw, &log));
+    dispatcher.setDefault(onUnknown, &log);
+
+    TelemetryMsg::Packet telemetry;
+    TelemetryMsg::encode(Telemetry{42, 0, 0}, telemetry);
+    CHECK_TRUE(dispatcher.dispatch(telemetry));
+    CHECK_EQUAL(42, log.telemetry);
+
+    tinyproto::StaticPacket<4> raw;
+    raw.put((uint8_t)0x20);
+    raw.put((uint8_t)0x77);
+    CHECK_TRUE(dispatcher.dispatch(raw));
+    CHECK_EQUAL(1, log.raw);
+    CHECK_EQUAL(0x77, log.rawByte);
+
+    tinyproto::StaticPacket<4> unknown;
+    unknown.put((uint8_t)0x30);
+    CHECK_FALSE(dispatcher.dispatch(unknown));
+    CHECK_TRUE(dispatcher.on(0x20, nullptr));
+    raw.clear();
+    raw.put((uint8_t)0x20);
+    CHECK_FALSE(dispatcher.dispatch(raw));
+    CHECK_EQUAL(2, log.unknown);
+    CHECK_EQUAL(1, log.raw);
+}
+
+struct UserDataProto
+{
+    void *getUserData() const
+    {
+        return userData;
+    }
+    void *userData = nullptr;
+};
+
+TEST(MESSAGE, dispatcher_serves_as_rx_callback)
+{
+    DispatchLog log;
+    tinyproto::MessageDispatcher<uint16_t, 4> dispatcher(0x0200);
+    static void (*onCommand)(void *, const Command &) = [](void *userData, const Command &msg) {
+        static_cast<DispatchLog *>(userData)->raw = msg.code;
+    };
+    CHECK_TRUE(dispatcher.on<CommandMsg>(onCommand, &log));
+    UserDataProto proto{&dispatcher};
+    void (*callback)(UserDataProto &, tinyproto::IPacket &) = tinyproto::MessageDispatcher<uint16_t, 4>::onRx;
+
+    CommandMsg::Packet packet;
+    CommandMsg::encode(Command{5, 0, {}}, packet);
+    callback(proto, packet);
+    CHECK_EQUAL(5, log.raw);
+}
+
+static tinyproto::MessageDispatcher<uint16_t, 4> s_fdDispatcher(0x0200);
+
+TEST(MESSAGE, dispatcher_serves_as_fd_receive_callback)
+{
+    DispatchLog log;
+    static void (*onCommand)(void *, const Command &) = [](void *userData, const Command &msg) {
+        static_cast<DispatchLog *>(userData)->raw = msg.code;
+    };
+    CHECK_TRUE(s_fdDispatcher.on<CommandMsg>(onCommand, &log));
+    // IFd user data are left for run_rx()/run_tx() callbacks
+    int ioUserData = 0;
+    void (*callback)(void *, uint8_t, tinyproto::IPacket &) =
+        tinyproto::MessageDispatcher<uint16_t, 4>::onReceiveFor<&s_fdDispatcher>;
+
+    CommandMsg::Packet packet;
+    CommandMsg::encode(Command{7, 0, {}}, packet);
+    callback(&ioUserData, 0, packet);
+    CHECK_EQUAL(7, log.raw);
+    CHECK_TRUE(s_fdDispatcher.on(0x0201, nullptr));
+}
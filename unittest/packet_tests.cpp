@@ -70,3 +70,61 @@ TEST(PACKET, packet_write)
     CHECK_EQUAL(0x12345678, packet.getUint32());
     CHECK_EQUAL(0x32, packet[4]);
 }
+
+TEST(PACKET, bulk_and_float_data)
+{
+    const uint8_t block[] = {1, 2, 3, 4, 5};
+    tinyproto::StaticPacket<20> packet;
+    CHECK_TRUE(packet.put(block, sizeof(block)));
+    CHECK_TRUE(packet.put(1.25f));
+    CHECK_TRUE(packet.put(-3.5));
+    CHECK_EQUAL(5 + 4 + (int)sizeof(double), packet.size());
+    // Float is little-endian IEEE 754: 1.25f is 0x3FA00000
+    CHECK_EQUAL(0x00, (uint8_t)packet.data()[5]);
+    CHECK_EQUAL(0x3F, (uint8_t)packet.data()[8]);
+    // Nothing is put, if the block doesn't fit
+    CHECK_FALSE(packet.put(block, sizeof(block)));
+    CHECK_FALSE(packet.put((uint32_t)1));
+    CHECK_EQUAL(5 + 4 + (int)sizeof(double), packet.size());
+
+    uint8_t out[5]{};
+    CHECK_TRUE(packet.get(out, sizeof(out)));
+    MEMCMP_EQUAL(block, out, sizeof(block));
+    CHECK_EQUAL(1.25f, packet.getFloat());
+    CHECK_EQUAL(-3.5, packet.getDouble());
+    CHECK_FALSE(packet.get(out, 1));
+    CHECK_EQUAL(0, packet.getUint32());
+}
+
+TEST(PACKET, varint_data)
+{
+    tinyproto::StaticPacket<64> packet;
+    CHECK_TRUE(packet.putVarint(0));
+    CHECK_TRUE(packet.putVarint(127));
+    CHECK_TRUE(packet.putVarint(300));
+    CHECK_TRUE(packet.putVarint(UINT64_MAX));
+    CHECK_TRUE(packet.putSignedVarint(-1));
+    CHECK_TRUE(packet.putSignedVarint(63));
+    CHECK_TRUE(packet.putSignedVarint(-65));
+    CHECK_TRUE(packet.putSignedVarint(INT64_MIN));
+    // 300 is encoded as 0xAC 0x02
+    CHECK_EQUAL(0xAC, (uint8_t)packet.data()[2]);
+    CHECK_EQUAL(0x02, (uint8_t)packet.data()[3]);
+    CHECK_EQUAL(1 + 1 + 2 + 10 + 1 + 1 + 2 + 10, packet.size());
+
+    CHECK_EQUAL(0, packet.getVarint());
+    CHECK_EQUAL(127, packet.getVarint());
+    CHECK_EQUAL(300, packet.getVarint());
+    CHECK_TRUE(UINT64_MAX == packet.getVarint());
+    CHECK_EQUAL(-1, packet.getSignedVarint());
+    CHECK_EQUAL(63, packet.getSignedVarint());
+    CHECK_EQUAL(-65, packet.getSignedVarint());
+    CHECK_TRUE(INT64_MIN == packet.getSignedVarint());
+    CHECK_EQUAL(0, (int)packet.availableBytes());
+
+    // Truncated varint is not read
+    tinyproto::StaticPacket<4> truncated;
+    truncated.put((uint8_t)0x80);
+    CHECK_EQUAL(0, truncated.getVarint());
+    CHECK_EQUAL(1, (int)truncated.availableBytes());
+}
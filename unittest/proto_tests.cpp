@@ -0,0 +1,153 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include <CppUTest/TestHarness.h>
+#include "TinyProtocol.h"
+#include "TinyProtoDispatcher.h"
+
+#if CONFIG_TINYHAL_THREAD_SUPPORT == 1 && defined(__linux__)
+
+#include "helpers/shm_proto_helper.h"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_GROUP(PROTO){void setup(){
+    // ...
+}
+
+                void teardown(){
+                    // ...
+                }};
+
+TEST(PROTO, rx_pool_is_limited_by_queue_size)
+{
+    tinyproto::Proto proto;
+    static tinyproto::StaticPacket<8> packets[tinyproto::PacketRing::CAPACITY + 1];
+    for ( unsigned i = 0; i < tinyproto::PacketRing::CAPACITY; i++ )
+    {
+        CHECK_TRUE(proto.addRxPool(packets[i]));
+    }
+    CHECK_FALSE(proto.addRxPool(packets[tinyproto::PacketRing::CAPACITY]));
+}
+
+TEST(PROTO, read_many_keeps_order)
+{
+    ShmProtoPair pair("proto-many");
+    pair.addRxPool();
+    CHECK_TRUE(pair.receiver.begin());
+    CHECK_TRUE(pair.sender.begin());
+    CHECK_EQUAL(3, pair.send(3));
+    int received = 0;
+    for ( int attempt = 0; attempt < 10 && received < 3; attempt++ )
+    {
+        tinyproto::IPacket *batch[4];
+        int count = pair.receiver.readMany(batch, 4, 500);
+        for ( int i = 0; i < count; i++ )
+        {
+            CHECK_EQUAL(received++, batch[i]->getByte());
+            pair.receiver.release(batch[i]);
+        }
+    }
+    CHECK_EQUAL(3, received);
+    CHECK_EQUAL(0, pair.receiver.getLostRxFrames());
+}
+
+TEST(PROTO, drop_oldest_keeps_latest_frames)
+{
+    ShmProtoPair pair("proto-oldest");
+    pair.receiver.addRxPool(pair.packets[0]);
+    pair.receiver.addRxPool(pair.packets[1]);
+    pair.receiver.setRxOverflow(tinyproto::RxOverflow::DROP_OLDEST);
+    CHECK_TRUE(pair.receiver.begin());
+    CHECK_TRUE(pair.sender.begin());
+    CHECK_EQUAL(4, pair.send(4));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    tinyproto::IPacket *batch[4];
+    CHECK_EQUAL(2, pair.receiver.readMany(batch, 4, 500));
+    CHECK_EQUAL(2, batch[0]->getByte());
+    CHECK_EQUAL(3, batch[1]->getByte());
+    CHECK_EQUAL(2, pair.receiver.getLostRxFrames());
+}
+
+TEST(PROTO, backpressure_does_not_lose_frames)
+{
+    ShmProtoPair pair("proto-backpressure");
+    pair.receiver.addRxPool(pair.packets[0]);
+    pair.receiver.setRxOverflow(tinyproto::RxOverflow::BACKPRESSURE);
+    CHECK_TRUE(pair.receiver.begin());
+    CHECK_TRUE(pair.sender.begin());
+    CHECK_EQUAL(3, pair.send(3));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    for ( int i = 0; i < 3; i++ )
+    {
+        tinyproto::IPacket *packet = pair.receiver.read(1000);
+        CHECK_TRUE(packet != nullptr);
+        CHECK_EQUAL(i, packet->getByte());
+        pair.receiver.release(packet);
+    }
+    CHECK_EQUAL(0, pair.receiver.getLostRxFrames());
+}
+
+static std::vector<int> s_dispatched;
+
+static void onSlowFrame(tinyproto::Proto &proto, tinyproto::IPacket &packet)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    s_dispatched.push_back(packet.getByte());
+}
+
+TEST(PROTO, dispatcher_backpressure_does_not_lose_frames)
+{
+    // Frames are sent faster, than slow handler processes them, so the strand queue overflows
+    const int frames = CONFIG_TINYPROTO_DISPATCHER_QUEUE_SIZE * 2;
+    ShmProtoPair pair("proto-dispatch");
+    pair.receiver.setRxOverflow(tinyproto::RxOverflow::BACKPRESSURE);
+    tinyproto::ProtoDispatcher dispatcher(1);
+    s_dispatched.clear();
+    dispatcher.attach(pair.receiver, onSlowFrame);
+    dispatcher.begin();
+    CHECK_TRUE(pair.receiver.begin());
+    CHECK_TRUE(pair.sender.begin());
+    CHECK_EQUAL(frames, pair.send(frames, 2000));
+    for ( int wait = 0; wait < 200 && dispatcher.getPending() > 0; wait++ )
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    pair.receiver.end();
+    dispatcher.end();
+    CHECK_EQUAL(0, pair.receiver.getLostRxFrames());
+    CHECK_EQUAL(frames, (int)s_dispatched.size());
+    for ( int i = 0; i < (int)s_dispatched.size(); i++ )
+    {
+        CHECK_EQUAL(i, s_dispatched[i]);
+    }
+}
+
+#endif
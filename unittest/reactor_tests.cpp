@@ -0,0 +1,218 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#include <CppUTest/TestHarness.h>
+#include "TinyProtoReactor.h"
+#include "TinyProtoDispatcher.h"
+
+#if CONFIG_TINYPROTO_REACTOR == 1
+
+#include "helpers/shm_proto_helper.h"
+#include "link/TinySocketLink.h"
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <vector>
+
+TEST_GROUP(REACTOR){void setup(){
+    // ...
+}
+
+                void teardown(){
+                    // ...
+                }};
+
+TEST(REACTOR, many_links_on_two_threads)
+{
+    const int count = 5;
+    std::vector<std::unique_ptr<ShmProtoPair>> pairs;
+    tinyproto::ProtoReactor reactor(2);
+    for ( int i = 0; i < count; i++ )
+    {
+        pairs.emplace_back(new ShmProtoPair("reactor-" + std::to_string(i), false));
+        pairs.back()->addRxPool();
+        CHECK_TRUE(reactor.add(pairs.back()->sender));
+        CHECK_TRUE(reactor.add(pairs.back()->receiver));
+    }
+    CHECK_TRUE(reactor.begin());
+    for ( int i = 0; i < count; i++ )
+    {
+        tinyproto::StaticPacket<16> packet;
+        packet.put(static_cast<uint8_t>(i));
+        CHECK_TRUE(pairs[i]->sender.send(packet, 2000));
+    }
+    for ( int i = 0; i < count; i++ )
+    {
+        tinyproto::IPacket *packet = pairs[i]->receiver.read(2000);
+        CHECK_TRUE(packet != nullptr);
+        CHECK_EQUAL(1, packet->size());
+        CHECK_EQUAL(i, packet->getByte());
+        pairs[i]->receiver.release(packet);
+    }
+    reactor.end();
+}
+
+static std::mutex s_dispatched_mutex;
+static std::vector<std::pair<tinyproto::Proto *, int>> s_dispatched;
+
+static void onDispatchedFrame(tinyproto::Proto &proto, tinyproto::IPacket &packet)
+{
+    // Slow handler must not block frames of other links
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    std::lock_guard<std::mutex> lock(s_dispatched_mutex);
+    s_dispatched.emplace_back(&proto, packet.getByte());
+}
+
+TEST(REACTOR, dispatcher_keeps_order_per_link)
+{
+    const int count = 3;
+    const int frames = 3;
+    std::vector<std::unique_ptr<ShmProtoPair>> pairs;
+    tinyproto::ProtoReactor reactor(1);
+    tinyproto::ProtoDispatcher dispatcher(2);
+    s_dispatched.clear();
+    for ( int i = 0; i < count; i++ )
+    {
+        pairs.emplace_back(new ShmProtoPair("dispatch-" + std::to_string(i), false));
+        pairs.back()->addRxPool();
+        dispatcher.attach(pairs.back()->receiver, onDispatchedFrame);
+        CHECK_TRUE(reactor.add(pairs.back()->sender));
+        CHECK_TRUE(reactor.add(pairs.back()->receiver));
+    }
+    dispatcher.begin();
+    CHECK_TRUE(reactor.begin());
+    for ( int n = 0; n < frames; n++ )
+    {
+        for ( int i = 0; i < count; i++ )
+        {
+            tinyproto::StaticPacket<16> packet;
+            packet.put(static_cast<uint8_t>(n));
+            CHECK_TRUE(pairs[i]->sender.send(packet, 2000));
+        }
+    }
+    for ( int wait = 0; wait < 200; wait++ )
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_dispatched_mutex);
+            if ( s_dispatched.size() == count * frames )
+            {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    reactor.end();
+    dispatcher.end();
+    CHECK_EQUAL(count * frames, (int)s_dispatched.size());
+    for ( int i = 0; i < count; i++ )
+    {
+        int expected = 0;
+        for ( auto &frame : s_dispatched )
+        {
+            if ( frame.first == &pairs[i]->receiver )
+            {
+                CHECK_EQUAL(expected, frame.second);
+                expected++;
+            }
+        }
+        CHECK_EQUAL(frames, expected);
+    }
+}
+
+TEST(REACTOR, backpressure_keeps_frames_in_link)
+{
+    const int frames = 4;
+    ShmProtoPair pair("backpressure", false);
+    // Single packet: the rest of frames, received in one chunk, must wait in the link
+    pair.receiver.addRxPool(pair.packets[0]);
+    pair.receiver.setRxOverflow(tinyproto::RxOverflow::BACKPRESSURE);
+    tinyproto::ProtoReactor reactor(1);
+    CHECK_TRUE(reactor.add(pair.sender));
+    CHECK_TRUE(reactor.add(pair.receiver));
+    CHECK_TRUE(reactor.begin());
+    CHECK_EQUAL(frames, pair.send(frames));
+    // Frames are accumulated by the link, while the receiver holds the only packet
+    tinyproto::IPacket *packet = pair.receiver.read(2000);
+    CHECK_TRUE(packet != nullptr);
+    CHECK_EQUAL(0, packet->getByte());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    pair.receiver.release(packet);
+    for ( int i = 1; i < frames; i++ )
+    {
+        packet = pair.receiver.read(2000);
+        CHECK_TRUE(packet != nullptr);
+        CHECK_EQUAL(i, packet->getByte());
+        pair.receiver.release(packet);
+    }
+    CHECK_EQUAL(0, pair.receiver.getLostRxFrames());
+    reactor.end();
+}
+
+TEST(REACTOR, hung_up_link_is_marked_down)
+{
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    CHECK_EQUAL(0, bind(server, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)));
+    CHECK_EQUAL(0, listen(server, 1));
+    CHECK_EQUAL(0, getsockname(server, reinterpret_cast<struct sockaddr *>(&addr), &len));
+    char address[64];
+    snprintf(address, sizeof(address), "127.0.0.1:%d", ntohs(addr.sin_port));
+
+    tinyproto::TcpFdLink link(address);
+    link.setMtu(64);
+    link.setWindow(4);
+    tinyproto::Proto proto(false);
+    tinyproto::StaticPacket<64> packet;
+    proto.setLink(link);
+    proto.addRxPool(packet);
+    tinyproto::ProtoReactor reactor(1);
+    CHECK_TRUE(reactor.add(proto));
+    int conn = accept(server, nullptr, nullptr);
+    CHECK_TRUE(conn >= 0);
+    CHECK_TRUE(reactor.begin());
+    CHECK_TRUE(link.isUp());
+    close(conn);
+    for ( int wait = 0; wait < 200 && link.isUp(); wait++ )
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK_FALSE(link.isUp());
+    reactor.end();
+    close(server);
+}
+
+#endif
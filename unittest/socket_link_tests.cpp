@@ -0,0 +1,150 @@
+/*
+    Copyright 2024 (C) Alexey Dynda
+
+    This file is part of Tiny Protocol Library.
+
+    GNU General Public License Usage
+
+    Protocol Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Protocol Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Protocol Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Commercial License Usage
+
+    Licensees holding valid commercial Tiny Protocol licenses may use this file in
+    accordance with the commercial license agreement provided in accordance with
+    the terms contained in a written agreement between you and Alexey Dynda.
+    For further information contact via email on github account.
+*/
+
+#if defined(__linux__)
+
+#include <CppUTest/TestHarness.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "link/TinySocketLink.h"
+
+TEST_GROUP(SOCKET_LINK){void setup(){
+    // ...
+}
+
+                void teardown(){
+                    // ...
+                }};
+
+static void on_link_read(void *user_data, uint8_t address, uint8_t *buf, int len)
+{
+    reinterpret_cast<std::vector<std::string> *>(user_data)->push_back(std::string((char *)buf, len));
+}
+
+TEST(SOCKET_LINK, udp_fd_link)
+{
+    int port = 20000 + getpid() % 20000;
+    char address1[64], address2[64];
+    snprintf(address1, sizeof(address1), "127.0.0.1:%d:%d", port + 1, port);
+    snprintf(address2, sizeof(address2), "127.0.0.1:%d:%d", port, port + 1);
+    std::vector<std::string> rx1, rx2;
+    tinyproto::UdpFdLink link1(address1), link2(address2);
+    link1.setMtu(64);
+    link2.setMtu(64);
+    link1.setTimeout(10);
+    link2.setTimeout(10);
+    CHECK_TRUE(link1.begin(on_link_read, nullptr, &rx1));
+    CHECK_TRUE(link2.begin(on_link_read, nullptr, &rx2));
+    char ping[] = "ping";
+    bool sent = false;
+    for ( int i = 0; i < 200 && rx2.empty(); i++ )
+    {
+        sent = sent || link1.put(ping, 4, 0);
+        link1.runTx();
+        link2.runRx();
+        link2.runTx();
+        link1.runRx();
+    }
+    CHECK_EQUAL(1, (int)rx2.size());
+    STRCMP_EQUAL("ping", rx2[0].c_str());
+    link1.end();
+    link2.end();
+}
+
+TEST(SOCKET_LINK, tcp_socket_roundtrip)
+{
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    CHECK_EQUAL(0, bind(server, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)));
+    CHECK_EQUAL(0, listen(server, 1));
+    CHECK_EQUAL(0, getsockname(server, reinterpret_cast<struct sockaddr *>(&addr), &len));
+    char address[64];
+    snprintf(address, sizeof(address), "127.0.0.1:%d", ntohs(addr.sin_port));
+
+    tinyproto::TcpSocket client(address);
+    client.setTimeout(100);
+    CHECK_TRUE(client.begin(0));
+    int conn = accept(server, nullptr, nullptr);
+    CHECK_TRUE(conn >= 0);
+    CHECK_EQUAL(5, client.write(reinterpret_cast<const uint8_t *>("hello"), 5));
+    char buf[16] = {};
+    CHECK_EQUAL(5, (int)read(conn, buf, sizeof(buf)));
+    STRCMP_EQUAL("hello", buf);
+    CHECK_EQUAL(3, (int)write(conn, "abc", 3));
+    uint8_t rx[16];
+    CHECK_EQUAL(3, client.readBytes(rx, sizeof(rx)));
+    CHECK_EQUAL(0, client.readBytes(rx, sizeof(rx)));
+    close(conn);
+    // Closed connection is reported as error
+    CHECK_EQUAL(-1, client.readBytes(rx, sizeof(rx)));
+    client.end();
+    close(server);
+}
+
+TEST(SOCKET_LINK, tcp_link_goes_down_on_peer_close)
+{
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    CHECK_EQUAL(0, bind(server, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)));
+    CHECK_EQUAL(0, listen(server, 1));
+    CHECK_EQUAL(0, getsockname(server, reinterpret_cast<struct sockaddr *>(&addr), &len));
+    char address[64];
+    snprintf(address, sizeof(address), "127.0.0.1:%d", ntohs(addr.sin_port));
+
+    std::vector<std::string> rx;
+    tinyproto::TcpFdLink link(address);
+    link.setMtu(64);
+    link.setTimeout(10);
+    CHECK_TRUE(link.begin(on_link_read, nullptr, &rx));
+    int conn = accept(server, nullptr, nullptr);
+    CHECK_TRUE(conn >= 0);
+    link.runRx();
+    CHECK_TRUE(link.isUp());
+    close(conn);
+    link.runRx();
+    CHECK_FALSE(link.isUp());
+    link.end();
+    // Restarted link is up again
+    CHECK_TRUE(link.begin(on_link_read, nullptr, &rx));
+    CHECK_TRUE(link.isUp());
+    link.end();
+    close(server);
+}
+
+#endif